@@ -0,0 +1,132 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "concurrent.h"
+
+namespace lib::lessdb
+{
+    /// Asynchronous front-end to LessDb. Available on POSIX systems only.
+    /// Reads and updates are submitted to a queue and performed by worker threads,
+    /// so that the submitting thread never waits for the storage. Each submission
+    /// returns a ticket. Completion is reported through optional callback, called
+    /// from the worker thread, or can be polled or waited for with the ticket.
+    /// Operations are distributed to workers by block, so operations on the same
+    /// block complete in the order in which they were submitted, while operations
+    /// on different blocks may complete in any order. Each worker takes all queued
+    /// operations at once, and updates which are overwritten by a later update of
+    /// the same parameter within that batch, without a read in between, aren't
+    /// written to the storage at all: last update is written in place of the first
+    /// one instead, so that all of them still complete in order.
+    /// With a single worker, any Hwa can be used, and all LessDb settings apply.
+    /// More than one worker is used only if Hwa supports concurrent access, in which
+    /// case the database is accessed through ConcurrentLessDb, which disables the
+    /// settings of the database that don't allow concurrent access, and they stay
+    /// disabled once AsyncLessDb is destroyed.
+    /// Wrapped database must not be accessed directly while operations are pending.
+    class AsyncLessDb
+    {
+        public:
+        using ticket_t = uint64_t;
+
+        /// Ticket returned when operation can't be submitted.
+        static constexpr ticket_t INVALID_TICKET = 0;
+
+        /// Result of completed operation.
+        struct Result
+        {
+            bool     success = false;    ///< Result of the read or update.
+            uint32_t value   = 0;        ///< Read value, or the value written by update.
+        };
+
+        using callback_t = std::function<void(ticket_t ticket, const Result& result)>;
+
+        AsyncLessDb(LessDb& db, size_t workers = 1);
+        ~AsyncLessDb();
+
+        AsyncLessDb(const AsyncLessDb&)            = delete;
+        AsyncLessDb& operator=(const AsyncLessDb&) = delete;
+
+        ticket_t submitRead(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, callback_t callback = nullptr);
+        ticket_t submitUpdate(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue, callback_t callback = nullptr);
+        bool     poll(ticket_t ticket, Result& result);
+        bool     wait(ticket_t ticket, Result& result);
+        void     drain();
+        size_t   pending() const;
+        size_t   workers() const;
+        uint32_t coalescedUpdates() const;
+
+        private:
+        enum class operation_t : uint8_t
+        {
+            READ,
+            UPDATE
+        };
+
+        struct Operation
+        {
+            ticket_t    ticket;
+            operation_t type;
+            size_t      blockIndex;
+            size_t      sectionIndex;
+            size_t      parameterIndex;
+            uint32_t    value;
+            callback_t  callback;
+        };
+
+        struct Worker
+        {
+            std::thread             thread;
+            std::mutex              mutex;
+            std::condition_variable condition;
+            std::deque<Operation>   queue;
+        };
+
+        LessDb&                                _db;
+        std::unique_ptr<ConcurrentLessDb>      _concurrent;
+        std::vector<std::unique_ptr<Worker>>   _workers;
+        std::atomic<bool>                      _stop           = false;
+        std::atomic<ticket_t>                  _nextTicket     = INVALID_TICKET + 1;
+        std::atomic<uint32_t>                  _coalesced      = 0;
+        mutable std::mutex                     _resultMutex;
+        std::condition_variable                _resultCondition;
+        std::unordered_map<ticket_t, Result>   _results        = {};
+        std::unordered_set<ticket_t>           _awaited        = {};
+        size_t                                 _pending        = 0;
+
+        ticket_t submit(Operation&& operation);
+        void     workerLoop(Worker& worker);
+        void     process(std::deque<Operation>& batch);
+        Result   execute(const Operation& operation);
+        void     complete(const Operation& operation, const Result& result);
+    };
+}    // namespace lib::lessdb
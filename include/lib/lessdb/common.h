@@ -47,6 +47,68 @@ namespace lib::lessdb
         virtual bool     clear()                                                              = 0;
         virtual bool     read(uint32_t address, uint32_t& value, sectionParameterType_t type) = 0;
         virtual bool     write(uint32_t address, uint32_t value, sectionParameterType_t type) = 0;
+
+        /// Range access treats the storage as plain bytes. Backends which are able to
+        /// transfer multiple bytes in a single transaction should override all three
+        /// range functions and store word and dword values in little-endian order.
+        /// Default implementations fall back to byte-by-byte access.
+        virtual bool rangeAccessSupported()
+        {
+            return false;
+        }
+
+        virtual bool readRange(uint32_t address, uint8_t* buffer, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                uint32_t value = 0;
+
+                if (!read(address + i, value, sectionParameterType_t::BYTE))
+                {
+                    return false;
+                }
+
+                buffer[i] = value;
+            }
+
+            return true;
+        }
+
+        virtual bool writeRange(uint32_t address, const uint8_t* buffer, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                if (!write(address + i, buffer[i], sectionParameterType_t::BYTE))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Backends which can be accessed from multiple threads at once, as long as
+        /// the threads access different addresses, should override this to return true.
+        virtual bool concurrentAccessSupported()
+        {
+            return false;
+        }
+
+        /// Returns free-running time in milliseconds, used for write combining deadline.
+        /// Value is allowed to wrap around. Backends on targets with a system tick
+        /// should override this, otherwise time doesn't advance and the deadline is
+        /// never reached.
+        virtual uint32_t milliseconds()
+        {
+            return 0;
+        }
+    };
+
+    /// Destination of checkpoints and images created by LessDb.
+    class DataSink
+    {
+        public:
+        virtual bool write(const uint8_t* data, size_t size) = 0;
     };
 
     enum class factoryResetType_t : uint8_t
@@ -67,6 +129,58 @@ namespace lib::lessdb
         DISABLE
     };
 
+    enum class shadowSetting_t : uint8_t
+    {
+        ENABLE,
+        DISABLE
+    };
+
+    enum class compareBeforeWriteSetting_t : uint8_t
+    {
+        ENABLE,
+        DISABLE
+    };
+
+    enum class headerSetting_t : uint8_t
+    {
+        ENABLE,
+        DISABLE
+    };
+
+    enum class lazyResetSetting_t : uint8_t
+    {
+        ENABLE,
+        DISABLE
+    };
+
+    enum class layoutStatus_t : uint8_t
+    {
+        UNKNOWN,            ///< Header isn't used or layout isn't set.
+        VALID,              ///< Stored header matches the active layout.
+        NEEDS_INIT,         ///< Storage holds no header, database has to be initialized.
+        NEEDS_MIGRATION,    ///< Stored header belongs to different layout or header format.
+    };
+
+    enum class checkpointType_t : uint8_t
+    {
+        FULL,           ///< Holds entire database.
+        INCREMENTAL,    ///< Holds only the data changed since previous checkpoint.
+    };
+
+    enum class initStatus_t : uint8_t
+    {
+        IN_PROGRESS,    ///< Part of the database has been initialized, more steps are needed.
+        DONE,           ///< Initialization is complete.
+        FAILED,         ///< Initialization failed or hasn't been started.
+    };
+
+    enum class verifyPolicy_t : uint8_t
+    {
+        ALWAYS,      ///< Every write is read back and compared immediately.
+        NEVER,       ///< Written values aren't verified.
+        DEFERRED,    ///< Single-value writes are verified on request, initialization and flush once complete, other range writes immediately.
+    };
+
     class Section
     {
         public:
@@ -105,7 +219,6 @@ namespace lib::lessdb
         const autoIncrementSetting_t AUTO_INCREMENT;
         const uint32_t               DEFAULT_VALUE;
         const std::vector<uint32_t>  DEFAULT_VALUES;
-        uint32_t                     _address = 0;
     };
 
     class Block
@@ -119,6 +232,5 @@ namespace lib::lessdb
         friend class LessDb;
 
         std::vector<Section>& _sections;
-        uint32_t              _address = 0;
     };
 }    // namespace lib::lessdb
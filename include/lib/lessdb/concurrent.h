@@ -0,0 +1,134 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include "lessdb.h"
+
+namespace lib::lessdb
+{
+    /// Thread-safe access to LessDb. Available on POSIX systems only.
+    /// Reads of all blocks proceed in parallel, while updates lock only the
+    /// stripe to which the block is mapped, so that updates in different blocks
+    /// don't contend. Operations which affect the entire database (layout,
+    /// initialization, settings) lock all blocks.
+    /// Each thread keeps its own cache of read values, validated against
+    /// per-stripe generation counters, so that cache hits require no locking.
+    /// Since LessDb itself isn't thread-safe, its read cache and compare-before-write
+    /// are disabled (the latter is done here instead), RAM shadow and checkpoint
+    /// change tracking are disabled and deferred verification is replaced with
+    /// immediate one. If any of these settings is changed through exclusive(), it's
+    /// brought back once the function returns. Hwa must support concurrent access
+    /// to different addresses.
+    class ConcurrentLessDb
+    {
+        public:
+        ConcurrentLessDb(LessDb& db);
+
+        bool     setLayout(std::vector<Block>& layout, uint32_t startAddress = 0);
+        bool     initData(factoryResetType_t type = factoryResetType_t::FULL);
+        bool     clear();
+        bool     read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t& value);
+        uint32_t read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex);
+        bool     update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue);
+        void     setCompareBeforeWrite(compareBeforeWriteSetting_t setting);
+        uint32_t skippedWrites() const;
+        uint32_t cacheHits() const;
+        uint32_t cacheMisses() const;
+
+        /// Runs specified function with exclusive access to the database.
+        /// Settings which don't allow concurrent access are reverted once function returns.
+        /// param [in] function     Function accepting reference to LessDb.
+        /// returns: Value returned by specified function.
+        template<typename Function>
+        auto exclusive(Function&& function)
+        {
+            std::unique_lock<std::shared_mutex> lock(_databaseMutex);
+            InvalidateGuard                     guard(_databaseGeneration);
+            SettingsGuard                       settingsGuard(*this);
+
+            return function(_db);
+        }
+
+        private:
+        /// Number of locks to which blocks are mapped.
+        static constexpr size_t STRIPES = 16;
+
+        /// Increments generation counter once the scope ends, invalidating all cached values.
+        class InvalidateGuard
+        {
+            public:
+            InvalidateGuard(std::atomic<uint32_t>& generation)
+                : _generation(generation)
+            {}
+
+            ~InvalidateGuard()
+            {
+                _generation.fetch_add(1, std::memory_order_release);
+            }
+
+            private:
+            std::atomic<uint32_t>& _generation;
+        };
+
+        /// Reverts the settings of the database which don't allow concurrent access once the scope ends.
+        class SettingsGuard
+        {
+            public:
+            SettingsGuard(ConcurrentLessDb& concurrentDb)
+                : _concurrentDb(concurrentDb)
+            {}
+
+            ~SettingsGuard()
+            {
+                _concurrentDb.applySettings();
+            }
+
+            private:
+            ConcurrentLessDb& _concurrentDb;
+        };
+
+        struct Stripe
+        {
+            std::shared_mutex     mutex;
+            std::atomic<uint32_t> generation = 0;
+        };
+
+        LessDb&                       _db;
+        const uint32_t                INSTANCE;
+        std::shared_mutex             _databaseMutex;
+        std::atomic<uint32_t>         _databaseGeneration = 0;
+        std::array<Stripe, STRIPES>   _stripes;
+        std::atomic<bool>             _compareBeforeWrite = true;
+        std::atomic<uint32_t>         _skippedWrites      = 0;
+        std::atomic<uint32_t>         _cacheHits          = 0;
+        std::atomic<uint32_t>         _cacheMisses        = 0;
+        static std::atomic<uint32_t>  _instanceCounter;
+
+        Stripe& stripe(size_t blockIndex);
+        void    applySettings();
+    };
+}    // namespace lib::lessdb
@@ -0,0 +1,351 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#if __cplusplus < 202002L
+#error "coroutine.h requires C++20"
+#endif
+
+#include <algorithm>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "lessdb.h"
+
+namespace lib::lessdb
+{
+    template<typename T>
+    struct TaskResult
+    {
+        std::optional<T> value = {};
+
+        void return_value(T result)
+        {
+            value = std::move(result);
+        }
+    };
+
+    template<>
+    struct TaskResult<void>
+    {
+        void return_void()
+        {}
+    };
+
+    /// Lazily started coroutine returning value of type T.
+    /// Task starts once it's awaited or spawned on Executor,
+    /// and resumes the awaiting coroutine once it's done.
+    template<typename T>
+    class Task
+    {
+        public:
+        struct promise_type : TaskResult<T>
+        {
+            std::coroutine_handle<> continuation = nullptr;
+
+            Task get_return_object()
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            auto final_suspend() noexcept
+            {
+                struct FinalAwaiter
+                {
+                    bool await_ready() noexcept
+                    {
+                        return false;
+                    }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        auto continuation = handle.promise().continuation;
+                        return continuation ? continuation : std::noop_coroutine();
+                    }
+
+                    void await_resume() noexcept
+                    {}
+                };
+
+                return FinalAwaiter{};
+            }
+
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+
+        Task(Task&& other) noexcept
+            : _handle(std::exchange(other._handle, nullptr))
+        {}
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy();
+                _handle = std::exchange(other._handle, nullptr);
+            }
+
+            return *this;
+        }
+
+        Task(const Task&)            = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task()
+        {
+            destroy();
+        }
+
+        bool done() const
+        {
+            return !_handle || _handle.done();
+        }
+
+        bool await_ready() const
+        {
+            return done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+        {
+            _handle.promise().continuation = awaiting;
+            return _handle;
+        }
+
+        T await_resume()
+        {
+            if constexpr (!std::is_void_v<T>)
+            {
+                return std::move(*_handle.promise().value);
+            }
+        }
+
+        private:
+        friend class Executor;
+
+        explicit Task(std::coroutine_handle<promise_type> handle)
+            : _handle(handle)
+        {}
+
+        void destroy()
+        {
+            if (_handle)
+            {
+                _handle.destroy();
+                _handle = nullptr;
+            }
+        }
+
+        std::coroutine_handle<promise_type> _handle = nullptr;
+    };
+
+    /// Single-threaded executor which runs coroutines in turns. Coroutine gives
+    /// up its turn whenever it awaits a database operation or Executor::yield().
+    class Executor
+    {
+        public:
+        /// Suspends the coroutine until its next turn.
+        class Yield
+        {
+            public:
+            Yield(Executor& executor)
+                : _executor(executor)
+            {}
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                _executor.schedule(handle);
+            }
+
+            void await_resume() const noexcept
+            {}
+
+            private:
+            Executor& _executor;
+        };
+
+        Executor() = default;
+
+        Executor(const Executor&)            = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        /// Takes ownership of the task and schedules it to start.
+        void spawn(Task<void>&& task)
+        {
+            schedule(task._handle);
+            _tasks.push_back(std::move(task));
+        }
+
+        void schedule(std::coroutine_handle<> handle)
+        {
+            _ready.push_back(handle);
+        }
+
+        Yield yield()
+        {
+            return Yield(*this);
+        }
+
+        /// Resumes the next coroutine waiting for its turn.
+        /// returns: False if no coroutine is waiting, true otherwise.
+        bool runOne()
+        {
+            if (_ready.empty())
+            {
+                return false;
+            }
+
+            auto handle = _ready.front();
+
+            _ready.pop_front();
+            handle.resume();
+            return true;
+        }
+
+        /// Runs coroutines until none of them is waiting for its turn,
+        /// and releases the tasks which are done.
+        void run()
+        {
+            while (runOne())
+            {
+            }
+
+            _tasks.erase(std::remove_if(_tasks.begin(), _tasks.end(), [](const Task<void>& task)
+                                        {
+                                            return task.done();
+                                        }),
+                         _tasks.end());
+        }
+
+        /// Returns the number of spawned tasks which aren't done yet.
+        size_t active() const
+        {
+            return std::count_if(_tasks.begin(), _tasks.end(), [](const Task<void>& task)
+                                 {
+                                     return !task.done();
+                                 });
+        }
+
+        private:
+        std::deque<std::coroutine_handle<>> _ready = {};
+        std::vector<Task<void>>             _tasks = {};
+    };
+
+    /// Awaitable database operations for coroutines run by Executor. Storage access is
+    /// synchronous, so each operation suspends the coroutine and is performed in its
+    /// next turn, letting other coroutines run first. Initialization is performed in
+    /// steps of limited size, with other coroutines running between the steps.
+    /// Operations started during initialization wait until it's done.
+    class CoLessDb
+    {
+        public:
+        /// Default number of bytes written in single initialization step.
+        static constexpr uint32_t DEFAULT_INIT_STEP_SIZE = 1024;
+
+        CoLessDb(LessDb& db, Executor& executor, uint32_t initStepSize = DEFAULT_INIT_STEP_SIZE)
+            : _db(db)
+            , _executor(executor)
+            , _initStepSize(initStepSize)
+        {}
+
+        /// returns: Value of specified parameter, or no value if reading fails.
+        Task<std::optional<uint32_t>> read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+        {
+            uint32_t value = 0;
+
+            co_await turn();
+
+            if (!_db.read(blockIndex, sectionIndex, parameterIndex, value))
+            {
+                co_return std::nullopt;
+            }
+
+            co_return value;
+        }
+
+        Task<bool> update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue)
+        {
+            co_await turn();
+            co_return _db.update(blockIndex, sectionIndex, parameterIndex, newValue);
+        }
+
+        Task<bool> readSection(size_t blockIndex, size_t sectionIndex, uint32_t* values, size_t size)
+        {
+            co_await turn();
+            co_return _db.readSection(blockIndex, sectionIndex, values, size);
+        }
+
+        Task<bool> initData(factoryResetType_t type = factoryResetType_t::FULL)
+        {
+            co_await turn();
+
+            if (!_db.startInitData(type))
+            {
+                co_return false;
+            }
+
+            while (true)
+            {
+                const initStatus_t STATUS = _db.continueInitData(_initStepSize);
+
+                if (STATUS != initStatus_t::IN_PROGRESS)
+                {
+                    co_return STATUS == initStatus_t::DONE;
+                }
+
+                co_await _executor.yield();
+            }
+        }
+
+        private:
+        /// Waits for the next turn in which no initialization is in progress,
+        /// so that operations don't see or overwrite partially initialized data.
+        Task<void> turn()
+        {
+            do
+            {
+                co_await _executor.yield();
+            } while (_db.initInProgress());
+        }
+
+        LessDb&        _db;
+        Executor&      _executor;
+        const uint32_t _initStepSize;
+    };
+}    // namespace lib::lessdb
@@ -0,0 +1,136 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "common.h"
+
+namespace lib::lessdb
+{
+    /// Interface to flash memory divided into erasable pages.
+    /// Erased bytes read as 0xFF. Programming can only clear bits,
+    /// so each byte can be programmed once after the page is erased.
+    class FlashPages
+    {
+        public:
+        virtual size_t pageSize()                                                           = 0;
+        virtual size_t numberOfPages()                                                      = 0;
+        virtual bool   erasePage(size_t page)                                               = 0;
+        virtual bool   program(size_t page, size_t offset, const uint8_t* data, size_t size) = 0;
+        virtual bool   read(size_t page, size_t offset, uint8_t* data, size_t size)          = 0;
+    };
+
+    /// Flash pages simulated in RAM, used to run the flash backend on host.
+    /// Programming already programmed bits fails, same as on real flash.
+    class RamFlashPages : public FlashPages
+    {
+        public:
+        RamFlashPages(size_t pageSize, size_t numberOfPages)
+            : PAGE_SIZE(pageSize)
+            , NUMBER_OF_PAGES(numberOfPages)
+            , _memory(pageSize * numberOfPages, 0xFF)
+            , _eraseCount(numberOfPages, 0)
+        {}
+
+        size_t   pageSize() override;
+        size_t   numberOfPages() override;
+        bool     erasePage(size_t page) override;
+        bool     program(size_t page, size_t offset, const uint8_t* data, size_t size) override;
+        bool     read(size_t page, size_t offset, uint8_t* data, size_t size) override;
+        uint32_t eraseCount(size_t page) const;
+
+        private:
+        const size_t          PAGE_SIZE;
+        const size_t          NUMBER_OF_PAGES;
+        std::vector<uint8_t>  _memory;
+        std::vector<uint32_t> _eraseCount;
+    };
+
+    /// Storage which emulates byte-addressable memory on flash pages.
+    /// Each write appends a record holding address, up to four bytes of data and
+    /// their checksum to the current page, so updates never erase flash. Records
+    /// which fail the checksum, since power was lost while they were programmed,
+    /// are ignored. RAM index holds the location of the latest record for each
+    /// address. Pages are used as a ring: once only one erased page is left, live
+    /// data from the oldest page is compacted into it and the oldest page is erased,
+    /// which spreads erase cycles evenly across all pages. Bytes which were never
+    /// written read as 0. Storage size is limited to 4 MiB.
+    class HwaFlash : public Hwa
+    {
+        public:
+        HwaFlash(FlashPages& pages, uint32_t size)
+            : _pages(pages)
+            , SIZE(size)
+        {}
+
+        bool     init() override;
+        uint32_t size() override;
+        bool     clear() override;
+        bool     read(uint32_t address, uint32_t& value, sectionParameterType_t type) override;
+        bool     write(uint32_t address, uint32_t value, sectionParameterType_t type) override;
+        bool     rangeAccessSupported() override;
+        bool     readRange(uint32_t address, uint8_t* buffer, size_t size) override;
+        bool     writeRange(uint32_t address, const uint8_t* buffer, size_t size) override;
+        uint32_t compactions() const;
+
+        private:
+        /// Marks the start of a page in use.
+        static constexpr uint32_t PAGE_MAGIC = 0x4C444246;
+
+        /// Size of page header: magic value and sequence number.
+        static constexpr size_t HEADER_SIZE = 8;
+
+        /// Size of a single record: record header and four bytes of data.
+        static constexpr size_t RECORD_SIZE = 8;
+
+        /// Maximum number of data bytes in a single record.
+        static constexpr size_t RECORD_DATA_SIZE = 4;
+
+        /// Number of record header bits which hold the address. Next two bits hold
+        /// the number of data bytes decreased by one and the last byte holds the checksum.
+        static constexpr uint32_t ADDRESS_BITS = 22;
+
+        /// Index value for addresses which haven't been written yet.
+        static constexpr uint32_t NO_RECORD = 0xFFFFFFFF;
+
+        FlashPages&           _pages;
+        const uint32_t        SIZE;
+        std::vector<uint32_t> _index       = {};
+        size_t                _headPage    = 0;
+        size_t                _headOffset  = 0;
+        size_t                _tailPage    = 0;
+        size_t                _usedPages   = 0;
+        uint32_t              _sequence    = 0;
+        uint32_t              _compactions = 0;
+
+        bool           mount();
+        bool           replayPage(size_t page);
+        bool           blankPage(size_t page);
+        bool           openPage(size_t page);
+        bool           nextPage();
+        bool           compact();
+        bool           appendRecord(uint32_t address, const uint8_t* data, size_t size);
+        bool           programRecord(uint32_t address, const uint8_t* data, size_t size);
+        bool           readByte(uint32_t address, uint8_t& value);
+        static uint8_t checksum(const uint8_t* record, size_t size);
+    };
+}    // namespace lib::lessdb
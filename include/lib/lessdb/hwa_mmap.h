@@ -0,0 +1,92 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "common.h"
+
+namespace lib::lessdb
+{
+    enum class msyncPolicy_t : uint8_t
+    {
+        EVERY_WRITE,    ///< Written pages are synchronized after every write.
+        ON_FLUSH,       ///< File is synchronized only when HwaMmap::flush is called.
+        TIMER,          ///< File is synchronized periodically from background thread if it has been written to.
+        OS,             ///< Synchronization is left to the operating system.
+    };
+
+    /// Storage backed by a file which is mapped to memory once on initialization,
+    /// so that reads and writes are plain memory accesses. Available on POSIX systems only.
+    class HwaMmap : public Hwa
+    {
+        public:
+        HwaMmap(const std::string& path, uint32_t size, msyncPolicy_t policy = msyncPolicy_t::ON_FLUSH, uint32_t syncPeriodMs = 1000)
+            : PATH(path)
+            , SIZE(size)
+            , POLICY(policy)
+            , SYNC_PERIOD_MS(syncPeriodMs)
+        {}
+
+        ~HwaMmap();
+
+        HwaMmap(const HwaMmap&)            = delete;
+        HwaMmap& operator=(const HwaMmap&) = delete;
+
+        bool     init() override;
+        uint32_t size() override;
+        bool     clear() override;
+        bool     read(uint32_t address, uint32_t& value, sectionParameterType_t type) override;
+        bool     write(uint32_t address, uint32_t value, sectionParameterType_t type) override;
+        bool     rangeAccessSupported() override;
+        bool     concurrentAccessSupported() override;
+        bool     readRange(uint32_t address, uint8_t* buffer, size_t size) override;
+        bool     writeRange(uint32_t address, const uint8_t* buffer, size_t size) override;
+        uint32_t milliseconds() override;
+        bool     flush();
+        uint32_t syncCount() const;
+
+        private:
+        const std::string   PATH;
+        const uint32_t      SIZE;
+        const msyncPolicy_t POLICY;
+        const uint32_t      SYNC_PERIOD_MS;
+
+        int                     _fd        = -1;
+        uint8_t*                _memory    = nullptr;
+        std::atomic<bool>       _dirty     = false;
+        std::atomic<uint32_t>   _syncCount = 0;
+        std::thread             _syncThread;
+        std::mutex              _syncMutex;
+        std::condition_variable _syncCondition;
+        bool                    _stopSync = false;
+
+        bool written(uint32_t address, size_t size);
+        bool sync(uint32_t address, size_t size);
+        void syncLoop();
+        void deinit();
+    };
+}    // namespace lib::lessdb
@@ -0,0 +1,146 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include "common.h"
+
+namespace lib::lessdb
+{
+    enum class traceOperation_t : uint8_t
+    {
+        INIT,
+        CLEAR,
+        READ,
+        WRITE,
+        READ_RANGE,
+        WRITE_RANGE,
+        AMOUNT
+    };
+
+    /// Destination of recorded trace.
+    class TraceOutput
+    {
+        public:
+        virtual bool write(const uint8_t* data, size_t size) = 0;
+    };
+
+    /// Trace output which appends the trace to a file.
+    class FileTraceOutput : public TraceOutput
+    {
+        public:
+        FileTraceOutput(const std::string& path);
+        ~FileTraceOutput();
+
+        FileTraceOutput(const FileTraceOutput&)            = delete;
+        FileTraceOutput& operator=(const FileTraceOutput&) = delete;
+
+        bool isOpen() const;
+        bool write(const uint8_t* data, size_t size) override;
+
+        private:
+        FILE* _file = nullptr;
+    };
+
+    /// Trace output which keeps the trace in RAM.
+    class MemoryTraceOutput : public TraceOutput
+    {
+        public:
+        bool write(const uint8_t* data, size_t size) override;
+
+        std::vector<uint8_t> _data = {};
+    };
+
+    /// Storage decorator which forwards all accesses to another storage and records
+    /// each of them into a compact binary trace. Trace starts with a header holding
+    /// the magic value, format version and storage size, followed by one record per
+    /// access. Record starts with a byte holding the operation, parameter type and
+    /// result, followed by the time elapsed since previous record in microseconds,
+    /// address and value or size, all encoded as variable-length integers. Range writes
+    /// are followed by the written bytes.
+    class HwaTrace : public Hwa
+    {
+        public:
+        /// Marks the start of a trace.
+        static constexpr uint32_t MAGIC = 0x5442444C;
+
+        /// Version of trace format.
+        static constexpr uint8_t VERSION = 1;
+
+        /// Size of trace header: magic value, version and storage size.
+        static constexpr size_t HEADER_SIZE = 9;
+
+        HwaTrace(Hwa& hwa, TraceOutput& output)
+            : _hwa(hwa)
+            , _output(output)
+        {}
+
+        bool     init() override;
+        uint32_t size() override;
+        bool     clear() override;
+        bool     read(uint32_t address, uint32_t& value, sectionParameterType_t type) override;
+        bool     write(uint32_t address, uint32_t value, sectionParameterType_t type) override;
+        bool     rangeAccessSupported() override;
+        bool     readRange(uint32_t address, uint8_t* buffer, size_t size) override;
+        bool     writeRange(uint32_t address, const uint8_t* buffer, size_t size) override;
+        uint32_t milliseconds() override;
+        uint32_t records() const;
+
+        private:
+        Hwa&         _hwa;
+        TraceOutput& _output;
+        bool         _headerWritten = false;
+        uint64_t     _lastTimestamp = 0;
+        uint32_t     _records       = 0;
+
+        void record(traceOperation_t operation, sectionParameterType_t type, bool result, uint32_t address, uint32_t value, const uint8_t* data = nullptr);
+    };
+
+    /// Result of replaying a trace.
+    struct ReplayResult
+    {
+        /// Number of replayed operations, indexed by traceOperation_t.
+        uint32_t operations[static_cast<uint8_t>(traceOperation_t::AMOUNT)] = {};
+
+        /// Number of operations whose result differed from the traced one.
+        uint32_t failures = 0;
+
+        /// Number of reads which returned different value than the traced one.
+        uint32_t mismatches = 0;
+
+        uint64_t bytesRead    = 0;
+        uint64_t bytesWritten = 0;
+
+        /// Time span of the trace in microseconds.
+        uint64_t tracedUs = 0;
+    };
+
+    /// Feeds recorded trace into storage.
+    class TraceReplay
+    {
+        public:
+        static bool storageSize(const uint8_t* trace, size_t size, uint32_t& storageSize);
+        static bool replay(const uint8_t* trace, size_t size, Hwa& hwa, ReplayResult& result);
+    };
+}    // namespace lib::lessdb
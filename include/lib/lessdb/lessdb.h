@@ -23,9 +23,13 @@
 #pragma once
 
 #include "common.h"
+#include "stats.h"
 
 namespace lib::lessdb
 {
+    template<typename Layout, uint32_t MemorySize>
+    class StaticLessDb;
+
     class LessDb
     {
         public:
@@ -39,15 +43,84 @@ namespace lib::lessdb
         bool            clear();
         bool            read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t& value);
         uint32_t        read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex);
+        bool            readSection(size_t blockIndex, size_t sectionIndex, uint32_t* values, size_t size);
+        bool            readRange(size_t blockIndex, size_t sectionIndex, size_t first, size_t count, uint32_t* values);
         bool            update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue);
+        bool            updateSection(size_t blockIndex, size_t sectionIndex, const uint32_t* values, size_t size);
+        bool            updateRange(size_t blockIndex, size_t sectionIndex, size_t first, size_t count, const uint32_t* values);
         uint32_t        currentDatabaseSize() const;
         uint32_t        currentDatabaseParameters() const;
         uint32_t        dbSize() const;
         uint32_t        lastParameterAddress() const;
         uint32_t        nextParameterAddress() const;
         bool            initData(factoryResetType_t type = factoryResetType_t::FULL);
+        bool            startInitData(factoryResetType_t type = factoryResetType_t::FULL);
+        initStatus_t    continueInitData(uint32_t maxBytes);
+        bool            initInProgress() const;
+        bool            setShadow(shadowSetting_t setting);
+        void            setAutoFlushThreshold(uint32_t threshold);
+        bool            flush();
+        uint32_t        dirtyBytes() const;
+        bool            setWriteCombining(uint32_t size, uint32_t deadlineMs = 0);
+        uint32_t        combinedBytes() const;
+        bool            flushIfExpired();
+        void            setCompareBeforeWrite(compareBeforeWriteSetting_t setting);
+        uint32_t        skippedWrites() const;
+        bool            setVerifyPolicy(verifyPolicy_t policy);
+        bool            verify();
+        bool            setReadCacheSize(size_t entries);
+        uint32_t        readCacheHits() const;
+        uint32_t        readCacheMisses() const;
+        bool            beginTransaction();
+        bool            commit();
+        void            rollback();
+        bool            transactionActive() const;
+        bool            setJournal(uint32_t address, uint32_t size);
+        bool            setHeader(headerSetting_t setting, uint32_t address = 0);
+        layoutStatus_t  layoutStatus() const;
+        uint32_t        layoutHash() const;
+        bool            writeHeader();
+        bool            setLazyReset(lazyResetSetting_t setting, uint32_t address = 0);
+        bool            sectionDefaulted(size_t blockIndex, size_t sectionIndex) const;
+        bool            setCheckpointPageSize(uint32_t pageSize);
+        bool            checkpoint(DataSink& sink, checkpointType_t type = checkpointType_t::INCREMENTAL);
+        bool            restore(const uint8_t* checkpoint, size_t size);
+        uint32_t        checkpointSequence() const;
+        bool            exportImage(DataSink& sink);
+        bool            importImage(const uint8_t* image, size_t size);
+        Stats           stats() const;
+        void            resetStats();
+
+        /// Returns the amount of bytes used by section with specified type and number of parameters.
+        static constexpr uint32_t sectionSize(sectionParameterType_t type, size_t numberOfParameters)
+        {
+            switch (type)
+            {
+            case sectionParameterType_t::BIT:
+                return (numberOfParameters / 8) + ((numberOfParameters % 8) != 0);
+
+            case sectionParameterType_t::HALF_BYTE:
+                return (numberOfParameters / 2) + ((numberOfParameters % 2) != 0);
+
+            case sectionParameterType_t::WORD:
+                return numberOfParameters * 2;
+
+            case sectionParameterType_t::DWORD:
+                return numberOfParameters * 4;
+
+            default:
+                return numberOfParameters;
+            }
+        }
 
         private:
+        template<typename Layout, uint32_t MemorySize>
+        friend class StaticLessDb;
+        friend class SnapshotLessDb;
+        friend class ParallelInit;
+        friend class AsyncLessDb;
+        friend class ConcurrentLessDb;
+
         /// Array holding all bit masks for easier access.
         static constexpr uint8_t BIT_MASK[8] = {
             0b00000001,
@@ -60,6 +133,193 @@ namespace lib::lessdb
             0b10000000,
         };
 
+        /// Size of the buffer used when accessing the storage in ranges.
+        static constexpr size_t RANGE_BUFFER_SIZE = 64;
+
+        /// Maximum number of writes awaiting verification with deferred verification policy.
+        static constexpr size_t PENDING_VERIFY_SIZE = 16;
+
+        /// Maximum number of entries in read cache.
+        static constexpr size_t READ_CACHE_MAX_SIZE = 16;
+
+        /// Default number of entries in read cache.
+        static constexpr size_t READ_CACHE_DEFAULT_SIZE = 8;
+
+        /// Value marking the journal as holding committed changes.
+        static constexpr uint32_t JOURNAL_MAGIC = 0x4C4E524A;
+
+        /// Size of journal header: magic value and length of journal content.
+        static constexpr size_t JOURNAL_HEADER_SIZE = 8;
+
+        /// Size of the header preceding each run of bytes in journal: address and size.
+        static constexpr size_t JOURNAL_RUN_HEADER_SIZE = 6;
+
+        /// Value marking the start of database header.
+        static constexpr uint32_t HEADER_MAGIC = 0x4844424C;
+
+        /// Version of database header format.
+        static constexpr uint32_t HEADER_VERSION = 1;
+
+        /// Size of database header: magic value, format version and layout hash.
+        static constexpr size_t HEADER_SIZE = 12;
+
+        /// Value marking the start of a checkpoint.
+        static constexpr uint32_t CHECKPOINT_MAGIC = 0x4B43444C;
+
+        /// Version of checkpoint format.
+        static constexpr uint8_t CHECKPOINT_VERSION = 1;
+
+        /// Size of checkpoint header: magic value, format version, checkpoint type, layout hash,
+        /// sequence numbers of the checkpoint and the previous one, database address and size,
+        /// and the number of ranges.
+        static constexpr size_t CHECKPOINT_HEADER_SIZE = 30;
+
+        /// Size of the header preceding each range in checkpoint: offset and size.
+        static constexpr size_t CHECKPOINT_RANGE_HEADER_SIZE = 8;
+
+        /// Size of the checksum which ends the checkpoint.
+        static constexpr size_t CHECKPOINT_CHECKSUM_SIZE = 4;
+
+        /// Initial value of checkpoint checksum, FNV-1a offset basis.
+        static constexpr uint32_t CHECKPOINT_CHECKSUM_BASIS = 2166136261;
+
+        /// Value marking the start of database image.
+        static constexpr uint32_t IMAGE_MAGIC = 0x4944424C;
+
+        /// Version of database image format.
+        static constexpr uint8_t IMAGE_VERSION = 1;
+
+        /// Size of database image header: magic value, format version, layout hash and database size.
+        static constexpr size_t IMAGE_HEADER_SIZE = 13;
+
+        /// Size of the checksum which ends the database image.
+        static constexpr size_t IMAGE_CHECKSUM_SIZE = 4;
+
+        /// Initial value of database image checksum, FNV-1a offset basis.
+        static constexpr uint32_t IMAGE_CHECKSUM_BASIS = 2166136261;
+
+        /// Flattened section information used to resolve parameter addresses
+        /// and to initialize the section.
+        struct SectionDescriptor
+        {
+            uint32_t               address;                   ///< Absolute address of the section.
+            uint32_t               numberOfParameters;        ///< Total number of parameters in section.
+            sectionParameterType_t type;                      ///< Type of parameters in section.
+            uint8_t                indexShift;                ///< Right shift applied to parameter index (bit and half-byte sections).
+            uint8_t                widthShift;                ///< Left shift applied to parameter index (word and dword sections).
+            uint32_t               valueMask;                 ///< Mask of valid value bits.
+            preserveSetting_t      preserveOnPartialReset;    ///< Whether section is skipped on partial reset.
+            autoIncrementSetting_t autoIncrement;             ///< Whether default value is incremented for each parameter.
+            uint32_t               defaultValue;              ///< Default value for all parameters.
+            const uint32_t*        defaultValues;             ///< Per-parameter default values, nullptr if not used.
+        };
+
+        /// Creates section descriptor from specified section properties.
+        static constexpr SectionDescriptor makeDescriptor(uint32_t               address,
+                                                          size_t                 numberOfParameters,
+                                                          sectionParameterType_t type,
+                                                          preserveSetting_t      preserveOnPartialReset,
+                                                          autoIncrementSetting_t autoIncrement,
+                                                          uint32_t               defaultValue,
+                                                          const uint32_t*        defaultValues)
+        {
+            SectionDescriptor descriptor = {};
+
+            descriptor.address                = address;
+            descriptor.numberOfParameters     = numberOfParameters;
+            descriptor.type                   = type;
+            descriptor.preserveOnPartialReset = preserveOnPartialReset;
+            descriptor.autoIncrement          = autoIncrement;
+            descriptor.defaultValue           = defaultValue;
+            descriptor.defaultValues          = defaultValues;
+
+            switch (type)
+            {
+            case sectionParameterType_t::BIT:
+            {
+                descriptor.indexShift = 3;
+                descriptor.valueMask  = 0x01;
+            }
+            break;
+
+            case sectionParameterType_t::HALF_BYTE:
+            {
+                descriptor.indexShift = 1;
+                descriptor.valueMask  = 0x0F;
+            }
+            break;
+
+            case sectionParameterType_t::BYTE:
+            {
+                descriptor.valueMask = 0xFF;
+            }
+            break;
+
+            case sectionParameterType_t::WORD:
+            {
+                descriptor.widthShift = 1;
+                descriptor.valueMask  = 0xFFFF;
+            }
+            break;
+
+            default:
+            {
+                // case sectionParameterType_t::DWORD:
+                descriptor.widthShift = 2;
+                descriptor.valueMask  = 0xFFFFFFFF;
+            }
+            break;
+            }
+
+            return descriptor;
+        }
+
+        struct PendingWrite
+        {
+            uint32_t               address;
+            uint32_t               value;
+            sectionParameterType_t type;
+        };
+
+        /// Position of initialization performed in steps.
+        struct InitProgress
+        {
+            bool               active  = false;
+            factoryResetType_t type    = factoryResetType_t::FULL;
+            int                passes  = 0;    ///< 2 if sections are verified after being written, 0 with lazy reset.
+            int                pass    = 0;
+            size_t             section = 0;
+            uint32_t           offset  = 0;    ///< Offset of the next byte to process within the section.
+        };
+
+        /// Bytes held in RAM before they're written, as runs of consecutive addresses
+        /// sorted by address. Runs never overlap or touch each other, so each of them
+        /// can be written as a single range.
+        struct StagedRuns
+        {
+            struct Run
+            {
+                uint32_t             address;
+                std::vector<uint8_t> data;
+            };
+
+            std::vector<Run> runs  = {};
+            uint32_t         bytes = 0;    ///< Total number of bytes in all runs.
+
+            void clear()
+            {
+                runs.clear();
+                bytes = 0;
+            }
+        };
+
+        struct ReadCacheEntry
+        {
+            uint32_t address;
+            uint32_t value;
+            uint8_t  size;    ///< Width of cached value in bytes, 0 if entry is empty.
+        };
+
         /// Reference to object which provides actual access to the storage system.
         Hwa& _hwa;
 
@@ -72,19 +332,173 @@ namespace lib::lessdb
         /// Address from which database layout starts.
         uint32_t _initialAddress = 0;
 
-        /// Database layout.
-        std::vector<Block>* _layout = {};
+        /// Storage for section descriptors and block index of layouts set with setLayout.
+        std::vector<SectionDescriptor> _descriptors = {};
+        std::vector<size_t>            _blockIndex  = {};
+
+        /// Descriptors for all sections in all blocks of the active layout.
+        const SectionDescriptor* _descriptorTable = nullptr;
+
+        /// Index of the first section descriptor for each block of the active layout.
+        /// Contains one additional entry holding the total number of sections.
+        const size_t* _blockTable = nullptr;
 
-        /// Cached values for bit and half-byte parameters.
-        /// Used if current requested address is the same as previous one.
-        uint8_t  _lastReadValue   = 0;
-        uint32_t _lastReadAddress = 0xFFFFFFFF;
+        /// Total number of blocks in active layout.
+        size_t _numberOfBlocks = 0;
+
+        /// Direct-mapped cache of values recently read from the storage.
+        ReadCacheEntry _readCache[READ_CACHE_MAX_SIZE] = {};
+        size_t         _readCacheSize                  = READ_CACHE_DEFAULT_SIZE;
+        uint32_t       _readCacheHits                  = 0;
+        uint32_t       _readCacheMisses                = 0;
 
         /// Holds the database address at which last parameter is stored.
         uint32_t _nextBlockAddress = 0;
 
-        bool     write(uint32_t address, uint32_t value, sectionParameterType_t type);
-        bool     checkParameters(size_t blockIndex, size_t sectionIndex, size_t parameterIndex);
-        uint32_t sectionAddress(size_t blockIndex, size_t sectionIndex);
+        /// Holds whether the database should be shadowed in RAM.
+        shadowSetting_t _shadowSetting = shadowSetting_t::DISABLE;
+
+        /// RAM copy of the entire database region.
+        std::vector<uint8_t> _shadow = {};
+
+        /// Flags indicating which bytes in shadow haven't been written to the storage.
+        std::vector<bool> _shadowDirty = {};
+
+        /// Total number of dirty bytes in shadow.
+        uint32_t _dirtyBytes = 0;
+
+        /// Number of dirty bytes after which the shadow is flushed automatically.
+        /// Set to 0 if shadow should be flushed only on request.
+        uint32_t _autoFlushThreshold = 0;
+
+        /// Writes held in RAM to be written together.
+        /// Write combining is disabled if size is 0.
+        StagedRuns _combined          = {};
+        uint32_t   _combineSize       = 0;
+        uint32_t   _combineDeadlineMs = 0;
+        uint32_t   _combineStartMs    = 0;
+
+        /// Holds whether the stored value should be compared with the new one before writing.
+        compareBeforeWriteSetting_t _compareBeforeWrite = compareBeforeWriteSetting_t::ENABLE;
+
+        /// Number of updates skipped because the stored value was unchanged.
+        uint32_t _skippedWrites = 0;
+
+        /// Policy used to verify values written to the storage.
+        verifyPolicy_t _verifyPolicy = verifyPolicy_t::ALWAYS;
+
+        /// Writes awaiting verification with deferred verification policy.
+        PendingWrite _pendingVerify[PENDING_VERIFY_SIZE] = {};
+        size_t       _pendingVerifyCount                 = 0;
+
+        /// Set while writing a batch which is verified as a whole once complete.
+        bool _batchWrite = false;
+
+        /// Progress of initialization started with startInitData.
+        InitProgress _initProgress = {};
+
+        /// Holds whether updates are staged in transaction instead of being written.
+        bool _transactionActive = false;
+
+        /// Bytes staged in active transaction.
+        StagedRuns _transaction = {};
+
+        /// Storage region used as transaction journal. Journal is disabled if size is 0.
+        uint32_t _journalAddress = 0;
+        uint32_t _journalSize    = 0;
+
+        /// Storage region holding database header.
+        headerSetting_t _headerSetting = headerSetting_t::DISABLE;
+        uint32_t        _headerAddress = 0;
+
+        /// Hash of active layout and result of its comparison with the stored header.
+        uint32_t       _layoutHash   = 0;
+        layoutStatus_t _layoutStatus = layoutStatus_t::UNKNOWN;
+
+        /// Storage region holding one bit per section, set for sections which are at defaults.
+        lazyResetSetting_t _lazyResetSetting = lazyResetSetting_t::DISABLE;
+        uint32_t           _lazyResetAddress = 0;
+
+        /// RAM copy of the map of sections which are at defaults, and the number of such sections.
+        std::vector<uint8_t> _defaultedMap      = {};
+        size_t               _defaultedSections = 0;
+
+        /// Size of the pages in which changes since the last checkpoint are tracked.
+        /// Tracking is disabled if page size is 0.
+        uint32_t _checkpointPageSize = 0;
+
+        /// Flags indicating which pages have been written since the last checkpoint.
+        std::vector<bool> _checkpointDirty = {};
+
+        /// Sequence number of the checkpoint created or restored last, 0 if there is none
+        /// which incremental checkpoint could be based on.
+        uint32_t _checkpointSequence = 0;
+
+        /// Instrumentation counters, empty unless LESSDB_STATS is defined.
+        StatsCollector _stats;
+
+        bool                     applyLayout(const SectionDescriptor* descriptors, const size_t* blockIndex, size_t numberOfBlocks, uint32_t startAddress);
+        bool                     releaseLayout();
+        bool                     readParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t& value);
+        bool                     readParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t address, uint32_t& value);
+        bool                     readParameters(const SectionDescriptor& descriptor, size_t first, size_t count, uint32_t* values);
+        bool                     readBytes(uint32_t address, uint8_t* buffer, size_t size);
+        bool                     updateParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t newValue);
+        bool                     updateParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t address, uint32_t newValue);
+        bool                     updateParameters(const SectionDescriptor& descriptor, size_t first, size_t count, const uint32_t* values);
+        bool                     write(uint32_t address, uint32_t value, sectionParameterType_t type);
+        bool                     writeRange(uint32_t address, const uint8_t* buffer, size_t size);
+        bool                     hwaWrite(uint32_t address, uint32_t value, sectionParameterType_t type);
+        bool                     hwaWriteRange(uint32_t address, const uint8_t* buffer, size_t size);
+        bool                     verifyValue(uint32_t address, uint32_t value, sectionParameterType_t type);
+        void                     dropPendingVerify(uint32_t address, size_t size);
+        bool                     verifyRange(uint32_t address, const uint8_t* buffer, size_t size);
+        bool                     verifySection(const SectionDescriptor& descriptor, uint32_t start = 0, uint32_t size = 0xFFFFFFFF);
+        bool                     readValue(uint32_t address, uint32_t& value, sectionParameterType_t type);
+        bool                     readStoredValue(uint32_t address, uint32_t& value, sectionParameterType_t type);
+        bool                     readHeader();
+        bool                     headerOverlaps(uint32_t address, uint32_t size) const;
+        bool                     loadDefaultedMap();
+        bool                     markDefaulted(factoryResetType_t type);
+        bool                     materializeSection(size_t section);
+        bool                     materializeRange(uint32_t address, size_t size);
+        void                     overlayDefaults(uint32_t address, uint8_t* buffer, size_t size) const;
+        bool                     defaulted(size_t section) const;
+        void                     setDefaulted(size_t section, bool state);
+        uint32_t                 defaultedMapSize() const;
+        bool                     writeJournal(const std::vector<uint8_t>& runs);
+        bool                     recoverJournal();
+        bool                     applyRuns(const uint8_t* runs, size_t size, bool direct);
+        void                     resetReadCache();
+        void                     invalidateReadCache(uint32_t address, size_t size);
+        ReadCacheEntry&          readCacheEntry(uint32_t address, sectionParameterType_t type);
+        bool                     loadShadow();
+        bool                     markDirty(uint32_t offset, size_t size);
+        bool                     combine(uint32_t address, const uint8_t* buffer, size_t size);
+        bool                     flushCombined();
+        bool                     combineExpired();
+        bool                     shadowActive() const;
+        bool                     skipWrite(uint32_t currentValue, uint32_t newValue);
+        bool                     unchanged(uint32_t address, uint32_t value, sectionParameterType_t type);
+        bool                     initSection(const SectionDescriptor& descriptor, uint32_t start = 0, uint32_t size = 0xFFFFFFFF);
+        bool                     completeInit();
+        size_t                   numberOfSections() const;
+        const SectionDescriptor* parameterDescriptor(size_t blockIndex, size_t sectionIndex, size_t parameterIndex) const;
+        const SectionDescriptor* checkParameters(size_t blockIndex, size_t sectionIndex, size_t parameterIndex);
+        void                     recordWrite(uint32_t address, size_t size);
+        void                     markCheckpointDirty(uint32_t address, size_t size);
+        void                     resetCheckpointPages();
+        static uint32_t          checksum(uint32_t hash, const uint8_t* data, size_t size);
+        static uint32_t          hashLayout(const SectionDescriptor* descriptors, const size_t* blockIndex, size_t numberOfBlocks, uint32_t startAddress);
+        static uint32_t          parameterAddress(const SectionDescriptor& descriptor, size_t parameterIndex);
+        static uint32_t          unpackValue(const SectionDescriptor& descriptor, const uint8_t* data, size_t parameterIndex);
+        static void              packValue(const SectionDescriptor& descriptor, uint8_t* data, size_t parameterIndex, uint32_t value);
+        static uint8_t           valueShift(const SectionDescriptor& descriptor, size_t parameterIndex);
+        static uint32_t          defaultValue(const SectionDescriptor& descriptor, size_t parameterIndex);
+        static uint8_t           defaultByte(const SectionDescriptor& descriptor, size_t byteIndex);
+        static uint8_t           typeWidth(sectionParameterType_t type);
+        static void              stage(StagedRuns& staged, uint32_t address, const uint8_t* buffer, size_t size);
+        static void              overlayStaged(const StagedRuns& staged, uint32_t address, uint32_t& value, sectionParameterType_t type);
+        static void              overlayStaged(const StagedRuns& staged, uint32_t address, uint8_t* buffer, size_t size);
     };
 }    // namespace lib::lessdb
@@ -0,0 +1,88 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include "lessdb.h"
+
+namespace lib::lessdb
+{
+    /// Writes entire sections from a pool of worker threads. Available on POSIX systems only.
+    /// Sections are split into chunks of CHUNK_SIZE bytes which workers take in turns,
+    /// so that large layouts are written with as many concurrent storage accesses as there
+    /// are workers. Chunks are written only if the storage supports both range and concurrent
+    /// access, and if RAM shadow, lazy reset and transactions aren't active. Otherwise, the
+    /// work is done by the database itself from the calling thread.
+    /// Database must not be accessed from other threads while the operation is in progress.
+    class ParallelInit
+    {
+        public:
+        /// Maximum number of bytes written by a worker in a single storage access.
+        static constexpr size_t CHUNK_SIZE = 65536;
+
+        /// Amount of work done by a single worker during the last operation.
+        struct WorkerReport
+        {
+            uint64_t bytes  = 0;    ///< Number of bytes written.
+            uint64_t ns     = 0;    ///< Time spent writing and verifying.
+            uint32_t chunks = 0;    ///< Number of chunks written.
+
+            /// Returns the write throughput of the worker in bytes per second.
+            double bytesPerSecond() const
+            {
+                return ns ? (bytes * 1e9) / ns : 0;
+            }
+        };
+
+        /// param [in] db       Database to initialize.
+        /// param [in] workers  Number of worker threads. If 0, number of hardware threads is used.
+        ParallelInit(LessDb& db, size_t workers = 0);
+
+        bool                             initData(factoryResetType_t type = factoryResetType_t::FULL);
+        bool                             fillSection(size_t blockIndex, size_t sectionIndex, uint32_t value);
+        size_t                           workers() const;
+        const std::vector<WorkerReport>& report() const;
+
+        private:
+        using SectionDescriptor = LessDb::SectionDescriptor;
+
+        /// Part of a section written by a single worker.
+        struct Chunk
+        {
+            const SectionDescriptor* descriptor;    ///< Section whose default bytes are written.
+            uint32_t                 offset;        ///< Offset of the chunk relative to the section start.
+            uint32_t                 size;          ///< Size of the chunk in bytes.
+            bool                     written;       ///< Whether the chunk has been written.
+            bool                     verified;      ///< Whether written chunk has been read back.
+            bool                     match;         ///< Whether read back chunk matched the written one.
+        };
+
+        LessDb&                   _db;
+        const size_t              WORKERS;
+        std::vector<WorkerReport> _report = {};
+
+        bool        parallel();
+        bool        run(std::vector<Chunk>& chunks);
+        static void addChunks(std::vector<Chunk>& chunks, const SectionDescriptor& descriptor);
+    };
+}    // namespace lib::lessdb
@@ -0,0 +1,196 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "lessdb.h"
+
+namespace lib::lessdb
+{
+    /// Front-end to LessDb for real-time readers. Available on POSIX systems only.
+    /// Entire database is kept in two RAM images. For each block, readers use one
+    /// image while writer updates the other one, after which the images are swapped
+    /// (left-right scheme). Readers never wait or allocate memory and always see a
+    /// consistent state of the whole block. Writers wait until readers leave the
+    /// image which is about to be updated. Changes are written to the database from
+    /// background thread periodically, or when flush is called.
+    /// Wrapped database must not be accessed directly while in use, and init
+    /// must be called again once its layout changes.
+    class SnapshotLessDb
+    {
+        public:
+        /// Consistent view of a single block, valid only within SnapshotLessDb::readBlock.
+        class BlockView
+        {
+            public:
+            bool     read(size_t sectionIndex, size_t parameterIndex, uint32_t& value) const;
+            uint32_t read(size_t sectionIndex, size_t parameterIndex) const;
+
+            private:
+            friend class SnapshotLessDb;
+
+            BlockView(const SnapshotLessDb& snapshot, size_t blockIndex, const uint8_t* image)
+                : _snapshot(snapshot)
+                , BLOCK_INDEX(blockIndex)
+                , _image(image)
+            {}
+
+            const SnapshotLessDb& _snapshot;
+            const size_t          BLOCK_INDEX;
+            const uint8_t*        _image;
+        };
+
+        /// Collects updates of a single block, valid only within SnapshotLessDb::updateBlock.
+        class BlockWriter
+        {
+            public:
+            bool update(size_t sectionIndex, size_t parameterIndex, uint32_t newValue);
+
+            private:
+            friend class SnapshotLessDb;
+
+            BlockWriter(SnapshotLessDb& snapshot, size_t blockIndex, uint8_t* image)
+                : _snapshot(snapshot)
+                , BLOCK_INDEX(blockIndex)
+                , _image(image)
+            {}
+
+            SnapshotLessDb& _snapshot;
+            const size_t    BLOCK_INDEX;
+            uint8_t*        _image;
+            bool            _result = true;
+        };
+
+        SnapshotLessDb(LessDb& db, uint32_t flushPeriodMs = 10)
+            : _db(db)
+            , FLUSH_PERIOD_MS(flushPeriodMs)
+        {}
+
+        ~SnapshotLessDb();
+
+        SnapshotLessDb(const SnapshotLessDb&)            = delete;
+        SnapshotLessDb& operator=(const SnapshotLessDb&) = delete;
+
+        bool     init();
+        bool     read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t& value);
+        uint32_t read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex);
+        bool     update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue);
+        bool     flush();
+        uint32_t pendingBytes();
+
+        /// Runs specified function with consistent view of the block. Never blocks.
+        /// param [in] blockIndex   Block index.
+        /// param [in] function     Function accepting const reference to BlockView.
+        /// returns: True on success, false if block doesn't exist.
+        template<typename Function>
+        bool readBlock(size_t blockIndex, Function&& function)
+        {
+            if (blockIndex >= _numberOfBlocks)
+            {
+                return false;
+            }
+
+            const uint8_t*  image;
+            const uint8_t   VERSION = arrive(blockIndex, image);
+            const BlockView VIEW(*this, blockIndex, image);
+
+            function(VIEW);
+
+            depart(blockIndex, VERSION);
+            return true;
+        }
+
+        /// Runs specified function which updates the block. Readers see either
+        /// none or all of the updates made by the function.
+        /// param [in] blockIndex   Block index.
+        /// param [in] function     Function accepting reference to BlockWriter.
+        /// returns: True if all updates were successful, false otherwise.
+        template<typename Function>
+        bool updateBlock(size_t blockIndex, Function&& function)
+        {
+            std::lock_guard<std::mutex> lock(_writeMutex);
+
+            if (blockIndex >= _numberOfBlocks)
+            {
+                return false;
+            }
+
+            BlockWriter writer(*this, blockIndex, inactiveImage(blockIndex));
+            function(writer);
+            publish(blockIndex);
+
+            return writer._result;
+        }
+
+        private:
+        /// Left-right state of a single block, kept on its own cache line
+        /// so that readers of different blocks don't contend.
+        struct alignas(64) BlockState
+        {
+            uint32_t              start = 0;    ///< Offset of the first block byte in image.
+            uint32_t              size  = 0;    ///< Number of bytes used by block.
+            std::atomic<uint8_t>  leftRight    = 0;
+            std::atomic<uint8_t>  versionIndex = 0;
+            std::atomic<uint32_t> readers[2]   = {};
+        };
+
+        LessDb&        _db;
+        const uint32_t FLUSH_PERIOD_MS;
+
+        std::vector<uint8_t>    _image[2]       = {};
+        std::vector<BlockState> _blocks         = {};
+        size_t                  _numberOfBlocks = 0;
+        uint32_t                _initialAddress = 0;
+
+        /// Bytes changed in image but not yet written to the database.
+        /// Guarded by _writeMutex.
+        std::mutex        _writeMutex;
+        std::vector<bool> _dirty      = {};
+        uint32_t          _dirtyBytes = 0;
+        uint32_t          _dirtyStart = 0;
+        uint32_t          _dirtyEnd   = 0;
+
+        /// Copy of changed bytes being written to the database. Guarded by _flushMutex.
+        std::mutex           _flushMutex;
+        std::vector<uint8_t> _flushImage = {};
+        std::vector<bool>    _flushDirty = {};
+
+        std::thread             _flushThread;
+        std::mutex              _threadMutex;
+        std::condition_variable _threadCondition;
+        bool                    _stopThread = false;
+
+        uint8_t  arrive(size_t blockIndex, const uint8_t*& image);
+        void     depart(size_t blockIndex, uint8_t version);
+        uint8_t* inactiveImage(size_t blockIndex);
+        void     publish(size_t blockIndex);
+        bool     readParameter(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, const uint8_t* image, uint32_t& value) const;
+        bool     writeParameter(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint8_t* image, uint32_t newValue);
+        void     markDirty(uint32_t offset, size_t size);
+        void     flushLoop();
+        void     stop();
+    };
+}    // namespace lib::lessdb
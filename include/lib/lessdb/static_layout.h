@@ -0,0 +1,334 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include "lessdb.h"
+
+namespace lib::lessdb
+{
+    /// Used as StaticSection argument when section has no per-parameter default values.
+    inline constexpr std::array<uint32_t, 0> NO_DEFAULT_VALUES = {};
+
+    /// Section with all properties known at compile time.
+    /// DefaultValues is an array with static storage holding default value
+    /// for each parameter. It must either be empty or contain exactly
+    /// NumberOfParameters values, and, as with runtime sections, it is
+    /// ignored when AutoIncrement is enabled.
+    template<size_t                 NumberOfParameters,
+             sectionParameterType_t ParameterType,
+             preserveSetting_t      PreserveOnPartialReset = preserveSetting_t::DISABLE,
+             autoIncrementSetting_t AutoIncrement          = autoIncrementSetting_t::DISABLE,
+             uint32_t               DefaultValue           = 0,
+             const auto&            DefaultValues          = NO_DEFAULT_VALUES>
+    struct StaticSection
+    {
+        static_assert((std::size(DefaultValues) == 0) || (std::size(DefaultValues) == NumberOfParameters),
+                      "Number of default values must match number of parameters");
+
+        static constexpr size_t                 NUMBER_OF_PARAMETERS      = NumberOfParameters;
+        static constexpr sectionParameterType_t PARAMETER_TYPE            = ParameterType;
+        static constexpr preserveSetting_t      PRESERVE_ON_PARTIAL_RESET = PreserveOnPartialReset;
+        static constexpr autoIncrementSetting_t AUTO_INCREMENT            = AutoIncrement;
+        static constexpr uint32_t               DEFAULT_VALUE             = DefaultValue;
+        static constexpr const uint32_t*        DEFAULT_VALUES            = std::size(DefaultValues) ? std::data(DefaultValues) : nullptr;
+        static constexpr uint32_t               SIZE                      = LessDb::sectionSize(ParameterType, NumberOfParameters);
+    };
+
+    /// Block consisting of sections defined with StaticSection.
+    template<typename... Sections>
+    struct StaticBlock
+    {
+        static constexpr size_t   NUMBER_OF_SECTIONS = sizeof...(Sections);
+        static constexpr uint32_t SIZE               = (0 + ... + Sections::SIZE);
+        static constexpr uint32_t PARAMETERS         = (0 + ... + Sections::NUMBER_OF_PARAMETERS);
+
+        /// Sum of parameter counts and types for all sections, as used by LessDb::layoutUid.
+        static constexpr uint32_t UID_SUM = (0 + ... + (Sections::NUMBER_OF_PARAMETERS + static_cast<uint32_t>(Sections::PARAMETER_TYPE)));
+
+        template<size_t Index>
+        using Section = std::tuple_element_t<Index, std::tuple<Sections...>>;
+
+        /// Returns the address of specified section relative to block start.
+        static constexpr uint32_t sectionOffset(size_t sectionIndex)
+        {
+            constexpr std::array<uint32_t, NUMBER_OF_SECTIONS> SIZES = { Sections::SIZE... };
+
+            uint32_t offset = 0;
+
+            for (size_t i = 0; i < sectionIndex; i++)
+            {
+                offset += SIZES[i];
+            }
+
+            return offset;
+        }
+    };
+
+    /// Database layout with all addresses calculated at compile time.
+    template<uint32_t StartAddress, typename... Blocks>
+    struct StaticLayout
+    {
+        static constexpr uint32_t START_ADDRESS      = StartAddress;
+        static constexpr size_t   NUMBER_OF_BLOCKS   = sizeof...(Blocks);
+        static constexpr size_t   NUMBER_OF_SECTIONS = (0 + ... + Blocks::NUMBER_OF_SECTIONS);
+        static constexpr uint32_t SIZE               = (0 + ... + Blocks::SIZE);
+        static constexpr uint32_t PARAMETERS         = (0 + ... + Blocks::PARAMETERS);
+
+        static_assert(NUMBER_OF_BLOCKS > 0, "Database layout must contain at least one block");
+
+        template<size_t Index>
+        using Block = std::tuple_element_t<Index, std::tuple<Blocks...>>;
+
+        template<size_t BlockIndex, size_t SectionIndex>
+        using Section = typename Block<BlockIndex>::template Section<SectionIndex>;
+
+        /// Returns the absolute address of specified block.
+        static constexpr uint32_t blockAddress(size_t blockIndex)
+        {
+            constexpr std::array<uint32_t, NUMBER_OF_BLOCKS> SIZES = { Blocks::SIZE... };
+
+            uint32_t address = START_ADDRESS;
+
+            for (size_t i = 0; i < blockIndex; i++)
+            {
+                address += SIZES[i];
+            }
+
+            return address;
+        }
+
+        /// Returns the index of the first section in specified block, counting all sections in layout.
+        static constexpr size_t firstSection(size_t blockIndex)
+        {
+            constexpr std::array<size_t, NUMBER_OF_BLOCKS> SECTIONS = { Blocks::NUMBER_OF_SECTIONS... };
+
+            size_t index = 0;
+
+            for (size_t i = 0; i < blockIndex; i++)
+            {
+                index += SECTIONS[i];
+            }
+
+            return index;
+        }
+
+        /// Returns the absolute address of specified section.
+        template<size_t BlockIndex, size_t SectionIndex>
+        static constexpr uint32_t sectionAddress()
+        {
+            return blockAddress(BlockIndex) + Block<BlockIndex>::sectionOffset(SectionIndex);
+        }
+
+        /// Calculates unique ID for this layout.
+        /// Matches the value LessDb::layoutUid returns for equivalent runtime layout.
+        static constexpr uint16_t uid(uint16_t magicValue = 0)
+        {
+            return static_cast<uint16_t>((0 + ... + Blocks::UID_SUM) + magicValue);
+        }
+    };
+
+    /// Database using layout defined with StaticLayout.
+    /// Section descriptors are generated at compile time, so no layout
+    /// calculation or heap allocation is needed at runtime. Parameters
+    /// are accessed with block and section indexes as template arguments,
+    /// so that section address and index shifts are compile time constants
+    /// and parameter address is calculated at the call site. Reading and
+    /// writing the value then goes through the same LessDb path as for
+    /// runtime layouts, so that caching, verification and transactions
+    /// behave the same.
+    /// MemorySize is the size of the memory provided by Hwa, used to check
+    /// whether the layout fits into the memory.
+    template<typename Layout, uint32_t MemorySize>
+    class StaticLessDb
+    {
+        static_assert((Layout::START_ADDRESS + Layout::SIZE) <= MemorySize, "Database layout doesn't fit into memory");
+
+        public:
+        StaticLessDb(Hwa& hwa)
+            : _db(hwa)
+        {}
+
+        /// Initializes the memory and activates the layout.
+        /// returns: True on success, false otherwise.
+        bool init()
+        {
+            if (!_db.init())
+            {
+                return false;
+            }
+
+            if (_db.dbSize() < MemorySize)
+            {
+                return false;
+            }
+
+            return _db.applyLayout(DESCRIPTORS.data(), BLOCK_INDEX.data(), Layout::NUMBER_OF_BLOCKS, Layout::START_ADDRESS);
+        }
+
+        template<auto BlockIndex, auto SectionIndex>
+        bool read(size_t parameterIndex, uint32_t& value)
+        {
+            constexpr size_t BLOCK   = static_cast<size_t>(BlockIndex);
+            constexpr size_t SECTION = static_cast<size_t>(SectionIndex);
+
+            if (parameterIndex >= Layout::template Section<BLOCK, SECTION>::NUMBER_OF_PARAMETERS)
+            {
+                return false;
+            }
+
+            return _db.readParameter(DESCRIPTORS[descriptorIndex<BLOCK, SECTION>()], parameterIndex, parameterAddress<BLOCK, SECTION>(parameterIndex), value);
+        }
+
+        template<auto BlockIndex, auto SectionIndex>
+        uint32_t read(size_t parameterIndex)
+        {
+            uint32_t value = 0;
+            read<BlockIndex, SectionIndex>(parameterIndex, value);
+            return value;
+        }
+
+        template<auto BlockIndex, auto SectionIndex>
+        bool readSection(uint32_t* values, size_t size)
+        {
+            constexpr size_t BLOCK   = static_cast<size_t>(BlockIndex);
+            constexpr size_t SECTION = static_cast<size_t>(SectionIndex);
+            constexpr size_t COUNT   = Layout::template Section<BLOCK, SECTION>::NUMBER_OF_PARAMETERS;
+
+            if (size < COUNT)
+            {
+                return false;
+            }
+
+            return _db.readParameters(DESCRIPTORS[descriptorIndex<BLOCK, SECTION>()], 0, COUNT, values);
+        }
+
+        template<auto BlockIndex, auto SectionIndex>
+        bool update(size_t parameterIndex, uint32_t newValue)
+        {
+            constexpr size_t BLOCK   = static_cast<size_t>(BlockIndex);
+            constexpr size_t SECTION = static_cast<size_t>(SectionIndex);
+
+            if (parameterIndex >= Layout::template Section<BLOCK, SECTION>::NUMBER_OF_PARAMETERS)
+            {
+                return false;
+            }
+
+            return _db.updateParameter(DESCRIPTORS[descriptorIndex<BLOCK, SECTION>()], parameterIndex, parameterAddress<BLOCK, SECTION>(parameterIndex), newValue);
+        }
+
+        template<auto BlockIndex, auto SectionIndex>
+        bool updateSection(const uint32_t* values, size_t size)
+        {
+            constexpr size_t BLOCK   = static_cast<size_t>(BlockIndex);
+            constexpr size_t SECTION = static_cast<size_t>(SectionIndex);
+            constexpr size_t COUNT   = Layout::template Section<BLOCK, SECTION>::NUMBER_OF_PARAMETERS;
+
+            if (size < COUNT)
+            {
+                return false;
+            }
+
+            return _db.updateParameters(DESCRIPTORS[descriptorIndex<BLOCK, SECTION>()], 0, COUNT, values);
+        }
+
+        bool initData(factoryResetType_t type = factoryResetType_t::FULL)
+        {
+            return _db.initData(type);
+        }
+
+        /// Provides access to the underlying database for settings and
+        /// index-based access.
+        LessDb& database()
+        {
+            return _db;
+        }
+
+        private:
+        using SectionDescriptor = LessDb::SectionDescriptor;
+
+        template<size_t BlockIndex, size_t SectionIndex>
+        static constexpr size_t descriptorIndex()
+        {
+            return Layout::firstSection(BlockIndex) + SectionIndex;
+        }
+
+        template<size_t BlockIndex, size_t SectionIndex>
+        static constexpr SectionDescriptor sectionDescriptor()
+        {
+            using Section = typename Layout::template Section<BlockIndex, SectionIndex>;
+
+            return LessDb::makeDescriptor(Layout::template sectionAddress<BlockIndex, SectionIndex>(),
+                                          Section::NUMBER_OF_PARAMETERS,
+                                          Section::PARAMETER_TYPE,
+                                          Section::PRESERVE_ON_PARTIAL_RESET,
+                                          Section::AUTO_INCREMENT,
+                                          Section::DEFAULT_VALUE,
+                                          Section::DEFAULT_VALUES);
+        }
+
+        /// Returns the address of the byte in which specified parameter is stored.
+        /// Only the parameter offset is calculated at runtime.
+        template<size_t BlockIndex, size_t SectionIndex>
+        static constexpr uint32_t parameterAddress(size_t parameterIndex)
+        {
+            constexpr SectionDescriptor DESCRIPTOR  = sectionDescriptor<BlockIndex, SectionIndex>();
+            constexpr uint32_t          BASE        = DESCRIPTOR.address;
+            constexpr uint8_t           INDEX_SHIFT = DESCRIPTOR.indexShift;
+            constexpr uint8_t           WIDTH_SHIFT = DESCRIPTOR.widthShift;
+
+            return BASE + ((parameterIndex >> INDEX_SHIFT) << WIDTH_SHIFT);
+        }
+
+        template<size_t BlockIndex, size_t... SectionIndex>
+        static constexpr void addBlockDescriptors(std::array<SectionDescriptor, Layout::NUMBER_OF_SECTIONS>& descriptors,
+                                                  std::index_sequence<SectionIndex...>)
+        {
+            ((descriptors[descriptorIndex<BlockIndex, SectionIndex>()] = sectionDescriptor<BlockIndex, SectionIndex>()), ...);
+        }
+
+        template<size_t... BlockIndex>
+        static constexpr std::array<SectionDescriptor, Layout::NUMBER_OF_SECTIONS> makeDescriptors(std::index_sequence<BlockIndex...>)
+        {
+            std::array<SectionDescriptor, Layout::NUMBER_OF_SECTIONS> descriptors = {};
+
+            (addBlockDescriptors<BlockIndex>(descriptors, std::make_index_sequence<Layout::template Block<BlockIndex>::NUMBER_OF_SECTIONS>{}), ...);
+
+            return descriptors;
+        }
+
+        template<size_t... BlockIndex>
+        static constexpr std::array<size_t, Layout::NUMBER_OF_BLOCKS + 1> makeBlockIndex(std::index_sequence<BlockIndex...>)
+        {
+            return { Layout::firstSection(BlockIndex)..., Layout::NUMBER_OF_SECTIONS };
+        }
+
+        static constexpr std::array<SectionDescriptor, Layout::NUMBER_OF_SECTIONS> DESCRIPTORS = makeDescriptors(std::make_index_sequence<Layout::NUMBER_OF_BLOCKS>{});
+        static constexpr std::array<size_t, Layout::NUMBER_OF_BLOCKS + 1>          BLOCK_INDEX = makeBlockIndex(std::make_index_sequence<Layout::NUMBER_OF_BLOCKS>{});
+
+        LessDb _db;
+    };
+}    // namespace lib::lessdb
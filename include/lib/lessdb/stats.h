@@ -0,0 +1,361 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "common.h"
+
+#ifdef LESSDB_STATS
+#include <chrono>
+#endif
+
+namespace lib::lessdb
+{
+    /// Distribution of operation durations. Bucket N holds operations which took
+    /// less than 2^(N + 6) nanoseconds, last bucket holds all longer operations.
+    struct LatencyHistogram
+    {
+        static constexpr size_t BUCKETS = 16;
+
+        uint32_t count            = 0;
+        uint64_t totalNs          = 0;
+        uint64_t maxNs            = 0;
+        uint32_t buckets[BUCKETS] = {};
+
+        static size_t bucket(uint64_t ns)
+        {
+            size_t bucket = 0;
+
+            while ((bucket < (BUCKETS - 1)) && (ns >= (static_cast<uint64_t>(64) << bucket)))
+            {
+                bucket++;
+            }
+
+            return bucket;
+        }
+
+        void record(uint64_t ns)
+        {
+            buckets[bucket(ns)]++;
+            count++;
+            totalNs += ns;
+
+            if (ns > maxNs)
+            {
+                maxNs = ns;
+            }
+        }
+    };
+
+    /// Snapshot of database statistics.
+    struct Stats
+    {
+        /// Number of values read from and written to the storage, indexed by sectionParameterType_t.
+        uint32_t hwaReads[5]  = {};
+        uint32_t hwaWrites[5] = {};
+
+        /// Number of range reads and writes made to the storage.
+        uint32_t hwaRangeReads  = 0;
+        uint32_t hwaRangeWrites = 0;
+
+        /// Number of storage reads made to verify written data,
+        /// and number of those in which stored data didn't match.
+        uint32_t verifyReads      = 0;
+        uint32_t verifyMismatches = 0;
+
+        uint32_t cacheHits   = 0;
+        uint32_t cacheMisses = 0;
+
+        /// Number of requests rejected because of invalid block, section or parameter index.
+        uint32_t rejectedParameters = 0;
+
+        /// Number of bytes written to the storage for each section, indexed by block and section.
+        std::vector<std::vector<uint32_t>> bytesWritten = {};
+
+        LatencyHistogram readLatency     = {};
+        LatencyHistogram updateLatency   = {};
+        LatencyHistogram initDataLatency = {};
+    };
+
+#ifdef LESSDB_STATS
+    /// Collects statistics of database instance. Enabled with LESSDB_STATS definition.
+    /// Counters are atomic since database can be accessed from multiple threads at once
+    /// (see ConcurrentLessDb). They're only counted, so relaxed ordering is sufficient.
+    class StatsCollector
+    {
+        public:
+        static constexpr bool ENABLED = true;
+
+        /// Latency histogram which can be recorded from multiple threads at once.
+        class Histogram
+        {
+            public:
+            void record(uint64_t ns)
+            {
+                add(_buckets[LatencyHistogram::bucket(ns)]);
+                add(_count);
+                _totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+                uint64_t max = _maxNs.load(std::memory_order_relaxed);
+
+                while ((ns > max) && !_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+                {
+                    // max has been updated to the current value, retry if it's still lower
+                }
+            }
+
+            LatencyHistogram snapshot() const
+            {
+                LatencyHistogram histogram = {};
+
+                histogram.count   = _count.load(std::memory_order_relaxed);
+                histogram.totalNs = _totalNs.load(std::memory_order_relaxed);
+                histogram.maxNs   = _maxNs.load(std::memory_order_relaxed);
+
+                for (size_t i = 0; i < LatencyHistogram::BUCKETS; i++)
+                {
+                    histogram.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+                }
+
+                return histogram;
+            }
+
+            void reset()
+            {
+                _count.store(0, std::memory_order_relaxed);
+                _totalNs.store(0, std::memory_order_relaxed);
+                _maxNs.store(0, std::memory_order_relaxed);
+
+                for (auto& bucket : _buckets)
+                {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+            }
+
+            private:
+            std::atomic<uint32_t> _count                              = {};
+            std::atomic<uint64_t> _totalNs                            = {};
+            std::atomic<uint64_t> _maxNs                              = {};
+            std::atomic<uint32_t> _buckets[LatencyHistogram::BUCKETS] = {};
+        };
+
+        /// Records the duration of an operation once the scope ends.
+        class Timer
+        {
+            public:
+            Timer(Histogram& histogram)
+                : _histogram(histogram)
+                , START(std::chrono::steady_clock::now())
+            {}
+
+            ~Timer()
+            {
+                _histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count());
+            }
+
+            private:
+            Histogram&                                  _histogram;
+            const std::chrono::steady_clock::time_point START;
+        };
+
+        void hwaRead(sectionParameterType_t type)
+        {
+            add(_hwaReads[static_cast<uint8_t>(type)]);
+        }
+
+        void hwaWrite(sectionParameterType_t type)
+        {
+            add(_hwaWrites[static_cast<uint8_t>(type)]);
+        }
+
+        void hwaRangeRead()
+        {
+            add(_hwaRangeReads);
+        }
+
+        void hwaRangeWrite()
+        {
+            add(_hwaRangeWrites);
+        }
+
+        void verifyRead(bool match)
+        {
+            add(_verifyReads);
+
+            if (!match)
+            {
+                add(_verifyMismatches);
+            }
+        }
+
+        void rejected()
+        {
+            add(_rejectedParameters);
+        }
+
+        void sectionWritten(size_t section, size_t bytes)
+        {
+            add(_sectionBytes[section], bytes);
+        }
+
+        void setSections(size_t numberOfSections)
+        {
+            _sectionBytes = std::vector<std::atomic<uint32_t>>(numberOfSections);
+        }
+
+        Timer read()
+        {
+            return Timer(_readLatency);
+        }
+
+        Timer update()
+        {
+            return Timer(_updateLatency);
+        }
+
+        Timer initData()
+        {
+            return Timer(_initDataLatency);
+        }
+
+        Stats stats() const
+        {
+            Stats stats = {};
+
+            for (size_t i = 0; i < 5; i++)
+            {
+                stats.hwaReads[i]  = _hwaReads[i].load(std::memory_order_relaxed);
+                stats.hwaWrites[i] = _hwaWrites[i].load(std::memory_order_relaxed);
+            }
+
+            stats.hwaRangeReads      = _hwaRangeReads.load(std::memory_order_relaxed);
+            stats.hwaRangeWrites     = _hwaRangeWrites.load(std::memory_order_relaxed);
+            stats.verifyReads        = _verifyReads.load(std::memory_order_relaxed);
+            stats.verifyMismatches   = _verifyMismatches.load(std::memory_order_relaxed);
+            stats.rejectedParameters = _rejectedParameters.load(std::memory_order_relaxed);
+            stats.readLatency        = _readLatency.snapshot();
+            stats.updateLatency      = _updateLatency.snapshot();
+            stats.initDataLatency    = _initDataLatency.snapshot();
+
+            return stats;
+        }
+
+        uint32_t sectionBytes(size_t section) const
+        {
+            return _sectionBytes[section].load(std::memory_order_relaxed);
+        }
+
+        void reset()
+        {
+            for (size_t i = 0; i < 5; i++)
+            {
+                _hwaReads[i].store(0, std::memory_order_relaxed);
+                _hwaWrites[i].store(0, std::memory_order_relaxed);
+            }
+
+            _hwaRangeReads.store(0, std::memory_order_relaxed);
+            _hwaRangeWrites.store(0, std::memory_order_relaxed);
+            _verifyReads.store(0, std::memory_order_relaxed);
+            _verifyMismatches.store(0, std::memory_order_relaxed);
+            _rejectedParameters.store(0, std::memory_order_relaxed);
+            _readLatency.reset();
+            _updateLatency.reset();
+            _initDataLatency.reset();
+
+            for (auto& bytes : _sectionBytes)
+            {
+                bytes.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        private:
+        static void add(std::atomic<uint32_t>& counter, uint32_t value = 1)
+        {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint32_t>              _hwaReads[5]        = {};
+        std::atomic<uint32_t>              _hwaWrites[5]       = {};
+        std::atomic<uint32_t>              _hwaRangeReads      = {};
+        std::atomic<uint32_t>              _hwaRangeWrites     = {};
+        std::atomic<uint32_t>              _verifyReads        = {};
+        std::atomic<uint32_t>              _verifyMismatches   = {};
+        std::atomic<uint32_t>              _rejectedParameters = {};
+        std::vector<std::atomic<uint32_t>> _sectionBytes       = {};
+        Histogram                          _readLatency        = {};
+        Histogram                          _updateLatency      = {};
+        Histogram                          _initDataLatency    = {};
+    };
+#else
+    /// Empty statistics collector used when LESSDB_STATS isn't defined.
+    /// All calls compile to nothing.
+    class StatsCollector
+    {
+        public:
+        static constexpr bool ENABLED = false;
+
+        class Timer
+        {
+            public:
+            // user-provided destructor avoids unused variable warnings in callers
+            ~Timer() {}
+        };
+
+        void hwaRead(sectionParameterType_t) {}
+        void hwaWrite(sectionParameterType_t) {}
+        void hwaRangeRead() {}
+        void hwaRangeWrite() {}
+        void verifyRead(bool) {}
+        void rejected() {}
+        void sectionWritten(size_t, size_t) {}
+        void setSections(size_t) {}
+        void reset() {}
+
+        Timer read()
+        {
+            return {};
+        }
+
+        Timer update()
+        {
+            return {};
+        }
+
+        Timer initData()
+        {
+            return {};
+        }
+
+        Stats stats() const
+        {
+            return {};
+        }
+
+        uint32_t sectionBytes(size_t) const
+        {
+            return 0;
+        }
+    };
+#endif
+}    // namespace lib::lessdb
@@ -0,0 +1,338 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <map>
+#include <tuple>
+#include "lib/lessdb/async.h"
+
+using namespace lib::lessdb;
+
+/// param [in] db       Database to access.
+/// param [in] workers  Requested number of worker threads. Only one worker is
+///                     used if the storage doesn't support concurrent access.
+AsyncLessDb::AsyncLessDb(LessDb& db, size_t workers)
+    : _db(db)
+{
+    if ((workers > 1) && _db._hwa.concurrentAccessSupported())
+    {
+        _concurrent = std::make_unique<ConcurrentLessDb>(_db);
+    }
+    else
+    {
+        workers = 1;
+    }
+
+    for (size_t i = 0; i < workers; i++)
+    {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+
+    for (auto& worker : _workers)
+    {
+        worker->thread = std::thread(&AsyncLessDb::workerLoop, this, std::ref(*worker));
+    }
+}
+
+/// Completes all submitted operations and stops the workers.
+AsyncLessDb::~AsyncLessDb()
+{
+    drain();
+    _stop = true;
+
+    for (auto& worker : _workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+        }
+
+        worker->condition.notify_one();
+        worker->thread.join();
+    }
+}
+
+/// Submits a read of specified parameter.
+/// param [in] blockIndex       Block index.
+/// param [in] sectionIndex     Section index.
+/// param [in] parameterIndex   Parameter index.
+/// param [in] callback         Function called from the worker once the read is done.
+///                             If not set, result has to be collected with poll or wait.
+/// returns: Ticket identifying the operation.
+AsyncLessDb::ticket_t AsyncLessDb::submitRead(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, callback_t callback)
+{
+    return submit({ INVALID_TICKET, operation_t::READ, blockIndex, sectionIndex, parameterIndex, 0, std::move(callback) });
+}
+
+/// Submits an update of specified parameter.
+/// param [in] blockIndex       Block index.
+/// param [in] sectionIndex     Section index.
+/// param [in] parameterIndex   Parameter index.
+/// param [in] newValue         New value for parameter.
+/// param [in] callback         Function called from the worker once the update is done.
+///                             If not set, result has to be collected with poll or wait.
+/// returns: Ticket identifying the operation.
+AsyncLessDb::ticket_t AsyncLessDb::submitUpdate(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue, callback_t callback)
+{
+    return submit({ INVALID_TICKET, operation_t::UPDATE, blockIndex, sectionIndex, parameterIndex, newValue, std::move(callback) });
+}
+
+/// Retrieves the result of operation submitted without callback, without waiting.
+/// param [in] ticket       Ticket of the operation.
+/// param [out] result      Result of the operation.
+/// returns: True if operation is complete, false otherwise. Result can be retrieved only once.
+bool AsyncLessDb::poll(ticket_t ticket, Result& result)
+{
+    std::lock_guard<std::mutex> lock(_resultMutex);
+
+    auto completed = _results.find(ticket);
+
+    if (completed == _results.end())
+    {
+        return false;
+    }
+
+    result = completed->second;
+    _results.erase(completed);
+    _awaited.erase(ticket);
+
+    return true;
+}
+
+/// Waits until operation submitted without callback is complete.
+/// param [in] ticket       Ticket of the operation.
+/// param [out] result      Result of the operation.
+/// returns: True once operation is complete, false if ticket doesn't identify
+///          operation whose result hasn't been retrieved yet.
+bool AsyncLessDb::wait(ticket_t ticket, Result& result)
+{
+    std::unique_lock<std::mutex> lock(_resultMutex);
+
+    if (_awaited.find(ticket) == _awaited.end())
+    {
+        return false;
+    }
+
+    _resultCondition.wait(lock, [&]()
+                          {
+                              return _results.find(ticket) != _results.end();
+                          });
+
+    result = _results[ticket];
+    _results.erase(ticket);
+    _awaited.erase(ticket);
+
+    return true;
+}
+
+/// Waits until all submitted operations are complete.
+void AsyncLessDb::drain()
+{
+    std::unique_lock<std::mutex> lock(_resultMutex);
+
+    _resultCondition.wait(lock, [this]()
+                          {
+                              return !_pending;
+                          });
+}
+
+/// Returns the number of submitted operations which aren't complete yet.
+size_t AsyncLessDb::pending() const
+{
+    std::lock_guard<std::mutex> lock(_resultMutex);
+    return _pending;
+}
+
+/// Returns the number of worker threads.
+size_t AsyncLessDb::workers() const
+{
+    return _workers.size();
+}
+
+/// Returns the number of updates which weren't written because they were overwritten within the same batch.
+uint32_t AsyncLessDb::coalescedUpdates() const
+{
+    return _coalesced;
+}
+
+AsyncLessDb::ticket_t AsyncLessDb::submit(Operation&& operation)
+{
+    if (_stop)
+    {
+        return INVALID_TICKET;
+    }
+
+    operation.ticket = _nextTicket++;
+
+    const ticket_t TICKET = operation.ticket;
+
+    {
+        std::lock_guard<std::mutex> lock(_resultMutex);
+
+        if (operation.callback == nullptr)
+        {
+            _awaited.insert(TICKET);
+        }
+
+        _pending++;
+    }
+
+    // operations on the same block are always handled by the same worker, in order
+    Worker& worker = *_workers[operation.blockIndex % _workers.size()];
+
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(std::move(operation));
+    }
+
+    worker.condition.notify_one();
+    return TICKET;
+}
+
+void AsyncLessDb::workerLoop(Worker& worker)
+{
+    std::deque<Operation> batch;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+
+            worker.condition.wait(lock, [&]()
+                                  {
+                                      return _stop || !worker.queue.empty();
+                                  });
+
+            if (worker.queue.empty())
+            {
+                // stopped and nothing left to do
+                return;
+            }
+
+            batch.swap(worker.queue);
+        }
+
+        process(batch);
+        batch.clear();
+    }
+}
+
+/// Performs all operations in a batch. Update which is followed by another update
+/// of the same parameter, without a read of that parameter in between, is skipped
+/// and completed in its own position with the result of the last update.
+/// param [in] batch    Operations in the order in which they were submitted.
+void AsyncLessDb::process(std::deque<Operation>& batch)
+{
+    using key_t = std::tuple<size_t, size_t, size_t>;
+
+    // index of the operation whose result completes the skipped update
+    std::vector<size_t> supersededBy(batch.size(), batch.size());
+    std::map<key_t, size_t> lastUpdate;
+
+    for (size_t i = batch.size(); i-- > 0;)
+    {
+        const Operation& operation = batch[i];
+        const key_t      KEY       = { operation.blockIndex, operation.sectionIndex, operation.parameterIndex };
+
+        if (operation.type == operation_t::READ)
+        {
+            lastUpdate.erase(KEY);
+            continue;
+        }
+
+        auto last = lastUpdate.find(KEY);
+
+        if (last != lastUpdate.end())
+        {
+            supersededBy[i] = last->second;
+        }
+        else
+        {
+            lastUpdate[KEY] = i;
+        }
+    }
+
+    std::vector<Result> results(batch.size());
+    std::vector<bool>   executed(batch.size(), false);
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        // nothing in between reads the parameter, so the last update is performed
+        // in place of the first skipped one and all of them complete in order
+        const size_t PERFORMED = supersededBy[i] != batch.size() ? supersededBy[i] : i;
+
+        if (!executed[PERFORMED])
+        {
+            results[PERFORMED]  = execute(batch[PERFORMED]);
+            executed[PERFORMED] = true;
+        }
+
+        Result result = results[PERFORMED];
+
+        if (PERFORMED != i)
+        {
+            _coalesced++;
+            result.value = batch[i].value;
+        }
+
+        complete(batch[i], result);
+    }
+}
+
+AsyncLessDb::Result AsyncLessDb::execute(const Operation& operation)
+{
+    Result result;
+
+    if (operation.type == operation_t::READ)
+    {
+        result.success = _concurrent ? _concurrent->read(operation.blockIndex, operation.sectionIndex, operation.parameterIndex, result.value)
+                                     : _db.read(operation.blockIndex, operation.sectionIndex, operation.parameterIndex, result.value);
+    }
+    else
+    {
+        result.value   = operation.value;
+        result.success = _concurrent ? _concurrent->update(operation.blockIndex, operation.sectionIndex, operation.parameterIndex, operation.value)
+                                     : _db.update(operation.blockIndex, operation.sectionIndex, operation.parameterIndex, operation.value);
+    }
+
+    return result;
+}
+
+/// Delivers the result to the callback, or stores it until it's retrieved.
+void AsyncLessDb::complete(const Operation& operation, const Result& result)
+{
+    if (operation.callback != nullptr)
+    {
+        operation.callback(operation.ticket, result);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_resultMutex);
+
+        if (operation.callback == nullptr)
+        {
+            _results[operation.ticket] = result;
+        }
+
+        _pending--;
+    }
+
+    _resultCondition.notify_all();
+}
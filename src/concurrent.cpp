@@ -0,0 +1,242 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include "lib/lessdb/concurrent.h"
+
+using namespace lib::lessdb;
+
+namespace
+{
+    /// Number of entries in per-thread cache.
+    constexpr size_t THREAD_CACHE_SIZE = 64;
+
+    struct ThreadCacheEntry
+    {
+        uint32_t instance;              ///< Instance which cached the value, 0 if entry is empty.
+        uint32_t databaseGeneration;    ///< Database generation at the time value was read.
+        uint32_t stripeGeneration;      ///< Stripe generation at the time value was read.
+        size_t   blockIndex;
+        size_t   sectionIndex;
+        size_t   parameterIndex;
+        uint32_t value;
+    };
+
+    thread_local ThreadCacheEntry threadCache[THREAD_CACHE_SIZE] = {};
+
+    ThreadCacheEntry& threadCacheEntry(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+    {
+        return threadCache[((blockIndex * 31) + (sectionIndex * 7) + parameterIndex) & (THREAD_CACHE_SIZE - 1)];
+    }
+}    // namespace
+
+std::atomic<uint32_t> ConcurrentLessDb::_instanceCounter = 0;
+
+ConcurrentLessDb::ConcurrentLessDb(LessDb& db)
+    : _db(db)
+    , INSTANCE(++_instanceCounter)
+{
+    applySettings();
+}
+
+bool ConcurrentLessDb::setLayout(std::vector<Block>& layout, uint32_t startAddress)
+{
+    return exclusive([&](LessDb& db)
+                     {
+                         return db.setLayout(layout, startAddress);
+                     });
+}
+
+bool ConcurrentLessDb::initData(factoryResetType_t type)
+{
+    return exclusive([&](LessDb& db)
+                     {
+                         return db.initData(type);
+                     });
+}
+
+bool ConcurrentLessDb::clear()
+{
+    return exclusive([&](LessDb& db)
+                     {
+                         return db.clear();
+                     });
+}
+
+/// Reads a value from database. Value is served from the cache of calling
+/// thread without any locking if the block hasn't been updated since it was cached.
+/// param [in] blockIndex         Block index.
+/// param [in] sectionIndex       Section index.
+/// param [in] parameterIndex     Parameter index.
+/// param [in, out] value         Reference to variable in which read value will be stored.
+/// returns: True on success, false otherwise.
+bool ConcurrentLessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t& value)
+{
+    Stripe&           blockStripe = stripe(blockIndex);
+    ThreadCacheEntry& entry       = threadCacheEntry(blockIndex, sectionIndex, parameterIndex);
+
+    if ((entry.instance == INSTANCE) &&
+        (entry.blockIndex == blockIndex) &&
+        (entry.sectionIndex == sectionIndex) &&
+        (entry.parameterIndex == parameterIndex) &&
+        (entry.databaseGeneration == _databaseGeneration.load(std::memory_order_acquire)) &&
+        (entry.stripeGeneration == blockStripe.generation.load(std::memory_order_acquire)))
+    {
+        _cacheHits.fetch_add(1, std::memory_order_relaxed);
+        value = entry.value;
+        return true;
+    }
+
+    _cacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_lock<std::shared_mutex> databaseLock(_databaseMutex);
+    std::shared_lock<std::shared_mutex> stripeLock(blockStripe.mutex);
+
+    if (!_db.read(blockIndex, sectionIndex, parameterIndex, value))
+    {
+        return false;
+    }
+
+    // generations can't change while the locks are held
+    entry.instance           = INSTANCE;
+    entry.databaseGeneration = _databaseGeneration.load(std::memory_order_acquire);
+    entry.stripeGeneration   = blockStripe.generation.load(std::memory_order_acquire);
+    entry.blockIndex         = blockIndex;
+    entry.sectionIndex       = sectionIndex;
+    entry.parameterIndex     = parameterIndex;
+    entry.value              = value;
+
+    return true;
+}
+
+/// Reads a value from database with reduced error checking.
+/// returns: Value from database. In case of read failure, 0 will be returned.
+uint32_t ConcurrentLessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+{
+    uint32_t value = 0;
+    read(blockIndex, sectionIndex, parameterIndex, value);
+    return value;
+}
+
+/// Updates value in database. Only the stripe to which the block is
+/// mapped is locked, so updates in other blocks proceed in parallel.
+/// param [in] blockIndex         Block index.
+/// param [in] sectionIndex       Section index.
+/// param [in] parameterIndex     Parameter index.
+/// param [in] newValue           New value for parameter.
+/// returns: True on success, false otherwise.
+bool ConcurrentLessDb::update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue)
+{
+    Stripe& blockStripe = stripe(blockIndex);
+
+    std::shared_lock<std::shared_mutex> databaseLock(_databaseMutex);
+    std::unique_lock<std::shared_mutex> stripeLock(blockStripe.mutex);
+
+    if (_compareBeforeWrite.load(std::memory_order_relaxed))
+    {
+        uint32_t currentValue;
+
+        if (!_db.read(blockIndex, sectionIndex, parameterIndex, currentValue))
+        {
+            return false;
+        }
+
+        // values with bits outside of parameter width are written anyway
+        if (currentValue == newValue)
+        {
+            _skippedWrites.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    InvalidateGuard guard(blockStripe.generation);
+
+    return _db.update(blockIndex, sectionIndex, parameterIndex, newValue);
+}
+
+void ConcurrentLessDb::setCompareBeforeWrite(compareBeforeWriteSetting_t setting)
+{
+    _compareBeforeWrite = setting == compareBeforeWriteSetting_t::ENABLE;
+}
+
+/// Returns the number of updates skipped because the stored value was unchanged.
+uint32_t ConcurrentLessDb::skippedWrites() const
+{
+    return _skippedWrites;
+}
+
+/// Returns the number of reads served from per-thread caches.
+uint32_t ConcurrentLessDb::cacheHits() const
+{
+    return _cacheHits;
+}
+
+/// Returns the number of reads which had to access the database.
+uint32_t ConcurrentLessDb::cacheMisses() const
+{
+    return _cacheMisses;
+}
+
+ConcurrentLessDb::Stripe& ConcurrentLessDb::stripe(size_t blockIndex)
+{
+    return _stripes[blockIndex % STRIPES];
+}
+
+/// Disables all settings of the database which keep state shared between the calls.
+/// Settings which are already disabled aren't set again, so that their state isn't reset
+/// on every exclusive access.
+void ConcurrentLessDb::applySettings()
+{
+    if (_db._readCacheSize)
+    {
+        _db.setReadCacheSize(0);
+    }
+
+    if (_db._compareBeforeWrite != compareBeforeWriteSetting_t::DISABLE)
+    {
+        _db.setCompareBeforeWrite(compareBeforeWriteSetting_t::DISABLE);
+    }
+
+    if (_db._shadowSetting != shadowSetting_t::DISABLE)
+    {
+        _db.setShadow(shadowSetting_t::DISABLE);
+    }
+
+    if (_db._verifyPolicy == verifyPolicy_t::DEFERRED)
+    {
+        _db.setVerifyPolicy(verifyPolicy_t::ALWAYS);
+    }
+
+    if (_db._lazyResetSetting != lazyResetSetting_t::DISABLE)
+    {
+        _db.setLazyReset(lazyResetSetting_t::DISABLE);
+    }
+
+    if (_db._combineSize)
+    {
+        _db.setWriteCombining(0);
+    }
+
+    if (_db._checkpointPageSize)
+    {
+        _db.setCheckpointPageSize(0);
+    }
+}
@@ -0,0 +1,612 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <string.h>
+#include "lib/lessdb/hwa_flash.h"
+
+using namespace lib::lessdb;
+
+namespace
+{
+    uint32_t readUint32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) |
+               (static_cast<uint32_t>(data[1]) << 8) |
+               (static_cast<uint32_t>(data[2]) << 16) |
+               (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    void writeUint32(uint8_t* data, uint32_t value)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            data[i] = value >> (8 * i);
+        }
+    }
+
+    /// CRC-8 with polynomial 0x07.
+    uint8_t crc8(uint8_t crc, const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            crc ^= data[i];
+
+            for (size_t bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+            }
+        }
+
+        return crc;
+    }
+}    // namespace
+
+size_t RamFlashPages::pageSize()
+{
+    return PAGE_SIZE;
+}
+
+size_t RamFlashPages::numberOfPages()
+{
+    return NUMBER_OF_PAGES;
+}
+
+bool RamFlashPages::erasePage(size_t page)
+{
+    if (page >= NUMBER_OF_PAGES)
+    {
+        return false;
+    }
+
+    memset(&_memory[page * PAGE_SIZE], 0xFF, PAGE_SIZE);
+    _eraseCount[page]++;
+
+    return true;
+}
+
+bool RamFlashPages::program(size_t page, size_t offset, const uint8_t* data, size_t size)
+{
+    if ((page >= NUMBER_OF_PAGES) || ((offset + size) > PAGE_SIZE))
+    {
+        return false;
+    }
+
+    uint8_t* memory = &_memory[(page * PAGE_SIZE) + offset];
+
+    for (size_t i = 0; i < size; i++)
+    {
+        // programming can only clear bits
+        if ((memory[i] & data[i]) != data[i])
+        {
+            return false;
+        }
+
+        memory[i] = data[i];
+    }
+
+    return true;
+}
+
+bool RamFlashPages::read(size_t page, size_t offset, uint8_t* data, size_t size)
+{
+    if ((page >= NUMBER_OF_PAGES) || ((offset + size) > PAGE_SIZE))
+    {
+        return false;
+    }
+
+    memcpy(data, &_memory[(page * PAGE_SIZE) + offset], size);
+    return true;
+}
+
+/// Returns the number of times specified page has been erased.
+uint32_t RamFlashPages::eraseCount(size_t page) const
+{
+    return page < NUMBER_OF_PAGES ? _eraseCount[page] : 0;
+}
+
+/// Checks the page geometry and rebuilds the RAM index from records stored in flash.
+/// All live data must fit into the pages other than the spare one, with at least
+/// one more page left for new records.
+/// returns: True on success, false if geometry isn't supported or flash content is damaged.
+bool HwaFlash::init()
+{
+    const size_t PAGE_SIZE = _pages.pageSize();
+    const size_t PAGES     = _pages.numberOfPages();
+
+    if ((PAGES < 3) || (PAGE_SIZE < (HEADER_SIZE + RECORD_SIZE)) || ((PAGE_SIZE - HEADER_SIZE) % RECORD_SIZE))
+    {
+        return false;
+    }
+
+    // address is stored in lower bits of record header
+    if (SIZE > (static_cast<uint32_t>(1) << ADDRESS_BITS))
+    {
+        return false;
+    }
+
+    const size_t RECORDS_PER_PAGE = (PAGE_SIZE - HEADER_SIZE) / RECORD_SIZE;
+    const size_t GROUPS           = (SIZE + RECORD_DATA_SIZE - 1) / RECORD_DATA_SIZE;
+
+    if (GROUPS > ((PAGES - 2) * RECORDS_PER_PAGE))
+    {
+        return false;
+    }
+
+    return mount();
+}
+
+uint32_t HwaFlash::size()
+{
+    return SIZE;
+}
+
+/// Erases all pages in use and starts a new log on the page following the current one.
+bool HwaFlash::clear()
+{
+    const size_t PAGES = _pages.numberOfPages();
+
+    for (size_t i = 0; i < _usedPages; i++)
+    {
+        if (!_pages.erasePage((_tailPage + i) % PAGES))
+        {
+            return false;
+        }
+    }
+
+    _index.assign(SIZE, NO_RECORD);
+    _usedPages = 0;
+    _tailPage  = (_headPage + 1) % PAGES;
+
+    return openPage(_tailPage);
+}
+
+bool HwaFlash::read(uint32_t address, uint32_t& value, sectionParameterType_t type)
+{
+    const size_t WIDTH = (type == sectionParameterType_t::WORD) ? 2 : (type == sectionParameterType_t::DWORD) ? 4 : 1;
+
+    if ((address + WIDTH) > SIZE)
+    {
+        return false;
+    }
+
+    value = 0;
+
+    for (size_t i = 0; i < WIDTH; i++)
+    {
+        uint8_t byte;
+
+        if (!readByte(address + i, byte))
+        {
+            return false;
+        }
+
+        value |= static_cast<uint32_t>(byte) << (8 * i);
+    }
+
+    return true;
+}
+
+bool HwaFlash::write(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    const size_t WIDTH = (type == sectionParameterType_t::WORD) ? 2 : (type == sectionParameterType_t::DWORD) ? 4 : 1;
+
+    uint8_t data[4];
+    writeUint32(data, value);
+
+    return writeRange(address, data, WIDTH);
+}
+
+bool HwaFlash::rangeAccessSupported()
+{
+    return true;
+}
+
+bool HwaFlash::readRange(uint32_t address, uint8_t* buffer, size_t size)
+{
+    if ((address + size) > SIZE)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (!readByte(address + i, buffer[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Appends the range as a sequence of records.
+/// Records never cross the boundary of RECORD_DATA_SIZE aligned groups,
+/// so that compaction can always move the live data of a page into a single page.
+bool HwaFlash::writeRange(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    if ((address + size) > SIZE)
+    {
+        return false;
+    }
+
+    while (size)
+    {
+        const size_t AVAILABLE = RECORD_DATA_SIZE - (address % RECORD_DATA_SIZE);
+        const size_t CHUNK     = size < AVAILABLE ? size : AVAILABLE;
+
+        if (!appendRecord(address, buffer, CHUNK))
+        {
+            return false;
+        }
+
+        address += CHUNK;
+        buffer += CHUNK;
+        size -= CHUNK;
+    }
+
+    return true;
+}
+
+/// Returns the number of pages compacted since initialization.
+uint32_t HwaFlash::compactions() const
+{
+    return _compactions;
+}
+
+/// Finds the pages in use, orders them by sequence number and replays their records.
+/// If no page is in use, flash is formatted. If no erased page is left, power was lost
+/// while the oldest page was compacted, so the compaction is completed.
+bool HwaFlash::mount()
+{
+    const size_t PAGES = _pages.numberOfPages();
+
+    std::vector<std::pair<uint32_t, size_t>> used;
+
+    for (size_t page = 0; page < PAGES; page++)
+    {
+        uint8_t header[HEADER_SIZE];
+
+        if (!_pages.read(page, 0, header, HEADER_SIZE))
+        {
+            return false;
+        }
+
+        if (readUint32(header) == PAGE_MAGIC)
+        {
+            used.emplace_back(readUint32(&header[4]), page);
+        }
+    }
+
+    std::sort(used.begin(), used.end());
+
+    // pages in use must follow each other in the ring
+    for (size_t i = 1; i < used.size(); i++)
+    {
+        if (used[i].second != ((used[0].second + i) % PAGES))
+        {
+            return false;
+        }
+    }
+
+    _index.assign(SIZE, NO_RECORD);
+    _usedPages = 0;
+
+    for (size_t page = 0; page < PAGES; page++)
+    {
+        const bool USED = std::find_if(used.begin(), used.end(), [page](const auto& entry)
+                                       {
+                                           return entry.second == page;
+                                       }) != used.end();
+
+        // free pages are expected to be erased, either by compaction or by previous format
+        if (!USED && !blankPage(page))
+        {
+            if (!_pages.erasePage(page))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (used.empty())
+    {
+        _sequence = 0;
+        _tailPage = 0;
+
+        return openPage(0);
+    }
+
+    for (const auto& entry : used)
+    {
+        if (!replayPage(entry.second))
+        {
+            return false;
+        }
+    }
+
+    _tailPage  = used.front().second;
+    _headPage  = used.back().second;
+    _sequence  = used.back().first;
+    _usedPages = used.size();
+
+    if (_usedPages == PAGES)
+    {
+        // groups already copied to the current page are indexed there, only the rest is copied
+        return compact();
+    }
+
+    return true;
+}
+
+/// Updates the index with all records stored in specified page
+/// and sets the write offset to the first free record in it.
+bool HwaFlash::replayPage(size_t page)
+{
+    const size_t PAGE_SIZE = _pages.pageSize();
+    size_t       offset    = HEADER_SIZE;
+
+    for (; (offset + RECORD_SIZE) <= PAGE_SIZE; offset += RECORD_SIZE)
+    {
+        uint8_t record[RECORD_SIZE];
+
+        if (!_pages.read(page, offset, record, RECORD_SIZE))
+        {
+            return false;
+        }
+
+        const uint32_t HEADER = readUint32(record);
+
+        if (HEADER == 0xFFFFFFFF)
+        {
+            // power could have been lost after the data was programmed, but before the header
+            if (std::all_of(&record[4], &record[RECORD_SIZE], [](uint8_t value)
+                            {
+                                return value == 0xFF;
+                            }))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        const uint32_t ADDRESS   = HEADER & ((static_cast<uint32_t>(1) << ADDRESS_BITS) - 1);
+        const size_t   DATA_SIZE = ((HEADER >> ADDRESS_BITS) & 0x03) + 1;
+
+        // damaged and partially programmed records are skipped
+        if ((record[3] != checksum(record, DATA_SIZE)) || ((ADDRESS + DATA_SIZE) > SIZE))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < DATA_SIZE; i++)
+        {
+            _index[ADDRESS + i] = (page * PAGE_SIZE) + offset + 4 + i;
+        }
+    }
+
+    _headOffset = offset;
+
+    return true;
+}
+
+/// Checks whether all bytes in specified page are erased.
+bool HwaFlash::blankPage(size_t page)
+{
+    const size_t PAGE_SIZE = _pages.pageSize();
+
+    uint8_t buffer[64];
+
+    for (size_t offset = 0; offset < PAGE_SIZE; offset += sizeof(buffer))
+    {
+        const size_t CHUNK = (PAGE_SIZE - offset) < sizeof(buffer) ? (PAGE_SIZE - offset) : sizeof(buffer);
+
+        if (!_pages.read(page, offset, buffer, CHUNK))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < CHUNK; i++)
+        {
+            if (buffer[i] != 0xFF)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/// Writes header to specified erased page and makes it the page to which records are appended.
+bool HwaFlash::openPage(size_t page)
+{
+    uint8_t header[HEADER_SIZE];
+
+    writeUint32(header, PAGE_MAGIC);
+    writeUint32(&header[4], ++_sequence);
+
+    if (!_pages.program(page, 0, header, HEADER_SIZE))
+    {
+        return false;
+    }
+
+    _headPage   = page;
+    _headOffset = HEADER_SIZE;
+    _usedPages++;
+
+    return true;
+}
+
+/// Switches to the next page in the ring. If only the spare page is left,
+/// live data from the oldest page is first compacted into it.
+bool HwaFlash::nextPage()
+{
+    const size_t PAGE_SIZE = _pages.pageSize();
+    const size_t PAGES     = _pages.numberOfPages();
+
+    for (size_t attempt = 0; attempt < PAGES; attempt++)
+    {
+        const bool SPARE_ONLY = (PAGES - _usedPages) == 1;
+
+        if (!openPage((_headPage + 1) % PAGES))
+        {
+            return false;
+        }
+
+        if (!SPARE_ONLY)
+        {
+            return true;
+        }
+
+        if (!compact())
+        {
+            return false;
+        }
+
+        if ((_headOffset + RECORD_SIZE) <= PAGE_SIZE)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Copies all groups of bytes whose latest value is stored in the oldest page
+/// to the current page and erases the oldest page.
+/// Current page must be empty, or hold only the groups copied by interrupted compaction.
+bool HwaFlash::compact()
+{
+    const size_t PAGE_SIZE = _pages.pageSize();
+    const size_t PAGES     = _pages.numberOfPages();
+
+    for (uint32_t group = 0; group < SIZE; group += RECORD_DATA_SIZE)
+    {
+        const size_t GROUP_SIZE = std::min<size_t>(RECORD_DATA_SIZE, SIZE - group);
+        bool         live       = false;
+
+        for (size_t i = 0; i < GROUP_SIZE; i++)
+        {
+            if ((_index[group + i] != NO_RECORD) && ((_index[group + i] / PAGE_SIZE) == _tailPage))
+            {
+                live = true;
+                break;
+            }
+        }
+
+        if (!live)
+        {
+            continue;
+        }
+
+        uint8_t data[RECORD_DATA_SIZE];
+
+        if (!readRange(group, data, GROUP_SIZE))
+        {
+            return false;
+        }
+
+        if (!programRecord(group, data, GROUP_SIZE))
+        {
+            return false;
+        }
+    }
+
+    if (!_pages.erasePage(_tailPage))
+    {
+        return false;
+    }
+
+    _tailPage = (_tailPage + 1) % PAGES;
+    _usedPages--;
+    _compactions++;
+
+    return true;
+}
+
+/// Appends a record to the current page, switching to the next page if current one is full.
+bool HwaFlash::appendRecord(uint32_t address, const uint8_t* data, size_t size)
+{
+    if ((_headOffset + RECORD_SIZE) > _pages.pageSize())
+    {
+        if (!nextPage())
+        {
+            return false;
+        }
+    }
+
+    return programRecord(address, data, size);
+}
+
+/// Programs a record at the current position in current page and updates the index.
+/// Current page must have room for the record.
+bool HwaFlash::programRecord(uint32_t address, const uint8_t* data, size_t size)
+{
+    uint8_t record[RECORD_SIZE];
+
+    memset(record, 0xFF, RECORD_SIZE);
+    writeUint32(record, address | ((size - 1) << ADDRESS_BITS));
+    memcpy(&record[4], data, size);
+    record[3] = checksum(record, size);
+
+    if (!_pages.program(_headPage, _headOffset, record, RECORD_SIZE))
+    {
+        return false;
+    }
+
+    const size_t LOCATION = (_headPage * _pages.pageSize()) + _headOffset + 4;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        _index[address + i] = LOCATION + i;
+    }
+
+    _headOffset += RECORD_SIZE;
+
+    return true;
+}
+
+/// Calculates the checksum of the record: address and size in the header and data bytes.
+/// Checksum is stored in the last byte of the header, so that record which hasn't been
+/// programmed entirely can be told apart from the valid one.
+uint8_t HwaFlash::checksum(const uint8_t* record, size_t size)
+{
+    return crc8(crc8(0, record, 3), &record[4], size);
+}
+
+/// Reads the latest value of specified byte.
+bool HwaFlash::readByte(uint32_t address, uint8_t& value)
+{
+    const uint32_t LOCATION = _index[address];
+
+    if (LOCATION == NO_RECORD)
+    {
+        value = 0;
+        return true;
+    }
+
+    const size_t PAGE_SIZE = _pages.pageSize();
+
+    return _pages.read(LOCATION / PAGE_SIZE, LOCATION % PAGE_SIZE, &value, 1);
+}
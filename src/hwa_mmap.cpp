@@ -0,0 +1,256 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lib/lessdb/hwa_mmap.h"
+
+using namespace lib::lessdb;
+
+HwaMmap::~HwaMmap()
+{
+    deinit();
+}
+
+/// Opens the file, creating it if needed, and maps it to memory.
+/// File shorter than the storage size is extended with zeros.
+/// returns: True on success, false otherwise.
+bool HwaMmap::init()
+{
+    if (_memory != nullptr)
+    {
+        return true;
+    }
+
+    _fd = open(PATH.c_str(), O_RDWR | O_CREAT, 0644);
+
+    if (_fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+
+    if ((fstat(_fd, &fileStat) != 0) ||
+        ((fileStat.st_size < static_cast<off_t>(SIZE)) && (ftruncate(_fd, SIZE) != 0)))
+    {
+        deinit();
+        return false;
+    }
+
+    void* memory = mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+    if (memory == MAP_FAILED)
+    {
+        deinit();
+        return false;
+    }
+
+    _memory = static_cast<uint8_t*>(memory);
+
+    if (POLICY == msyncPolicy_t::TIMER)
+    {
+        _stopSync   = false;
+        _syncThread = std::thread(&HwaMmap::syncLoop, this);
+    }
+
+    return true;
+}
+
+uint32_t HwaMmap::size()
+{
+    return SIZE;
+}
+
+bool HwaMmap::clear()
+{
+    if (_memory == nullptr)
+    {
+        return false;
+    }
+
+    memset(_memory, 0, SIZE);
+    return written(0, SIZE);
+}
+
+bool HwaMmap::read(uint32_t address, uint32_t& value, sectionParameterType_t type)
+{
+    const size_t WIDTH = (type == sectionParameterType_t::WORD) ? 2 : (type == sectionParameterType_t::DWORD) ? 4 : 1;
+
+    if ((_memory == nullptr) || ((address + WIDTH) > SIZE))
+    {
+        return false;
+    }
+
+    value = 0;
+
+    for (size_t i = 0; i < WIDTH; i++)
+    {
+        value |= static_cast<uint32_t>(_memory[address + i]) << (8 * i);
+    }
+
+    return true;
+}
+
+bool HwaMmap::write(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    const size_t WIDTH = (type == sectionParameterType_t::WORD) ? 2 : (type == sectionParameterType_t::DWORD) ? 4 : 1;
+
+    if ((_memory == nullptr) || ((address + WIDTH) > SIZE))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < WIDTH; i++)
+    {
+        _memory[address + i] = value >> (8 * i);
+    }
+
+    return written(address, WIDTH);
+}
+
+bool HwaMmap::rangeAccessSupported()
+{
+    return true;
+}
+
+bool HwaMmap::readRange(uint32_t address, uint8_t* buffer, size_t size)
+{
+    if ((_memory == nullptr) || ((address + size) > SIZE))
+    {
+        return false;
+    }
+
+    memcpy(buffer, &_memory[address], size);
+    return true;
+}
+
+bool HwaMmap::concurrentAccessSupported()
+{
+    return true;
+}
+
+uint32_t HwaMmap::milliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool HwaMmap::writeRange(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    if ((_memory == nullptr) || ((address + size) > SIZE))
+    {
+        return false;
+    }
+
+    memcpy(&_memory[address], buffer, size);
+    return written(address, size);
+}
+
+/// Synchronizes entire file with the mapped memory.
+/// returns: True on success, false otherwise.
+bool HwaMmap::flush()
+{
+    if (_memory == nullptr)
+    {
+        return false;
+    }
+
+    _dirty = false;
+    return sync(0, SIZE);
+}
+
+/// Returns the number of msync calls made so far.
+uint32_t HwaMmap::syncCount() const
+{
+    return _syncCount;
+}
+
+/// Applies synchronization policy once the specified range has been written.
+bool HwaMmap::written(uint32_t address, size_t size)
+{
+    if (POLICY == msyncPolicy_t::EVERY_WRITE)
+    {
+        return sync(address, size);
+    }
+
+    _dirty = true;
+    return true;
+}
+
+/// Synchronizes the pages holding specified range with the file.
+bool HwaMmap::sync(uint32_t address, size_t size)
+{
+    static const size_t PAGE_SIZE = sysconf(_SC_PAGESIZE);
+
+    // msync requires page-aligned address
+    const size_t START = address - (address % PAGE_SIZE);
+
+    _syncCount++;
+    return msync(_memory + START, (address + size) - START, MS_SYNC) == 0;
+}
+
+/// Periodically synchronizes the file while the storage is mapped.
+void HwaMmap::syncLoop()
+{
+    std::unique_lock<std::mutex> lock(_syncMutex);
+
+    while (!_stopSync)
+    {
+        _syncCondition.wait_for(lock, std::chrono::milliseconds(SYNC_PERIOD_MS));
+
+        if (_dirty.exchange(false))
+        {
+            sync(0, SIZE);
+        }
+    }
+}
+
+/// Stops synchronization thread, unmaps the memory and closes the file.
+void HwaMmap::deinit()
+{
+    if (_syncThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_syncMutex);
+            _stopSync = true;
+        }
+
+        _syncCondition.notify_all();
+        _syncThread.join();
+    }
+
+    if (_memory != nullptr)
+    {
+        munmap(_memory, SIZE);
+        _memory = nullptr;
+    }
+
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+}
@@ -0,0 +1,388 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include "lib/lessdb/hwa_trace.h"
+
+using namespace lib::lessdb;
+
+namespace
+{
+    /// Maximum size of a record without range data: operation byte and three variable-length integers.
+    constexpr size_t MAX_RECORD_SIZE = 1 + 10 + 5 + 5;
+
+    size_t putVarint(uint8_t* buffer, uint64_t value)
+    {
+        size_t size = 0;
+
+        while (value >= 0x80)
+        {
+            buffer[size++] = (value & 0x7F) | 0x80;
+            value >>= 7;
+        }
+
+        buffer[size++] = value;
+        return size;
+    }
+
+    bool getVarint(const uint8_t* trace, size_t size, size_t& offset, uint64_t& value)
+    {
+        value = 0;
+
+        for (uint8_t shift = 0; shift < 64; shift += 7)
+        {
+            if (offset >= size)
+            {
+                return false;
+            }
+
+            const uint8_t BYTE = trace[offset++];
+
+            value |= static_cast<uint64_t>(BYTE & 0x7F) << shift;
+
+            if (!(BYTE & 0x80))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint32_t getDword(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) |
+               (static_cast<uint32_t>(data[1]) << 8) |
+               (static_cast<uint32_t>(data[2]) << 16) |
+               (static_cast<uint32_t>(data[3]) << 24);
+    }
+}    // namespace
+
+FileTraceOutput::FileTraceOutput(const std::string& path)
+    : _file(fopen(path.c_str(), "ab"))
+{}
+
+FileTraceOutput::~FileTraceOutput()
+{
+    if (_file != nullptr)
+    {
+        fclose(_file);
+    }
+}
+
+bool FileTraceOutput::isOpen() const
+{
+    return _file != nullptr;
+}
+
+bool FileTraceOutput::write(const uint8_t* data, size_t size)
+{
+    return (_file != nullptr) && (fwrite(data, 1, size, _file) == size);
+}
+
+bool MemoryTraceOutput::write(const uint8_t* data, size_t size)
+{
+    _data.insert(_data.end(), data, data + size);
+    return true;
+}
+
+bool HwaTrace::init()
+{
+    const bool RESULT = _hwa.init();
+
+    record(traceOperation_t::INIT, sectionParameterType_t::BYTE, RESULT, 0, 0);
+    return RESULT;
+}
+
+uint32_t HwaTrace::size()
+{
+    return _hwa.size();
+}
+
+bool HwaTrace::clear()
+{
+    const bool RESULT = _hwa.clear();
+
+    record(traceOperation_t::CLEAR, sectionParameterType_t::BYTE, RESULT, 0, 0);
+    return RESULT;
+}
+
+bool HwaTrace::read(uint32_t address, uint32_t& value, sectionParameterType_t type)
+{
+    const bool RESULT = _hwa.read(address, value, type);
+
+    record(traceOperation_t::READ, type, RESULT, address, RESULT ? value : 0);
+    return RESULT;
+}
+
+bool HwaTrace::write(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    const bool RESULT = _hwa.write(address, value, type);
+
+    record(traceOperation_t::WRITE, type, RESULT, address, value);
+    return RESULT;
+}
+
+bool HwaTrace::rangeAccessSupported()
+{
+    return _hwa.rangeAccessSupported();
+}
+
+uint32_t HwaTrace::milliseconds()
+{
+    return _hwa.milliseconds();
+}
+
+bool HwaTrace::readRange(uint32_t address, uint8_t* buffer, size_t size)
+{
+    if (!_hwa.rangeAccessSupported())
+    {
+        // record single byte reads made by default implementation instead
+        return Hwa::readRange(address, buffer, size);
+    }
+
+    const bool RESULT = _hwa.readRange(address, buffer, size);
+
+    record(traceOperation_t::READ_RANGE, sectionParameterType_t::BYTE, RESULT, address, size);
+    return RESULT;
+}
+
+bool HwaTrace::writeRange(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    if (!_hwa.rangeAccessSupported())
+    {
+        return Hwa::writeRange(address, buffer, size);
+    }
+
+    const bool RESULT = _hwa.writeRange(address, buffer, size);
+
+    record(traceOperation_t::WRITE_RANGE, sectionParameterType_t::BYTE, RESULT, address, size, buffer);
+    return RESULT;
+}
+
+/// Returns the number of records written so far.
+uint32_t HwaTrace::records() const
+{
+    return _records;
+}
+
+/// Appends a single record to the trace.
+/// param [in] operation    Traced operation.
+/// param [in] type         Parameter type, used for single value reads and writes.
+/// param [in] result       Result of the operation.
+/// param [in] address      Accessed address.
+/// param [in] value        Read or written value, or size of the range.
+/// param [in] data         Written bytes for range writes, nullptr otherwise.
+void HwaTrace::record(traceOperation_t operation, sectionParameterType_t type, bool result, uint32_t address, uint32_t value, const uint8_t* data)
+{
+    const uint64_t NOW = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    if (!_headerWritten)
+    {
+        const uint32_t SIZE                = _hwa.size();
+        uint8_t        header[HEADER_SIZE] = {
+            static_cast<uint8_t>(MAGIC),
+            static_cast<uint8_t>(MAGIC >> 8),
+            static_cast<uint8_t>(MAGIC >> 16),
+            static_cast<uint8_t>(MAGIC >> 24),
+            VERSION,
+            static_cast<uint8_t>(SIZE),
+            static_cast<uint8_t>(SIZE >> 8),
+            static_cast<uint8_t>(SIZE >> 16),
+            static_cast<uint8_t>(SIZE >> 24),
+        };
+
+        _headerWritten = _output.write(header, HEADER_SIZE);
+        _lastTimestamp = NOW;
+    }
+
+    uint8_t buffer[MAX_RECORD_SIZE];
+    size_t  size = 0;
+
+    buffer[size++] = static_cast<uint8_t>(operation) | (static_cast<uint8_t>(type) << 4) | (result ? 0 : 0x80);
+    size += putVarint(&buffer[size], NOW - _lastTimestamp);
+
+    switch (operation)
+    {
+    case traceOperation_t::READ:
+    case traceOperation_t::WRITE:
+    case traceOperation_t::READ_RANGE:
+    case traceOperation_t::WRITE_RANGE:
+    {
+        size += putVarint(&buffer[size], address);
+        size += putVarint(&buffer[size], value);
+    }
+    break;
+
+    default:
+        break;
+    }
+
+    _lastTimestamp = NOW;
+    _records++;
+    _output.write(buffer, size);
+
+    if (data != nullptr)
+    {
+        _output.write(data, value);
+    }
+}
+
+/// Retrieves the size of traced storage.
+/// param [in] trace            Trace contents.
+/// param [in] size             Size of the trace in bytes.
+/// param [out] storageSize     Size of traced storage in bytes.
+/// returns: True if trace header is valid, false otherwise.
+bool TraceReplay::storageSize(const uint8_t* trace, size_t size, uint32_t& storageSize)
+{
+    if ((size < HwaTrace::HEADER_SIZE) || (getDword(trace) != HwaTrace::MAGIC) || (trace[4] != HwaTrace::VERSION))
+    {
+        return false;
+    }
+
+    storageSize = getDword(&trace[5]);
+    return true;
+}
+
+/// Performs all operations recorded in the trace on specified storage, as fast as possible.
+/// param [in] trace        Trace contents.
+/// param [in] size         Size of the trace in bytes.
+/// param [in] hwa          Storage on which to perform the operations.
+/// param [out] result      Counters of replayed operations.
+/// returns: True if entire trace has been replayed, false if trace is malformed
+///          or holds a range outside of the traced storage.
+bool TraceReplay::replay(const uint8_t* trace, size_t size, Hwa& hwa, ReplayResult& result)
+{
+    uint32_t storageSize;
+
+    result = {};
+
+    if (!TraceReplay::storageSize(trace, size, storageSize))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    size_t               offset = HwaTrace::HEADER_SIZE;
+
+    while (offset < size)
+    {
+        const uint8_t HEADER    = trace[offset++];
+        const auto    OPERATION = static_cast<traceOperation_t>(HEADER & 0x0F);
+        const auto    TYPE      = static_cast<sectionParameterType_t>((HEADER >> 4) & 0x07);
+        const bool    TRACED    = !(HEADER & 0x80);
+        uint64_t      delta;
+        uint64_t      address = 0;
+        uint64_t      value   = 0;
+        bool          replayed;
+
+        if ((OPERATION >= traceOperation_t::AMOUNT) || !getVarint(trace, size, offset, delta))
+        {
+            return false;
+        }
+
+        if ((OPERATION != traceOperation_t::INIT) && (OPERATION != traceOperation_t::CLEAR))
+        {
+            if (!getVarint(trace, size, offset, address) || !getVarint(trace, size, offset, value))
+            {
+                return false;
+            }
+        }
+
+        // size of the range is checked before the buffer for it is allocated
+        if ((OPERATION == traceOperation_t::READ_RANGE) || (OPERATION == traceOperation_t::WRITE_RANGE))
+        {
+            if ((address > storageSize) || (value > (storageSize - address)))
+            {
+                return false;
+            }
+        }
+
+        switch (OPERATION)
+        {
+        case traceOperation_t::INIT:
+        {
+            replayed = hwa.init();
+        }
+        break;
+
+        case traceOperation_t::CLEAR:
+        {
+            replayed = hwa.clear();
+        }
+        break;
+
+        case traceOperation_t::READ:
+        {
+            uint32_t readValue = 0;
+
+            replayed = hwa.read(address, readValue, TYPE);
+            result.bytesRead += (TYPE == sectionParameterType_t::WORD) ? 2 : (TYPE == sectionParameterType_t::DWORD) ? 4 : 1;
+
+            if (replayed && TRACED && (readValue != value))
+            {
+                result.mismatches++;
+            }
+        }
+        break;
+
+        case traceOperation_t::WRITE:
+        {
+            replayed = hwa.write(address, value, TYPE);
+            result.bytesWritten += (TYPE == sectionParameterType_t::WORD) ? 2 : (TYPE == sectionParameterType_t::DWORD) ? 4 : 1;
+        }
+        break;
+
+        case traceOperation_t::READ_RANGE:
+        {
+            buffer.resize(value);
+            replayed = hwa.readRange(address, buffer.data(), value);
+            result.bytesRead += value;
+        }
+        break;
+
+        default:
+        {
+            // case traceOperation_t::WRITE_RANGE:
+            if ((size - offset) < value)
+            {
+                return false;
+            }
+
+            replayed = hwa.writeRange(address, &trace[offset], value);
+            result.bytesWritten += value;
+            offset += value;
+        }
+        break;
+        }
+
+        if (replayed != TRACED)
+        {
+            result.failures++;
+        }
+
+        result.operations[static_cast<uint8_t>(OPERATION)]++;
+        result.tracedUs += delta;
+    }
+
+    return true;
+}
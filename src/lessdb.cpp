@@ -20,200 +20,449 @@
     IN THE SOFTWARE.
 */
 
+#include <algorithm>
+#include <functional>
 #include <stdlib.h>
+#include <string.h>
 #include "lib/lessdb/lessdb.h"
 
 using namespace lib::lessdb;
 
-#define LAYOUT_ACCESS (*_layout)
-
-bool LessDb::init()
-{
-    return _hwa.init();
-}
-
-/// Calculates all addresses for specified blocks and sections.
-/// param [in] layout           Reference to database structure.
-/// param [in] startAddress     Address from which to start indexing blocks.
-///                             Set to 0 by default.
-/// returns: True on success, false otherwise.
-bool LessDb::setLayout(std::vector<Block>& layout, uint32_t startAddress)
+namespace
 {
-    if (startAddress >= _hwa.size())
+    /// Kinds of runs in database image.
+    enum class imageRun_t : uint8_t
     {
-        return false;
-    }
-
-    _initialAddress   = startAddress;
-    _memoryUsage      = 0;
-    _memoryParameters = 0;
+        DEFAULT,    ///< Bytes which hold their default values, stored without payload.
+        LITERAL,    ///< Bytes stored as they are.
+        REPEAT,     ///< Single byte repeated, stored once.
+    };
 
-    if (!layout.size())
-    {
-        return false;
-    }
+    /// Maximum number of bytes in single literal run.
+    constexpr size_t IMAGE_MAX_LITERAL = 64;
 
-    _layout = &layout;
+    /// Maximum size of encoded run header.
+    constexpr size_t IMAGE_MAX_RUN_HEADER = 10;
 
-    for (size_t block = 0; block < LAYOUT_ACCESS.size(); block++)
+    /// Encodes database content into runs. Each run starts with a variable-length integer
+    /// holding the run length shifted left by two bits and the kind of the run in the lowest
+    /// two bits, followed by the bytes of literal run or the byte of repeat run.
+    class ImageEncoder
     {
-        uint32_t blockUsage = 0;
-
-        for (size_t section = 0; section < LAYOUT_ACCESS[block]._sections.size(); section++)
+        public:
+        using output_t = std::function<bool(const uint8_t* data, size_t size)>;
+
+        ImageEncoder(output_t output)
+            : _output(std::move(output))
+        {}
+
+        /// Appends single byte of database content.
+        /// param [in] byte         Stored byte.
+        /// param [in] defaultByte  Byte as it would be stored if all parameters held their default values.
+        /// returns: True on success, false if writing the output fails.
+        bool append(uint8_t byte, uint8_t defaultByte)
         {
-            if (section == 0)
+            if (byte == defaultByte)
             {
-                // first section address is always 0
-                LAYOUT_ACCESS[block]._sections[section]._address = 0;
+                if (_length && (_run == imageRun_t::DEFAULT))
+                {
+                    _length++;
+                    return true;
+                }
+
+                return startRun(imageRun_t::DEFAULT, byte);
             }
-            else
+
+            if (_length && (_run == imageRun_t::REPEAT) && (byte == _literal[0]))
             {
-                size_t lastSection = section - 1;
+                _length++;
+                return true;
+            }
 
-                switch (LAYOUT_ACCESS[block]._sections[lastSection].PARAMETER_TYPE)
-                {
-                case sectionParameterType_t::BIT:
+            if (_length && (_run == imageRun_t::LITERAL))
+            {
+                // three equal bytes are stored as repeat run instead
+                if ((_length >= 2) && (_literal[_length - 1] == byte) && (_literal[_length - 2] == byte))
                 {
-                    LAYOUT_ACCESS[block]._sections[section]._address =
-                        (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS % 8 != 0) +
-                        (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS / 8) +
-                        LAYOUT_ACCESS[block]._sections[lastSection]._address;
-                }
-                break;
+                    _length -= 2;
 
-                case sectionParameterType_t::BYTE:
-                {
-                    LAYOUT_ACCESS[block]._sections[section]._address =
-                        LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS +
-                        LAYOUT_ACCESS[block]._sections[lastSection]._address;
-                }
-                break;
+                    if (!startRun(imageRun_t::REPEAT, byte))
+                    {
+                        return false;
+                    }
 
-                case sectionParameterType_t::HALF_BYTE:
-                {
-                    LAYOUT_ACCESS[block]._sections[section]._address =
-                        (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS % 2 != 0) +
-                        (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS / 2) +
-                        LAYOUT_ACCESS[block]._sections[lastSection]._address;
+                    _length = 3;
+                    return true;
                 }
-                break;
 
-                case sectionParameterType_t::WORD:
+                if (_length < IMAGE_MAX_LITERAL)
                 {
-                    LAYOUT_ACCESS[block]._sections[section]._address =
-                        2 * LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS +
-                        LAYOUT_ACCESS[block]._sections[lastSection]._address;
+                    _literal[_length++] = byte;
+                    return true;
                 }
-                break;
+            }
 
-                default:
-                {
-                    // case sectionParameterType_t::dword:
-                    LAYOUT_ACCESS[block]._sections[section]._address =
-                        4 * LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS +
-                        LAYOUT_ACCESS[block]._sections[lastSection]._address;
-                }
-                break;
-                }
+            return startRun(imageRun_t::LITERAL, byte);
+        }
+
+        /// Writes the last run and all buffered output.
+        bool finish()
+        {
+            return endRun() && flush();
+        }
+
+        private:
+        output_t   _output;
+        imageRun_t _run                                                    = imageRun_t::DEFAULT;
+        uint32_t   _length                                                 = 0;
+        uint8_t    _literal[IMAGE_MAX_LITERAL]                             = {};
+        uint8_t    _buffer[(IMAGE_MAX_RUN_HEADER + IMAGE_MAX_LITERAL) * 2] = {};
+        size_t     _size                                                   = 0;
+
+        bool startRun(imageRun_t run, uint8_t byte)
+        {
+            if (!endRun())
+            {
+                return false;
+            }
+
+            _run        = run;
+            _literal[0] = byte;
+            _length     = 1;
+
+            return true;
+        }
+
+        bool endRun()
+        {
+            if (!_length)
+            {
+                return true;
+            }
+
+            if (((_size + IMAGE_MAX_RUN_HEADER + IMAGE_MAX_LITERAL) > sizeof(_buffer)) && !flush())
+            {
+                return false;
+            }
+
+            uint64_t header = (static_cast<uint64_t>(_length) << 2) | static_cast<uint8_t>(_run);
+
+            while (header >= 0x80)
+            {
+                _buffer[_size++] = (header & 0x7F) | 0x80;
+                header >>= 7;
+            }
+
+            _buffer[_size++] = header;
+
+            if (_run == imageRun_t::LITERAL)
+            {
+                memcpy(&_buffer[_size], _literal, _length);
+                _size += _length;
+            }
+            else if (_run == imageRun_t::REPEAT)
+            {
+                _buffer[_size++] = _literal[0];
             }
 
-            _memoryParameters += LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS;
+            _length = 0;
+            return true;
+        }
+
+        bool flush()
+        {
+            bool result = !_size || _output(_buffer, _size);
+
+            _size = 0;
+            return result;
+        }
+    };
+
+    /// Decodes runs created by ImageEncoder.
+    class ImageDecoder
+    {
+        public:
+        ImageDecoder(const uint8_t* data, size_t size)
+            : _data(data)
+            , _size(size)
+        {}
+
+        /// Retrieves next byte of database content.
+        /// param [in] defaultByte  Byte as it would be stored if all parameters held their default values.
+        /// param [out] byte        Decoded byte.
+        /// returns: True on success, false if image is malformed.
+        bool next(uint8_t defaultByte, uint8_t& byte)
+        {
+            if (!_remaining && !startRun())
+            {
+                return false;
+            }
 
-            switch (LAYOUT_ACCESS[block]._sections[section].PARAMETER_TYPE)
+            switch (_run)
             {
-            case sectionParameterType_t::BIT:
+            case imageRun_t::DEFAULT:
             {
-                blockUsage += (((LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS % 8 != 0) +
-                                LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS / 8));
+                byte = defaultByte;
             }
             break;
 
-            case sectionParameterType_t::HALF_BYTE:
+            case imageRun_t::LITERAL:
             {
-                blockUsage += (((LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS % 2 != 0) +
-                                LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS / 2));
+                byte = _data[_offset++];
             }
             break;
 
-            case sectionParameterType_t::BYTE:
-            case sectionParameterType_t::WORD:
-            case sectionParameterType_t::DWORD:
             default:
             {
-                const size_t MULTIPLIER = (LAYOUT_ACCESS[block]._sections[section].PARAMETER_TYPE == sectionParameterType_t::BYTE)
-                                              ? 1
-                                          : (LAYOUT_ACCESS[block]._sections[section].PARAMETER_TYPE == sectionParameterType_t::WORD)
-                                              ? 2     // word
-                                              : 4;    // dword
-
-                blockUsage += (MULTIPLIER * LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS);
+                byte = _value;
             }
             break;
             }
-        }
 
-        _memoryUsage += blockUsage;
+            _remaining--;
+            return true;
+        }
 
-        if (_memoryUsage >= _hwa.size())
+        /// Checks whether all runs have been decoded entirely.
+        bool done() const
         {
-            return false;
+            return !_remaining && (_offset == _size);
         }
 
-        size_t lastSection = LAYOUT_ACCESS[block]._sections.size() - 1;
+        private:
+        const uint8_t* _data;
+        const size_t   _size;
+        size_t         _offset    = 0;
+        imageRun_t     _run       = imageRun_t::DEFAULT;
+        uint64_t       _remaining = 0;
+        uint8_t        _value     = 0;
 
-        if (block == 0)
+        bool startRun()
         {
-            LAYOUT_ACCESS[block]._address = _initialAddress;
-        }
+            uint64_t header = 0;
 
-        _nextBlockAddress = LAYOUT_ACCESS[block]._address + LAYOUT_ACCESS[block]._sections[lastSection]._address;
+            for (uint8_t shift = 0;; shift += 7)
+            {
+                if ((_offset >= _size) || (shift >= 64))
+                {
+                    return false;
+                }
 
-        switch (LAYOUT_ACCESS[block]._sections[lastSection].PARAMETER_TYPE)
-        {
-        case sectionParameterType_t::BIT:
-        {
-            _nextBlockAddress +=
-                (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS % 8 != 0) +
-                (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS / 8);
-        }
-        break;
+                const uint8_t BYTE = _data[_offset++];
 
-        case sectionParameterType_t::BYTE:
-        {
-            _nextBlockAddress += LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS;
-        }
-        break;
+                header |= static_cast<uint64_t>(BYTE & 0x7F) << shift;
 
-        case sectionParameterType_t::HALF_BYTE:
-        {
-            _nextBlockAddress +=
-                (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS % 2 != 0) +
-                (LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS / 2);
-        }
-        break;
+                if (!(BYTE & 0x80))
+                {
+                    break;
+                }
+            }
 
-        case sectionParameterType_t::WORD:
-        {
-            _nextBlockAddress +=
-                2 * LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS;
+            _run       = static_cast<imageRun_t>(header & 0x03);
+            _remaining = header >> 2;
+
+            if (!_remaining || (_run > imageRun_t::REPEAT))
+            {
+                return false;
+            }
+
+            if (_run == imageRun_t::REPEAT)
+            {
+                if (_offset >= _size)
+                {
+                    return false;
+                }
+
+                _value = _data[_offset++];
+            }
+            else if ((_run == imageRun_t::LITERAL) && (_remaining > (_size - _offset)))
+            {
+                return false;
+            }
+
+            return true;
         }
-        break;
+    };
+}    // namespace
+
+bool LessDb::init()
+{
+    return _hwa.init();
+}
+
+/// Calculates all addresses for specified blocks and sections.
+/// Layout is flattened into a table of section descriptors so that
+/// parameter access doesn't have to walk the layout.
+/// param [in] layout           Reference to database structure.
+/// param [in] startAddress     Address from which to start indexing blocks.
+///                             Set to 0 by default.
+/// If shadowing is enabled, pending changes are flushed first and
+/// the shadow is reloaded for the new layout.
+/// returns: True on success, false otherwise.
+bool LessDb::setLayout(std::vector<Block>& layout, uint32_t startAddress)
+{
+    // descriptor storage is about to be rebuilt
+    _descriptorTable = nullptr;
+    _blockTable      = nullptr;
+    _numberOfBlocks  = 0;
+    _descriptors.clear();
+    _blockIndex.clear();
+
+    if (!layout.size())
+    {
+        // previous layout is still released, so that its shadow and pending changes don't outlive it
+        releaseLayout();
+        return false;
+    }
+
+    size_t totalSections = 0;
+
+    for (size_t block = 0; block < layout.size(); block++)
+    {
+        totalSections += layout[block]._sections.size();
+    }
+
+    _descriptors.reserve(totalSections);
+    _blockIndex.reserve(layout.size() + 1);
+
+    uint32_t address = startAddress;
+
+    for (size_t block = 0; block < layout.size(); block++)
+    {
+        _blockIndex.push_back(_descriptors.size());
 
-        default:
+        for (size_t section = 0; section < layout[block]._sections.size(); section++)
         {
-            // case sectionParameterType_t::DWORD:
-            _nextBlockAddress +=
-                4 * LAYOUT_ACCESS[block]._sections[lastSection].NUMBER_OF_PARAMETERS;
-        }
-        break;
+            const Section& currentSection = layout[block]._sections[section];
+
+            // use values from vector only when its size matches the amount of parameters
+            const bool USE_VALUES = currentSection.DEFAULT_VALUES.size() == currentSection.NUMBER_OF_PARAMETERS;
+
+            _descriptors.push_back(makeDescriptor(address,
+                                                  currentSection.NUMBER_OF_PARAMETERS,
+                                                  currentSection.PARAMETER_TYPE,
+                                                  currentSection.PRESERVE_ON_PARTIAL_RESET,
+                                                  currentSection.AUTO_INCREMENT,
+                                                  currentSection.DEFAULT_VALUE,
+                                                  USE_VALUES ? currentSection.DEFAULT_VALUES.data() : nullptr));
+
+            address += sectionSize(currentSection.PARAMETER_TYPE, currentSection.NUMBER_OF_PARAMETERS);
         }
+    }
+
+    _blockIndex.push_back(_descriptors.size());
+
+    return applyLayout(_descriptors.data(), _blockIndex.data(), layout.size(), startAddress);
+}
+
+/// Activates specified table of section descriptors.
+/// param [in] descriptors      Descriptors for all sections in all blocks.
+/// param [in] blockIndex       Index of the first section descriptor for each block,
+///                             followed by the total number of sections.
+/// param [in] numberOfBlocks   Total number of blocks.
+/// param [in] startAddress     Address from which the layout starts.
+/// returns: True on success, false otherwise.
+bool LessDb::applyLayout(const SectionDescriptor* descriptors, const size_t* blockIndex, size_t numberOfBlocks, uint32_t startAddress)
+{
+    if (!releaseLayout())
+    {
+        return false;
+    }
+
+    _initialAddress = startAddress;
 
-        if (block < (LAYOUT_ACCESS.size() - 1))
+    if (startAddress >= _hwa.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < blockIndex[numberOfBlocks]; i++)
+    {
+        _memoryUsage += sectionSize(descriptors[i].type, descriptors[i].numberOfParameters);
+        _memoryParameters += descriptors[i].numberOfParameters;
+    }
+
+    if ((_initialAddress + _memoryUsage) > _hwa.size())
+    {
+        return false;
+    }
+
+    if ((_headerSetting == headerSetting_t::ENABLE) && headerOverlaps(_initialAddress, _memoryUsage))
+    {
+        return false;
+    }
+
+    if (_lazyResetSetting == lazyResetSetting_t::ENABLE)
+    {
+        const uint32_t MAP_SIZE = (blockIndex[numberOfBlocks] + 7) / 8;
+
+        if (((_lazyResetAddress + MAP_SIZE) > _hwa.size()) ||
+            ((_lazyResetAddress < (_initialAddress + _memoryUsage)) && (_initialAddress < (_lazyResetAddress + MAP_SIZE))))
         {
-            LAYOUT_ACCESS[block + 1]._address = _nextBlockAddress;
+            return false;
         }
     }
 
+    _descriptorTable  = descriptors;
+    _blockTable       = blockIndex;
+    _numberOfBlocks   = numberOfBlocks;
+    _nextBlockAddress = _initialAddress + _memoryUsage;
+
+    _stats.setSections(numberOfSections());
+    resetCheckpointPages();
+
+    _layoutHash = hashLayout(descriptors, blockIndex, numberOfBlocks, startAddress);
+
+    if ((_lazyResetSetting == lazyResetSetting_t::ENABLE) && !loadDefaultedMap())
+    {
+        return false;
+    }
+
+    if ((_headerSetting == headerSetting_t::ENABLE) && !readHeader())
+    {
+        return false;
+    }
+
+    if (_shadowSetting == shadowSetting_t::ENABLE)
+    {
+        return loadShadow();
+    }
+
+    return true;
+}
+
+/// Writes pending changes of the active layout and deactivates it.
+/// Staged transaction and unfinished initialization are discarded.
+/// returns: True on success, false if writing pending changes fails, in which case
+///          the shadow is kept so that flushing can be retried.
+bool LessDb::releaseLayout()
+{
+    // staged and pending shadow changes belong to the previous layout
+    rollback();
+    _initProgress.active = false;
+
+    if (!flush())
+    {
+        return false;
+    }
+
+    _pendingVerifyCount = 0;
+    _shadow.clear();
+    _shadowDirty.clear();
+    resetReadCache();
+    _descriptorTable  = nullptr;
+    _blockTable       = nullptr;
+    _numberOfBlocks   = 0;
+    _initialAddress   = 0;
+    _memoryUsage      = 0;
+    _memoryParameters = 0;
+    _layoutHash       = 0;
+    _layoutStatus     = layoutStatus_t::UNKNOWN;
+    _defaultedMap.clear();
+    _defaultedSections = 0;
+    _checkpointDirty.clear();
+    _checkpointSequence = 0;
+
     return true;
 }
 
@@ -224,6 +473,8 @@ bool LessDb::setLayout(std::vector<Block>& layout, uint32_t startAddress)
 /// param [in] magicValue   Additional optional value which will be appended
 ///                         to calculated UID. If ommited, it is set to 0
 ///                         by default.
+/// UID is a simple sum, so different layouts can share it. To detect layout
+/// changes reliably, use database header (see setHeader()).
 uint16_t LessDb::layoutUid(std::vector<Block>& layout, uint16_t magicValue)
 {
     if (!layout.size())
@@ -248,6 +499,63 @@ uint16_t LessDb::layoutUid(std::vector<Block>& layout, uint16_t magicValue)
     return signature;
 }
 
+/// Calculates 32-bit FNV-1a hash of specified layout.
+/// Hash covers start address, block boundaries and all section properties
+/// which affect stored data: types, parameter counts, default values and
+/// preserve and auto-increment settings.
+/// param [in] descriptors      Descriptors for all sections in all blocks.
+/// param [in] blockIndex       Index of the first section descriptor for each block,
+///                             followed by the total number of sections.
+/// param [in] numberOfBlocks   Total number of blocks.
+/// param [in] startAddress     Address from which the layout starts.
+/// returns: Calculated hash.
+uint32_t LessDb::hashLayout(const SectionDescriptor* descriptors, const size_t* blockIndex, size_t numberOfBlocks, uint32_t startAddress)
+{
+    constexpr uint32_t FNV_OFFSET_BASIS = 2166136261;
+    constexpr uint32_t FNV_PRIME        = 16777619;
+
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    auto append = [&hash](uint32_t value)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            hash ^= (value >> (8 * i)) & 0xFF;
+            hash *= FNV_PRIME;
+        }
+    };
+
+    append(startAddress);
+    append(numberOfBlocks);
+
+    for (size_t block = 0; block < numberOfBlocks; block++)
+    {
+        append(blockIndex[block + 1] - blockIndex[block]);
+
+        for (size_t section = blockIndex[block]; section < blockIndex[block + 1]; section++)
+        {
+            const SectionDescriptor& descriptor = descriptors[section];
+
+            append(descriptor.numberOfParameters);
+            append(static_cast<uint32_t>(descriptor.type));
+            append(static_cast<uint32_t>(descriptor.preserveOnPartialReset));
+            append(static_cast<uint32_t>(descriptor.autoIncrement));
+            append(descriptor.defaultValue);
+            append(descriptor.defaultValues != nullptr);
+
+            if (descriptor.defaultValues != nullptr)
+            {
+                for (size_t parameter = 0; parameter < descriptor.numberOfParameters; parameter++)
+                {
+                    append(descriptor.defaultValues[parameter]);
+                }
+            }
+        }
+    }
+
+    return hash;
+}
+
 /// Reads a value from database.
 /// param [in] blockIndex         Block index.
 /// param [in] sectionIndex       Section index.
@@ -256,428 +564,2938 @@ uint16_t LessDb::layoutUid(std::vector<Block>& layout, uint16_t magicValue)
 /// returns: True on success.
 bool LessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t& value)
 {
+    auto timer = _stats.read();
+
     // sanity checks
-    if (!checkParameters(blockIndex, sectionIndex, parameterIndex))
+    const SectionDescriptor* descriptor = checkParameters(blockIndex, sectionIndex, parameterIndex);
+
+    if (descriptor == nullptr)
     {
         return false;
     }
 
-    bool     returnValue  = true;
-    uint32_t startAddress = LAYOUT_ACCESS[blockIndex]._address + LAYOUT_ACCESS[blockIndex]._sections[sectionIndex]._address;
-    uint8_t  arrayIndex;
+    return readParameter(*descriptor, parameterIndex, value);
+}
 
-    switch (LAYOUT_ACCESS[blockIndex]._sections[sectionIndex].PARAMETER_TYPE)
-    {
-    case sectionParameterType_t::BIT:
-    {
-        arrayIndex = parameterIndex >> 3;
-        startAddress += arrayIndex;
+/// Reads a value of parameter located in specified section.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index. Must be valid for specified section.
+/// param [in, out] value       Reference to variable in which read value will be stored.
+/// returns: True on success.
+bool LessDb::readParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t& value)
+{
+    return readParameter(descriptor, parameterIndex, parameterAddress(descriptor, parameterIndex), value);
+}
 
-        if (startAddress == _lastReadAddress)
-        {
-            value = static_cast<bool>(_lastReadValue & BIT_MASK[parameterIndex - (arrayIndex << 3)]);
-        }
-        else if (_hwa.read(startAddress, value, sectionParameterType_t::BIT))
-        {
-            _lastReadValue = value;
-            value          = static_cast<bool>(value & BIT_MASK[parameterIndex - (arrayIndex << 3)]);
-        }
-        else
-        {
-            returnValue = false;
-        }
+/// Reads a value of parameter whose address has already been calculated.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index. Must be valid for specified section.
+/// param [in] address          Address of the byte in which parameter is stored.
+/// param [in, out] value       Reference to variable in which read value will be stored.
+/// returns: True on success.
+bool LessDb::readParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t address, uint32_t& value)
+{
+    if (defaulted(&descriptor - _descriptorTable))
+    {
+        value = defaultValue(descriptor, parameterIndex);
+        return true;
     }
-    break;
 
-    case sectionParameterType_t::BYTE:
+    if (!readValue(address, value, descriptor.type))
     {
-        startAddress += parameterIndex;
-
-        if (_hwa.read(startAddress, value, sectionParameterType_t::BYTE))
-        {
-            // sanitize
-            value &= static_cast<int32_t>(0xFF);
-        }
-        else
-        {
-            returnValue = false;
-        }
+        return false;
     }
-    break;
 
+    // bit and half-byte values are extracted from the byte, other values are only sanitized
+    value = (value >> valueShift(descriptor, parameterIndex)) & descriptor.valueMask;
+
+    return true;
+}
+
+/// Reads a value from database with reduced error checking.
+/// param [in] blockIndex         Block index.
+/// param [in] sectionIndex       Section index.
+/// param [in] parameterIndex  Parameter index.
+/// returns: Value from database. In case of read failure, 0 will be returned.
+uint32_t LessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+{
+    uint32_t value = 0;
+    read(blockIndex, sectionIndex, parameterIndex, value);
+    return value;
+}
+
+/// Reads all parameters from specified section.
+/// param [in] blockIndex     Block index.
+/// param [in] sectionIndex   Section index.
+/// param [in, out] values    Array in which read values will be stored.
+/// param [in] size           Size of the values array. Must be at least the number of parameters in section.
+/// returns: True on success, false otherwise.
+bool LessDb::readSection(size_t blockIndex, size_t sectionIndex, uint32_t* values, size_t size)
+{
+    const SectionDescriptor* descriptor = checkParameters(blockIndex, sectionIndex, 0);
+
+    if ((descriptor == nullptr) || (size < descriptor->numberOfParameters))
+    {
+        return false;
+    }
+
+    return readParameters(*descriptor, 0, descriptor->numberOfParameters, values);
+}
+
+/// Reads a range of consecutive parameters from specified section.
+/// param [in] blockIndex     Block index.
+/// param [in] sectionIndex   Section index.
+/// param [in] first          Index of the first parameter to read.
+/// param [in] count          Number of parameters to read.
+/// param [in, out] values    Array of at least count elements in which read values will be stored.
+/// returns: True on success, false otherwise.
+bool LessDb::readRange(size_t blockIndex, size_t sectionIndex, size_t first, size_t count, uint32_t* values)
+{
+    if (!count)
+    {
+        return checkParameters(blockIndex, sectionIndex, first) != nullptr;
+    }
+
+    // checking the last parameter covers the first one as well
+    const SectionDescriptor* descriptor = checkParameters(blockIndex, sectionIndex, first + count - 1);
+
+    if ((descriptor == nullptr) || ((first + count) < first))
+    {
+        return false;
+    }
+
+    return readParameters(*descriptor, first, count, values);
+}
+
+/// Reads a range of consecutive parameters from specified section.
+/// Underlying bytes are fetched in chunks of RANGE_BUFFER_SIZE bytes and
+/// unpacked into values, so that each byte is read only once.
+/// param [in] descriptor     Descriptor of the section in which parameters are located.
+/// param [in] first          Index of the first parameter to read.
+/// param [in] count          Number of parameters to read. Range must be valid for specified section.
+/// param [in, out] values    Array in which read values will be stored.
+/// returns: True on success, false otherwise.
+bool LessDb::readParameters(const SectionDescriptor& descriptor, size_t first, size_t count, uint32_t* values)
+{
+    const uint8_t WIDTH = typeWidth(descriptor.type);
+
+    if ((WIDTH > 1) && !_hwa.rangeAccessSupported() && !shadowActive())
+    {
+        // reading word and dword values byte by byte would only increase the number of transactions
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!readParameter(descriptor, first + i, values[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const uint32_t END_ADDRESS = parameterAddress(descriptor, first + count - 1) + WIDTH;
+
+    uint8_t  buffer[RANGE_BUFFER_SIZE];
+    uint32_t bufferAddress = 0;
+    uint32_t bufferEnd     = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t   INDEX   = first + i;
+        const uint32_t ADDRESS = parameterAddress(descriptor, INDEX);
+
+        if ((ADDRESS + WIDTH) > bufferEnd)
+        {
+            const size_t CHUNK = (END_ADDRESS - ADDRESS) < RANGE_BUFFER_SIZE ? (END_ADDRESS - ADDRESS) : RANGE_BUFFER_SIZE;
+
+            if (!readBytes(ADDRESS, buffer, CHUNK))
+            {
+                return false;
+            }
+
+            bufferAddress = ADDRESS;
+            bufferEnd     = ADDRESS + CHUNK;
+        }
+
+        values[i] = unpackValue(descriptor, &buffer[ADDRESS - bufferAddress], INDEX);
+    }
+
+    return true;
+}
+
+/// Reads a range of bytes, either from RAM shadow if shadowing is enabled or from the storage.
+/// Bytes of sections which are at defaults are replaced with default content.
+/// Bytes staged in active transaction take precedence over the stored ones.
+/// param [in] address      Address from which to start reading.
+/// param [in, out] buffer  Buffer in which read bytes will be stored.
+/// param [in] size         Number of bytes to read.
+/// returns: True on success, false otherwise.
+bool LessDb::readBytes(uint32_t address, uint8_t* buffer, size_t size)
+{
+    if (shadowActive())
+    {
+        memcpy(buffer, &_shadow[address - _initialAddress], size);
+    }
+    else
+    {
+        _stats.hwaRangeRead();
+
+        if (!_hwa.readRange(address, buffer, size))
+        {
+            return false;
+        }
+    }
+
+    overlayDefaults(address, buffer, size);
+
+    // bytes waiting to be combined, and then bytes staged in active transaction,
+    // take precedence over the stored ones
+    overlayStaged(_combined, address, buffer, size);
+    overlayStaged(_transaction, address, buffer, size);
+
+    return true;
+}
+
+/// Updates value for specified block and section in database.
+/// If compare-before-write is enabled, storage isn't written to in case
+/// the parameter already holds the new value.
+/// param [in] blockIndex         Block index.
+/// param [in] sectionIndex       Section index.
+/// param [in] parameterIndex  Parameter index.
+/// param [in] newValue        New value for parameter.
+/// returns: True on success, false otherwise.
+bool LessDb::update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue)
+{
+    auto timer = _stats.update();
+
+    // sanity check
+    const SectionDescriptor* descriptor = checkParameters(blockIndex, sectionIndex, parameterIndex);
+
+    if (descriptor == nullptr)
+    {
+        return false;
+    }
+
+    return updateParameter(*descriptor, parameterIndex, newValue);
+}
+
+/// Updates value of parameter located in specified section.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index. Must be valid for specified section.
+/// param [in] newValue         New value for parameter.
+/// returns: True on success, false otherwise.
+bool LessDb::updateParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t newValue)
+{
+    return updateParameter(descriptor, parameterIndex, parameterAddress(descriptor, parameterIndex), newValue);
+}
+
+/// Updates value of parameter whose address has already been calculated.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index. Must be valid for specified section.
+/// param [in] address          Address of the byte in which parameter is stored.
+/// param [in] newValue         New value for parameter.
+/// returns: True on success, false otherwise.
+bool LessDb::updateParameter(const SectionDescriptor& descriptor, size_t parameterIndex, uint32_t address, uint32_t newValue)
+{
+    const uint32_t ADDRESS = address;
+    const size_t   SECTION = &descriptor - _descriptorTable;
+
+    // sanitize input
+    newValue &= descriptor.valueMask;
+
+    if (defaulted(SECTION))
+    {
+        // section stays at defaults as long as no value is changed
+        if (skipWrite(defaultValue(descriptor, parameterIndex), newValue))
+        {
+            return true;
+        }
+
+        if (!materializeSection(SECTION))
+        {
+            return false;
+        }
+    }
+
+    switch (descriptor.type)
+    {
+    case sectionParameterType_t::BIT:
     case sectionParameterType_t::HALF_BYTE:
     {
-        startAddress += parameterIndex / 2;
+        uint32_t arrayValue;
+
+        // read existing value first
+        if (!readValue(ADDRESS, arrayValue, descriptor.type))
+        {
+            return false;
+        }
+
+        const uint32_t OLD_VALUE = arrayValue & 0xFF;
+        const uint8_t  SHIFT     = valueShift(descriptor, parameterIndex);
+
+        // clear the old content and update the value
+        arrayValue = OLD_VALUE & ~(descriptor.valueMask << SHIFT);
+        arrayValue |= (newValue << SHIFT);
+
+        if (skipWrite(OLD_VALUE, arrayValue))
+        {
+            return true;
+        }
+
+        return write(ADDRESS, arrayValue, descriptor.type);
+    }
+
+    default:
+    {
+        if (unchanged(ADDRESS, newValue, descriptor.type))
+        {
+            return true;
+        }
+
+        return write(ADDRESS, newValue, descriptor.type);
+    }
+    }
+}
+
+/// Updates all parameters in specified section.
+/// param [in] blockIndex     Block index.
+/// param [in] sectionIndex   Section index.
+/// param [in] values         New values for parameters.
+/// param [in] size           Size of the values array. Must be at least the number of parameters in section.
+/// returns: True on success, false otherwise.
+bool LessDb::updateSection(size_t blockIndex, size_t sectionIndex, const uint32_t* values, size_t size)
+{
+    const SectionDescriptor* descriptor = checkParameters(blockIndex, sectionIndex, 0);
+
+    if ((descriptor == nullptr) || (size < descriptor->numberOfParameters))
+    {
+        return false;
+    }
+
+    return updateParameters(*descriptor, 0, descriptor->numberOfParameters, values);
+}
+
+/// Updates a range of consecutive parameters in specified section.
+/// param [in] blockIndex     Block index.
+/// param [in] sectionIndex   Section index.
+/// param [in] first          Index of the first parameter to update.
+/// param [in] count          Number of parameters to update.
+/// param [in] values         Array of at least count elements holding new values.
+/// returns: True on success, false otherwise.
+bool LessDb::updateRange(size_t blockIndex, size_t sectionIndex, size_t first, size_t count, const uint32_t* values)
+{
+    if (!count)
+    {
+        return checkParameters(blockIndex, sectionIndex, first) != nullptr;
+    }
+
+    // checking the last parameter covers the first one as well
+    const SectionDescriptor* descriptor = checkParameters(blockIndex, sectionIndex, first + count - 1);
+
+    if ((descriptor == nullptr) || ((first + count) < first))
+    {
+        return false;
+    }
+
+    return updateParameters(*descriptor, first, count, values);
+}
+
+/// Updates a range of consecutive parameters in specified section.
+/// Values are packed into whole bytes and written in chunks of RANGE_BUFFER_SIZE
+/// bytes. Only the partially updated bytes at the edges of the range are read
+/// first, unless compare-before-write is enabled, in which case each chunk is
+/// read and only the runs of changed bytes are written.
+/// param [in] descriptor     Descriptor of the section in which parameters are located.
+/// param [in] first          Index of the first parameter to update.
+/// param [in] count          Number of parameters to update. Range must be valid for specified section.
+/// param [in] values         New values for parameters.
+/// returns: True on success, false otherwise.
+bool LessDb::updateParameters(const SectionDescriptor& descriptor, size_t first, size_t count, const uint32_t* values)
+{
+    const uint8_t WIDTH = typeWidth(descriptor.type);
+
+    if ((WIDTH > 1) && !_hwa.rangeAccessSupported() && !shadowActive())
+    {
+        // writing word and dword values byte by byte would only increase the number of transactions
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!updateParameter(descriptor, first + i, values[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const bool     COMPARE        = _compareBeforeWrite == compareBeforeWriteSetting_t::ENABLE;
+    const size_t   LAST           = first + count;
+    const size_t   PARTIAL_MASK   = (1 << descriptor.indexShift) - 1;
+    const uint32_t START_ADDRESS  = parameterAddress(descriptor, first);
+    const uint32_t END_ADDRESS    = parameterAddress(descriptor, LAST - 1) + WIDTH;
+    size_t         parameterIndex = first;
+
+    uint8_t oldBuffer[RANGE_BUFFER_SIZE] = {};
+    uint8_t newBuffer[RANGE_BUFFER_SIZE];
+
+    for (uint32_t address = START_ADDRESS; address < END_ADDRESS; address += RANGE_BUFFER_SIZE)
+    {
+        const size_t   CHUNK     = (END_ADDRESS - address) < RANGE_BUFFER_SIZE ? (END_ADDRESS - address) : RANGE_BUFFER_SIZE;
+        const uint32_t CHUNK_END = address + CHUNK;
 
-        if (startAddress == _lastReadAddress)
+        if (COMPARE)
+        {
+            if (!readBytes(address, oldBuffer, CHUNK))
+            {
+                return false;
+            }
+        }
+        else
         {
-            value = _lastReadValue;
+            if ((address == START_ADDRESS) && (first & PARTIAL_MASK))
+            {
+                if (!readBytes(address, oldBuffer, 1))
+                {
+                    return false;
+                }
+            }
 
-            if (parameterIndex % 2)
+            if ((CHUNK_END == END_ADDRESS) && (LAST & PARTIAL_MASK))
             {
-                value >>= 4;
+                if (!readBytes(CHUNK_END - 1, &oldBuffer[CHUNK - 1], 1))
+                {
+                    return false;
+                }
             }
         }
-        else if (_hwa.read(startAddress, value, sectionParameterType_t::HALF_BYTE))
+
+        memcpy(newBuffer, oldBuffer, CHUNK);
+
+        for (; parameterIndex < LAST; parameterIndex++)
         {
-            _lastReadValue = value;
+            const uint32_t ADDRESS = parameterAddress(descriptor, parameterIndex);
+
+            if (ADDRESS >= CHUNK_END)
+            {
+                break;
+            }
+
+            const uint32_t OFFSET    = ADDRESS - address;
+            const uint32_t NEW_VALUE = values[parameterIndex - first] & descriptor.valueMask;
+
+            if (COMPARE && (unpackValue(descriptor, &oldBuffer[OFFSET], parameterIndex) == NEW_VALUE))
+            {
+                _skippedWrites++;
+                continue;
+            }
+
+            packValue(descriptor, &newBuffer[OFFSET], parameterIndex, NEW_VALUE);
+        }
 
-            if (parameterIndex % 2)
+        if (!COMPARE)
+        {
+            if (!writeRange(address, newBuffer, CHUNK))
             {
-                value >>= 4;
+                return false;
             }
         }
         else
         {
-            returnValue = false;
+            bool written = false;
+
+            // write only the runs of changed bytes
+            for (size_t start = 0; start < CHUNK;)
+            {
+                if (newBuffer[start] == oldBuffer[start])
+                {
+                    start++;
+                    continue;
+                }
+
+                size_t end = start + 1;
+
+                while ((end < CHUNK) && (newBuffer[end] != oldBuffer[end]))
+                {
+                    end++;
+                }
+
+                if (!writeRange(address + start, &newBuffer[start], end - start))
+                {
+                    return false;
+                }
+
+                written = true;
+                start   = end;
+            }
+
+            if (!written)
+            {
+                continue;
+            }
+        }
+    }
+
+    return true;
+}
+
+/// Enables or disables comparing the stored value with the new one before writing.
+/// When enabled, updates which wouldn't change the stored value are skipped.
+/// Enabled by default.
+/// param [in] setting  Compare-before-write setting.
+void LessDb::setCompareBeforeWrite(compareBeforeWriteSetting_t setting)
+{
+    _compareBeforeWrite = setting;
+}
+
+/// Returns the number of updates which were skipped since the stored value was unchanged.
+uint32_t LessDb::skippedWrites() const
+{
+    return _skippedWrites;
+}
+
+/// Checks whether the write can be skipped since the stored value is unchanged.
+/// param [in] currentValue     Value currently in storage.
+/// param [in] newValue         Value which is about to be written.
+/// returns: True if write should be skipped, false otherwise.
+bool LessDb::skipWrite(uint32_t currentValue, uint32_t newValue)
+{
+    if ((_compareBeforeWrite == compareBeforeWriteSetting_t::DISABLE) || (currentValue != newValue))
+    {
+        return false;
+    }
+
+    _skippedWrites++;
+    return true;
+}
+
+/// Reads the value at specified address and checks whether the write can be skipped.
+/// Value is read only if compare-before-write is enabled.
+/// param [in] address  Address at which the value is stored.
+/// param [in] value    Value which is about to be written.
+/// param [in] type     Type of variable.
+/// returns: True if write should be skipped, false otherwise.
+bool LessDb::unchanged(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    if (_compareBeforeWrite == compareBeforeWriteSetting_t::DISABLE)
+    {
+        return false;
+    }
+
+    uint32_t currentValue;
+
+    if (!readValue(address, currentValue, type))
+    {
+        return false;
+    }
+
+    if (typeWidth(type) < 4)
+    {
+        currentValue &= (static_cast<uint32_t>(1) << (8 * typeWidth(type))) - 1;
+    }
+
+    return skipWrite(currentValue, value);
+}
+
+/// Convenience function to write value at specified address.
+/// If shadowing is enabled, value is only written to RAM shadow.
+/// If write combining is enabled, value is held in RAM until the combined writes are flushed.
+/// param [in] address Address to which to write the variable.
+/// param [in] value   Value to write.
+/// param [in] type    Type of variable.
+/// returns: True if writing succedes and read value matches the specified value, false otherwise.
+bool LessDb::write(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    if (_transactionActive)
+    {
+        uint8_t buffer[4];
+
+        for (uint8_t i = 0; i < typeWidth(type); i++)
+        {
+            buffer[i] = value >> (8 * i);
+        }
+
+        stage(_transaction, address, buffer, typeWidth(type));
+        return true;
+    }
+
+    invalidateReadCache(address, typeWidth(type));
+
+    if (shadowActive())
+    {
+        const uint32_t OFFSET = address - _initialAddress;
+
+        for (uint8_t i = 0; i < typeWidth(type); i++)
+        {
+            _shadow[OFFSET + i] = value >> (8 * i);
+        }
+
+        return markDirty(OFFSET, typeWidth(type));
+    }
+
+    if (_combineSize)
+    {
+        uint8_t buffer[4];
+
+        for (uint8_t i = 0; i < typeWidth(type); i++)
+        {
+            buffer[i] = value >> (8 * i);
+        }
+
+        return combine(address, buffer, typeWidth(type));
+    }
+
+    return hwaWrite(address, value, type);
+}
+
+/// Writes value directly to the storage and verifies it according to verification policy.
+/// param [in] address Address to which to write the variable.
+/// param [in] value   Value to write.
+/// param [in] type    Type of variable.
+/// returns: True if writing succedes and read value matches the specified value, false otherwise.
+///          If verification is deferred, only the result of writing is returned, unless
+///          list of pending writes is full, in which case result of verification is returned.
+bool LessDb::hwaWrite(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    _stats.hwaWrite(type);
+    recordWrite(address, typeWidth(type));
+
+    if (!_hwa.write(address, value, type))
+    {
+        return false;
+    }
+
+    switch (_verifyPolicy)
+    {
+    case verifyPolicy_t::NEVER:
+        return true;
+
+    case verifyPolicy_t::DEFERRED:
+    {
+        if (_batchWrite)
+        {
+            // verified once the batch is complete
+            return true;
+        }
+
+        _pendingVerify[_pendingVerifyCount++] = { address, value, type };
+
+        if (_pendingVerifyCount == PENDING_VERIFY_SIZE)
+        {
+            return verify();
+        }
+
+        return true;
+    }
+
+    default:
+        return verifyValue(address, value, type);
+    }
+}
+
+/// Removes writes which overlap specified range of bytes from the list of writes pending verification,
+/// since they're about to be overwritten.
+/// param [in] address  Address of the first byte.
+/// param [in] size     Number of bytes.
+void LessDb::dropPendingVerify(uint32_t address, size_t size)
+{
+    if (!_pendingVerifyCount)
+    {
+        return;
+    }
+
+    size_t kept = 0;
+
+    for (size_t i = 0; i < _pendingVerifyCount; i++)
+    {
+        const PendingWrite& pending = _pendingVerify[i];
+
+        if ((pending.address < (address + size)) && (address < (pending.address + typeWidth(pending.type))))
+        {
+            continue;
+        }
+
+        _pendingVerify[kept++] = pending;
+    }
+
+    _pendingVerifyCount = kept;
+}
+
+/// Reads the value at specified address back from the storage and compares it with the expected one.
+/// param [in] address Address of the variable.
+/// param [in] value   Expected value.
+/// param [in] type    Type of variable.
+/// returns: True if read value matches the specified value, false otherwise.
+bool LessDb::verifyValue(uint32_t address, uint32_t value, sectionParameterType_t type)
+{
+    uint32_t readValue;
+
+    _stats.hwaRead(type);
+
+    if (_hwa.read(address, readValue, type))
+    {
+        _stats.verifyRead(value == readValue);
+        return (value == readValue);
+    }
+
+    return false;
+}
+
+/// Reads raw value from specified address. Bytes waiting to be combined and bytes
+/// staged in active transaction take precedence over the stored ones.
+/// param [in] address      Address from which to read the variable.
+/// param [in, out] value   Reference to variable in which read value will be stored.
+/// param [in] type         Type of variable.
+/// returns: True on success, false otherwise.
+bool LessDb::readValue(uint32_t address, uint32_t& value, sectionParameterType_t type)
+{
+    if (!readStoredValue(address, value, type))
+    {
+        return false;
+    }
+
+    overlayStaged(_combined, address, value, type);
+    overlayStaged(_transaction, address, value, type);
+
+    return true;
+}
+
+/// Holds bytes in specified staged runs, replacing previously held bytes at the same
+/// addresses. Runs which the bytes overlap or touch are merged into a single run.
+/// param [in, out] staged  Runs in which to hold the bytes.
+/// param [in] address      Address of the first byte.
+/// param [in] buffer       Bytes to hold.
+/// param [in] size         Number of bytes to hold.
+void LessDb::stage(StagedRuns& staged, uint32_t address, const uint8_t* buffer, size_t size)
+{
+    const uint32_t END = address + size;
+
+    // first run which ends at or after the address, so that touching runs are merged as well
+    auto first = std::lower_bound(staged.runs.begin(), staged.runs.end(), address, [](const StagedRuns::Run& run, uint32_t value)
+                                  {
+                                      return (run.address + run.data.size()) < value;
+                                  });
+
+    auto last = first;
+
+    while ((last != staged.runs.end()) && (last->address <= END))
+    {
+        last++;
+    }
+
+    if (first == last)
+    {
+        staged.runs.insert(first, { address, std::vector<uint8_t>(buffer, buffer + size) });
+        staged.bytes += size;
+        return;
+    }
+
+    const uint32_t START = std::min(first->address, address);
+    const uint32_t STOP  = std::max(static_cast<uint32_t>((last - 1)->address + (last - 1)->data.size()), END);
+
+    for (auto run = first; run != last; run++)
+    {
+        staged.bytes -= run->data.size();
+    }
+
+    first->data.insert(first->data.begin(), first->address - START, 0);
+    first->data.resize(STOP - START);
+    first->address = START;
+
+    for (auto run = first + 1; run != last; run++)
+    {
+        memcpy(&first->data[run->address - START], run->data.data(), run->data.size());
+    }
+
+    memcpy(&first->data[address - START], buffer, size);
+
+    staged.bytes += first->data.size();
+    staged.runs.erase(first + 1, last);
+}
+
+/// Replaces bytes of a value with the ones held in specified staged runs.
+/// param [in] staged       Staged runs.
+/// param [in] address      Address of the value.
+/// param [in, out] value   Value in which to replace the bytes.
+/// param [in] type         Type of the value.
+void LessDb::overlayStaged(const StagedRuns& staged, uint32_t address, uint32_t& value, sectionParameterType_t type)
+{
+    if (staged.runs.empty())
+    {
+        return;
+    }
+
+    const uint8_t WIDTH = typeWidth(type);
+    uint8_t       buffer[4];
+
+    for (uint8_t i = 0; i < WIDTH; i++)
+    {
+        buffer[i] = value >> (8 * i);
+    }
+
+    overlayStaged(staged, address, buffer, WIDTH);
+
+    for (uint8_t i = 0; i < WIDTH; i++)
+    {
+        value &= ~(static_cast<uint32_t>(0xFF) << (8 * i));
+        value |= static_cast<uint32_t>(buffer[i]) << (8 * i);
+    }
+}
+
+/// Replaces bytes in a buffer with the ones held in specified staged runs.
+/// param [in] staged       Staged runs.
+/// param [in] address      Address of the first byte in buffer.
+/// param [in, out] buffer  Buffer in which to replace the bytes.
+/// param [in] size         Size of the buffer.
+void LessDb::overlayStaged(const StagedRuns& staged, uint32_t address, uint8_t* buffer, size_t size)
+{
+    const uint32_t END = address + size;
+
+    auto run = std::upper_bound(staged.runs.begin(), staged.runs.end(), address, [](uint32_t value, const StagedRuns::Run& run)
+                                {
+                                    return value < (run.address + run.data.size());
+                                });
+
+    for (; (run != staged.runs.end()) && (run->address < END); run++)
+    {
+        const uint32_t START = std::max(run->address, address);
+        const uint32_t STOP  = std::min(static_cast<uint32_t>(run->address + run->data.size()), END);
+
+        memcpy(&buffer[START - address], &run->data[START - run->address], STOP - START);
+    }
+}
+
+/// Reads raw value from specified address, either from RAM shadow
+/// if shadowing is enabled or from the storage.
+/// param [in] address      Address from which to read the variable.
+/// param [in, out] value   Reference to variable in which read value will be stored.
+/// param [in] type         Type of variable.
+/// returns: True on success, false otherwise.
+bool LessDb::readStoredValue(uint32_t address, uint32_t& value, sectionParameterType_t type)
+{
+    if (shadowActive())
+    {
+        const uint32_t OFFSET = address - _initialAddress;
+
+        value = 0;
+
+        for (uint8_t i = 0; i < typeWidth(type); i++)
+        {
+            value |= static_cast<uint32_t>(_shadow[OFFSET + i]) << (8 * i);
+        }
+
+        return true;
+    }
+
+    if (!_readCacheSize)
+    {
+        _stats.hwaRead(type);
+        return _hwa.read(address, value, type);
+    }
+
+    ReadCacheEntry& entry = readCacheEntry(address, type);
+
+    if ((entry.address == address) && (entry.size == typeWidth(type)))
+    {
+        _readCacheHits++;
+        value = entry.value;
+        return true;
+    }
+
+    _readCacheMisses++;
+    _stats.hwaRead(type);
+
+    if (!_hwa.read(address, value, type))
+    {
+        return false;
+    }
+
+    entry.address = address;
+    entry.value   = value;
+    entry.size    = typeWidth(type);
+
+    return true;
+}
+
+/// Clears entire memory.
+/// If shadowing is enabled, shadow is reloaded from cleared memory
+/// and all pending changes are discarded.
+bool LessDb::clear()
+{
+    if (_transactionActive)
+    {
+        return false;
+    }
+
+    resetReadCache();
+    _initProgress.active = false;
+    _combined.clear();
+    _checkpointDirty.assign(_checkpointDirty.size(), true);
+    _pendingVerifyCount = 0;
+
+    if (!_hwa.clear())
+    {
+        return false;
+    }
+
+    if (_layoutStatus != layoutStatus_t::UNKNOWN)
+    {
+        _layoutStatus = layoutStatus_t::NEEDS_INIT;
+    }
+
+    // map has been cleared along with everything else
+    _defaultedMap.assign(_defaultedMap.size(), 0);
+    _defaultedSections = 0;
+
+    if (shadowActive())
+    {
+        return loadShadow();
+    }
+
+    return true;
+}
+
+/// Writes default values to memory.
+/// param [in] type     Type of initialization (partial or full).
+///                     Full will simply overwrite currently existing data.
+///                     Partial will leave data as is, but only if
+///                     preserveOnPartialReset parameter is set to true.
+/// With verifyPolicy_t::DEFERRED policy, entire database is verified
+/// once all the sections have been written.
+/// With lazy reset enabled, sections are only marked as being at defaults.
+bool LessDb::initData(factoryResetType_t type)
+{
+    auto timer = _stats.initData();
+
+    if (!startInitData(type))
+    {
+        return false;
+    }
+
+    return continueInitData(0xFFFFFFFF) == initStatus_t::DONE;
+}
+
+/// Starts initialization which is performed in steps with continueInitData,
+/// so that long initialization can be interleaved with other work.
+/// Database shouldn't be updated until the initialization is done.
+/// param [in] type     Type of initialization (partial or full).
+/// returns: True on success, false otherwise.
+bool LessDb::startInitData(factoryResetType_t type)
+{
+    _initProgress.active = false;
+
+    if (_transactionActive)
+    {
+        return false;
+    }
+
+    resetReadCache();
+
+    // with deferred verification, all sections are verified at once after writing
+    const bool DEFERRED = (_verifyPolicy == verifyPolicy_t::DEFERRED) && !shadowActive();
+
+    // with lazy reset, sections are only marked as being at defaults and written on first update
+    const bool LAZY = _lazyResetSetting == lazyResetSetting_t::ENABLE;
+
+    if (LAZY && !markDefaulted(type))
+    {
+        return false;
+    }
+
+    // all pending writes are about to be overwritten or verified again
+    _pendingVerifyCount = 0;
+
+    _initProgress        = {};
+    _initProgress.active = true;
+    _initProgress.type   = type;
+    _initProgress.passes = LAZY ? 0 : (DEFERRED ? 2 : 1);
+
+    return true;
+}
+
+/// Performs next step of initialization started with startInitData.
+/// param [in] maxBytes     Maximum number of bytes to write (or verify) in this step.
+///                         At least one parameter is written in each step.
+/// returns: initStatus_t::IN_PROGRESS if more steps are needed, initStatus_t::DONE once
+///          the initialization is complete, initStatus_t::FAILED on failure or if
+///          initialization isn't started.
+initStatus_t LessDb::continueInitData(uint32_t maxBytes)
+{
+    if (!_initProgress.active || _transactionActive)
+    {
+        return initStatus_t::FAILED;
+    }
+
+    uint32_t processed = 0;
+
+    _batchWrite = _initProgress.passes == 2;
+
+    while (_initProgress.pass < _initProgress.passes)
+    {
+        if (_initProgress.section == numberOfSections())
+        {
+            // sections are verified in the storage, so combined writes have to end up there first
+            if (!_initProgress.pass && (_initProgress.passes == 2) && !flushCombined())
+            {
+                _batchWrite          = false;
+                _initProgress.active = false;
+                return initStatus_t::FAILED;
+            }
+
+            _initProgress.pass++;
+            _initProgress.section = 0;
+            continue;
+        }
+
+        const SectionDescriptor& descriptor = _descriptorTable[_initProgress.section];
+
+        if ((descriptor.preserveOnPartialReset == preserveSetting_t::ENABLE) &&
+            (_initProgress.type == factoryResetType_t::PARTIAL))
+        {
+            _initProgress.section++;
+            continue;
+        }
+
+        if (processed == maxBytes)
+        {
+            break;
+        }
+
+        const uint32_t SIZE  = sectionSize(descriptor.type, descriptor.numberOfParameters);
+        const uint8_t  WIDTH = typeWidth(descriptor.type);
+        uint32_t       chunk = SIZE - _initProgress.offset;
+
+        if (chunk > (maxBytes - processed))
+        {
+            // don't split word and dword values across steps
+            chunk = ((maxBytes - processed) / WIDTH) * WIDTH;
+
+            if (!chunk)
+            {
+                if (processed)
+                {
+                    break;
+                }
+
+                chunk = WIDTH;
+            }
+        }
+
+        bool result = _initProgress.pass ? verifySection(descriptor, _initProgress.offset, chunk)
+                                         : initSection(descriptor, _initProgress.offset, chunk);
+
+        if (!result)
+        {
+            _batchWrite          = false;
+            _initProgress.active = false;
+            return initStatus_t::FAILED;
+        }
+
+        processed += chunk;
+        _initProgress.offset += chunk;
+
+        if (_initProgress.offset == SIZE)
+        {
+            _initProgress.section++;
+            _initProgress.offset = 0;
+        }
+    }
+
+    _batchWrite = false;
+
+    if (_initProgress.pass < _initProgress.passes)
+    {
+        return initStatus_t::IN_PROGRESS;
+    }
+
+    _initProgress.active = false;
+    return completeInit() ? initStatus_t::DONE : initStatus_t::FAILED;
+}
+
+/// Checks whether initialization started with startInitData is still in progress.
+bool LessDb::initInProgress() const
+{
+    return _initProgress.active;
+}
+
+/// Finishes the initialization once all sections have been written.
+/// returns: True on success, false otherwise.
+bool LessDb::completeInit()
+{
+    // make sure defaults end up in the storage
+    if (!flush())
+    {
+        return false;
+    }
+
+    // header is written last so that interrupted initialization is detected on next start
+    if ((_headerSetting == headerSetting_t::ENABLE) && (_descriptorTable != nullptr))
+    {
+        return writeHeader();
+    }
+
+    return true;
+}
+
+/// Writes default values for all parameters in specified section.
+/// If the storage supports range access, section is written in chunks
+/// of RANGE_BUFFER_SIZE bytes. Otherwise, bit and half-byte values are
+/// merged into single bytes and all other values are written one by one.
+/// param [in] descriptor   Descriptor of the section to initialize.
+/// param [in] start        Offset of the first byte to write within the section.
+/// param [in] size         Number of bytes to write. Writing stops at the end of the section.
+/// returns: True on success, false otherwise.
+bool LessDb::initSection(const SectionDescriptor& descriptor, uint32_t start, uint32_t size)
+{
+    const uint32_t SECTION_SIZE = sectionSize(descriptor.type, descriptor.numberOfParameters);
+    const uint32_t SIZE         = (size < (SECTION_SIZE - start)) ? (start + size) : SECTION_SIZE;
+
+    if (_hwa.rangeAccessSupported() || shadowActive())
+    {
+        uint8_t buffer[RANGE_BUFFER_SIZE];
+
+        for (uint32_t offset = start; offset < SIZE; offset += RANGE_BUFFER_SIZE)
+        {
+            const size_t CHUNK = (SIZE - offset) < RANGE_BUFFER_SIZE ? (SIZE - offset) : RANGE_BUFFER_SIZE;
+
+            for (size_t i = 0; i < CHUNK; i++)
+            {
+                buffer[i] = defaultByte(descriptor, offset + i);
+            }
+
+            if (!writeRange(descriptor.address + offset, buffer, CHUNK))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    switch (descriptor.type)
+    {
+    case sectionParameterType_t::WORD:
+    case sectionParameterType_t::DWORD:
+    {
+        for (size_t parameter = start >> descriptor.widthShift; parameter < (SIZE >> descriptor.widthShift); parameter++)
+        {
+            if (!write(parameterAddress(descriptor, parameter), defaultValue(descriptor, parameter), descriptor.type))
+            {
+                return false;
+            }
+        }
+    }
+    break;
+
+    default:
+    {
+        // bit, byte and half-byte sections:
+        // optimize the writing - merge values into single byte
+        for (uint32_t byte = start; byte < SIZE; byte++)
+        {
+            if (!write(descriptor.address + byte, defaultByte(descriptor, byte), sectionParameterType_t::BYTE))
+            {
+                return false;
+            }
+        }
+    }
+    break;
+    }
+
+    return true;
+}
+
+/// Writes a range of bytes.
+/// If shadowing is enabled, bytes are only written to RAM shadow.
+/// If write combining is enabled, bytes are held in RAM until the combined writes are flushed.
+/// Sections in range which are at defaults are written with default values first.
+/// param [in] address  Address from which to start writing.
+/// param [in] buffer   Bytes to write.
+/// param [in] size     Number of bytes to write.
+/// returns: True on success, false otherwise.
+bool LessDb::writeRange(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    if (!materializeRange(address, size))
+    {
+        return false;
+    }
+
+    if (_transactionActive)
+    {
+        stage(_transaction, address, buffer, size);
+        return true;
+    }
+
+    invalidateReadCache(address, size);
+
+    if (shadowActive())
+    {
+        const uint32_t OFFSET = address - _initialAddress;
+
+        memcpy(&_shadow[OFFSET], buffer, size);
+        return markDirty(OFFSET, size);
+    }
+
+    if (_combineSize)
+    {
+        return combine(address, buffer, size);
+    }
+
+    return hwaWriteRange(address, buffer, size);
+}
+
+/// Writes a range of bytes directly to the storage and verifies them by reading the range back.
+/// With deferred policy, range isn't verified while a batch is written: caller is responsible
+/// for verifying the range once the entire batch has been written.
+/// param [in] address  Address from which to start writing.
+/// param [in] buffer   Bytes to write.
+/// param [in] size     Number of bytes to write.
+/// returns: True if writing succedes and read bytes match the written ones, false otherwise.
+bool LessDb::hwaWriteRange(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    _stats.hwaRangeWrite();
+    recordWrite(address, size);
+
+    if (!_hwa.writeRange(address, buffer, size))
+    {
+        return false;
+    }
+
+    if ((_verifyPolicy == verifyPolicy_t::NEVER) || ((_verifyPolicy == verifyPolicy_t::DEFERRED) && _batchWrite))
+    {
+        return true;
+    }
+
+    return verifyRange(address, buffer, size);
+}
+
+/// Reads a range of bytes from the storage and compares it with the expected content.
+/// param [in] address  Address from which to start reading.
+/// param [in] buffer   Expected bytes.
+/// param [in] size     Number of bytes to compare.
+/// returns: True if read bytes match the expected ones, false otherwise.
+bool LessDb::verifyRange(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    uint8_t readBuffer[RANGE_BUFFER_SIZE];
+
+    for (size_t offset = 0; offset < size; offset += RANGE_BUFFER_SIZE)
+    {
+        const size_t CHUNK = (size - offset) < RANGE_BUFFER_SIZE ? (size - offset) : RANGE_BUFFER_SIZE;
+
+        _stats.hwaRangeRead();
+
+        if (!_hwa.readRange(address + offset, readBuffer, CHUNK))
+        {
+            return false;
+        }
+
+        const bool MATCH = memcmp(readBuffer, buffer + offset, CHUNK) == 0;
+
+        _stats.verifyRead(MATCH);
+
+        if (!MATCH)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Verifies that specified section in storage holds default values.
+/// param [in] descriptor   Descriptor of the section to verify.
+/// param [in] start        Offset of the first byte to verify within the section.
+/// param [in] size         Number of bytes to verify. Verification stops at the end of the section.
+/// returns: True if all values match the defaults, false otherwise.
+bool LessDb::verifySection(const SectionDescriptor& descriptor, uint32_t start, uint32_t size)
+{
+    const bool     MULTI_BYTE   = (descriptor.type == sectionParameterType_t::WORD) ||
+                                (descriptor.type == sectionParameterType_t::DWORD);
+    const uint32_t SECTION_SIZE = sectionSize(descriptor.type, descriptor.numberOfParameters);
+    const uint32_t SIZE         = (size < (SECTION_SIZE - start)) ? (start + size) : SECTION_SIZE;
+
+    if (MULTI_BYTE && !_hwa.rangeAccessSupported())
+    {
+        // byte order is known only for storage with range access
+        for (size_t parameter = start >> descriptor.widthShift; parameter < (SIZE >> descriptor.widthShift); parameter++)
+        {
+            if (!verifyValue(parameterAddress(descriptor, parameter), defaultValue(descriptor, parameter), descriptor.type))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint8_t buffer[RANGE_BUFFER_SIZE];
+
+    for (uint32_t offset = start; offset < SIZE; offset += RANGE_BUFFER_SIZE)
+    {
+        const size_t CHUNK = (SIZE - offset) < RANGE_BUFFER_SIZE ? (SIZE - offset) : RANGE_BUFFER_SIZE;
+
+        for (size_t i = 0; i < CHUNK; i++)
+        {
+            buffer[i] = defaultByte(descriptor, offset + i);
+        }
+
+        if (!verifyRange(descriptor.address + offset, buffer, CHUNK))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Sets the policy used to verify values written to the storage.
+/// With verifyPolicy_t::DEFERRED policy, only single-value writes are deferred,
+/// while range writes outside of initialization and flush are verified immediately.
+/// Pending writes are verified before the policy is changed.
+/// param [in] policy   Verification policy.
+/// returns: Result of pending writes verification.
+bool LessDb::setVerifyPolicy(verifyPolicy_t policy)
+{
+    bool result = verify();
+
+    _verifyPolicy = policy;
+    return result;
+}
+
+/// Verifies all writes which are pending verification.
+/// Used only with verifyPolicy_t::DEFERRED policy.
+/// returns: True if all values in storage match the written ones, false otherwise.
+bool LessDb::verify()
+{
+    bool result = true;
+
+    for (size_t i = 0; i < _pendingVerifyCount; i++)
+    {
+        if (!verifyValue(_pendingVerify[i].address, _pendingVerify[i].value, _pendingVerify[i].type))
+        {
+            result = false;
+        }
+    }
+
+    _pendingVerifyCount = 0;
+    return result;
+}
+
+/// Returns the default value for specified parameter.
+/// Per-parameter default values are used only when auto-increment is disabled.
+/// Auto-increment doesn't apply to bit and half-byte sections.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index.
+uint32_t LessDb::defaultValue(const SectionDescriptor& descriptor, size_t parameterIndex)
+{
+    uint32_t value = descriptor.defaultValue;
+
+    if ((descriptor.autoIncrement == autoIncrementSetting_t::ENABLE) &&
+        (descriptor.type != sectionParameterType_t::BIT) &&
+        (descriptor.type != sectionParameterType_t::HALF_BYTE))
+    {
+        value += parameterIndex;
+    }
+    else if (descriptor.defaultValues != nullptr)
+    {
+        value = descriptor.defaultValues[parameterIndex];
+    }
+
+    return value & descriptor.valueMask;
+}
+
+/// Returns the default content of a single byte within specified section.
+/// Word and dword values are stored in little-endian order.
+/// param [in] descriptor   Descriptor of the section in which byte is located.
+/// param [in] byteIndex    Byte index relative to the section start.
+uint8_t LessDb::defaultByte(const SectionDescriptor& descriptor, size_t byteIndex)
+{
+    uint8_t value = 0;
+
+    switch (descriptor.type)
+    {
+    case sectionParameterType_t::BIT:
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            const size_t PARAMETER = (byteIndex * 8) + bit;
+
+            if (PARAMETER >= descriptor.numberOfParameters)
+            {
+                break;
+            }
+
+            if (defaultValue(descriptor, PARAMETER))
+            {
+                value |= BIT_MASK[bit];
+            }
+        }
+    }
+    break;
+
+    case sectionParameterType_t::HALF_BYTE:
+    {
+        const size_t PARAMETER = byteIndex * 2;
+
+        value = defaultValue(descriptor, PARAMETER);
+
+        if ((PARAMETER + 1) < descriptor.numberOfParameters)
+        {
+            value |= defaultValue(descriptor, PARAMETER + 1) << 4;
+        }
+    }
+    break;
+
+    case sectionParameterType_t::BYTE:
+    {
+        value = defaultValue(descriptor, byteIndex);
+    }
+    break;
+
+    case sectionParameterType_t::WORD:
+    {
+        value = defaultValue(descriptor, byteIndex / 2) >> (8 * (byteIndex % 2));
+    }
+    break;
+
+    default:
+    {
+        // case sectionParameterType_t::DWORD:
+        value = defaultValue(descriptor, byteIndex / 4) >> (8 * (byteIndex % 4));
+    }
+    break;
+    }
+
+    return value;
+}
+
+/// Enables or disables RAM shadow of the database.
+/// When enabled, entire database is loaded into RAM once the layout is set.
+/// All reads are then served from RAM, while updates only modify RAM and
+/// mark the changed bytes as dirty. Dirty bytes are written to the storage
+/// with flush() or automatically once auto-flush threshold is reached.
+/// Disabling the shadow flushes all pending changes first, while enabling
+/// already active shadow keeps it as is.
+/// param [in] setting  Shadow setting.
+/// returns: True on success, false otherwise.
+bool LessDb::setShadow(shadowSetting_t setting)
+{
+    resetReadCache();
+
+    if (setting == shadowSetting_t::DISABLE)
+    {
+        bool result = flush();
+
+        _shadowSetting = setting;
+        _shadow.clear();
+        _shadow.shrink_to_fit();
+        _shadowDirty.clear();
+        _shadowDirty.shrink_to_fit();
+        _dirtyBytes = 0;
+
+        return result;
+    }
+
+    // shadow already holds the latest data, reloading it would discard dirty bytes
+    if (shadowActive())
+    {
+        return true;
+    }
+
+    // combined writes have to be in the storage before it's loaded into shadow
+    if (!flushCombined())
+    {
+        return false;
+    }
+
+    _shadowSetting = setting;
+
+    if (_descriptorTable == nullptr)
+    {
+        // shadow will be loaded once the layout is set
+        return true;
+    }
+
+    return loadShadow();
+}
+
+/// Sets the amount of dirty bytes after which shadow is automatically flushed.
+/// param [in] threshold    Number of dirty bytes. Set to 0 to disable automatic flushing.
+void LessDb::setAutoFlushThreshold(uint32_t threshold)
+{
+    _autoFlushThreshold = threshold;
+}
+
+/// Writes all dirty bytes from RAM shadow and all combined writes to the storage.
+/// Consecutive dirty bytes are merged and written as a single range.
+/// With verifyPolicy_t::DEFERRED policy, entire flushed region is verified
+/// once all the ranges have been written. In case of mismatch, region is
+/// marked as dirty again.
+/// returns: True on success or if there is nothing to write, false otherwise.
+bool LessDb::flush()
+{
+    if (!flushCombined())
+    {
+        return false;
+    }
+
+    if (!shadowActive() || !_dirtyBytes)
+    {
+        return true;
+    }
+
+    const bool BATCH  = _batchWrite;
+    size_t     offset = 0;
+    size_t     first  = _shadow.size();
+    size_t     last   = 0;
+
+    // with deferred policy, everything written in this flush is verified at the end
+    _batchWrite = true;
+
+    while (offset < _shadow.size())
+    {
+        if (!_shadowDirty[offset])
+        {
+            offset++;
+            continue;
+        }
+
+        size_t end = offset;
+
+        while ((end < _shadow.size()) && _shadowDirty[end])
+        {
+            end++;
+        }
+
+        if (!hwaWriteRange(_initialAddress + offset, &_shadow[offset], end - offset))
+        {
+            _batchWrite = BATCH;
+            return false;
+        }
+
+        for (size_t i = offset; i < end; i++)
+        {
+            _shadowDirty[i] = false;
+        }
+
+        _dirtyBytes -= end - offset;
+        first  = (offset < first) ? offset : first;
+        last   = end;
+        offset = end;
+    }
+
+    _batchWrite = BATCH;
+
+    if (_verifyPolicy == verifyPolicy_t::DEFERRED)
+    {
+        // verify everything written in this flush with a single range
+        if (!verifyRange(_initialAddress + first, &_shadow[first], last - first))
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                _shadowDirty[i] = true;
+            }
+
+            _dirtyBytes += last - first;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Returns the amount of bytes in RAM shadow which haven't been written to the storage yet.
+uint32_t LessDb::dirtyBytes() const
+{
+    return _dirtyBytes;
+}
+
+/// Enables combining of writes. Written bytes are held in RAM, where repeated writes
+/// to the same address overwrite each other, and are written to the storage sorted by
+/// address, with consecutive bytes written as a single range. Combined writes are
+/// written with flush(), once specified number of bytes is held, or once the oldest
+/// of them is held longer than specified deadline. Writes aren't combined while
+/// RAM shadow is enabled, since shadow already holds the changes.
+/// Changing the setting flushes all combined writes first.
+/// param [in] size         Maximum number of bytes held for combining. Set to 0 to disable combining.
+/// param [in] deadlineMs   Time in milliseconds after which combined writes are flushed.
+///                         Set to 0 to flush only on request or once size is reached.
+///                         Deadline is checked on each write and with flushIfExpired(),
+///                         against the time provided by Hwa::milliseconds().
+/// returns: Result of flushing the combined writes.
+bool LessDb::setWriteCombining(uint32_t size, uint32_t deadlineMs)
+{
+    bool result = flushCombined();
+
+    _combineSize       = size;
+    _combineDeadlineMs = deadlineMs;
+
+    return result;
+}
+
+/// Returns the amount of bytes held for combining which haven't been written to the storage yet.
+uint32_t LessDb::combinedBytes() const
+{
+    return _combined.bytes;
+}
+
+/// Writes combined writes to the storage if they're held longer than the deadline.
+/// Should be called periodically if deadline is set, so that combined writes
+/// are flushed even if no other writes follow.
+/// returns: True on success or if the deadline hasn't passed yet, false otherwise.
+bool LessDb::flushIfExpired()
+{
+    return combineExpired() ? flushCombined() : true;
+}
+
+/// Holds bytes in RAM until they're written together with other combined writes.
+/// Combined writes are flushed once size limit or deadline is reached.
+/// param [in] address  Address from which to start writing.
+/// param [in] buffer   Bytes to write.
+/// param [in] size     Number of bytes to write.
+/// returns: True on success, false otherwise.
+bool LessDb::combine(uint32_t address, const uint8_t* buffer, size_t size)
+{
+    if (_combined.runs.empty())
+    {
+        _combineStartMs = _hwa.milliseconds();
+    }
+
+    stage(_combined, address, buffer, size);
+
+    if ((_combined.bytes >= _combineSize) || combineExpired())
+    {
+        return flushCombined();
+    }
+
+    return true;
+}
+
+/// Writes all combined writes to the storage in runs of consecutive addresses.
+/// With verifyPolicy_t::DEFERRED policy, all runs are verified once written.
+/// Combined writes are kept if writing fails, so that flushing can be retried.
+/// returns: True on success, false otherwise.
+bool LessDb::flushCombined()
+{
+    if (_combined.runs.empty())
+    {
+        return true;
+    }
+
+    const bool DEFERRED = _verifyPolicy == verifyPolicy_t::DEFERRED;
+    const bool BATCH    = _batchWrite;
+
+    for (int pass = 0; pass < (DEFERRED ? 2 : 1); pass++)
+    {
+        _batchWrite = DEFERRED;
+
+        for (const auto& run : _combined.runs)
+        {
+            bool result;
+
+            if (pass)
+            {
+                result = verifyRange(run.address, run.data.data(), run.data.size());
+            }
+            else
+            {
+                invalidateReadCache(run.address, run.data.size());
+
+                result = (run.data.size() == 1) ? hwaWrite(run.address, run.data[0], sectionParameterType_t::BYTE)
+                                                : hwaWriteRange(run.address, run.data.data(), run.data.size());
+            }
+
+            if (!result)
+            {
+                _batchWrite = BATCH;
+                return false;
+            }
+        }
+    }
+
+    _batchWrite = BATCH;
+    _combined.clear();
+
+    return true;
+}
+
+/// Checks if combined writes are held longer than the deadline.
+/// Unsigned difference keeps the check valid when the time wraps around.
+bool LessDb::combineExpired()
+{
+    if (!_combineDeadlineMs || _combined.runs.empty())
+    {
+        return false;
+    }
+
+    return static_cast<uint32_t>(_hwa.milliseconds() - _combineStartMs) >= _combineDeadlineMs;
+}
+
+/// Loads entire database region from the storage to RAM shadow.
+/// returns: True on success, false otherwise.
+bool LessDb::loadShadow()
+{
+    _shadow.assign(_memoryUsage, 0);
+    _shadowDirty.assign(_memoryUsage, false);
+    _dirtyBytes = 0;
+
+    _stats.hwaRangeRead();
+
+    if (!_hwa.readRange(_initialAddress, _shadow.data(), _shadow.size()))
+    {
+        _shadow.clear();
+        _shadowDirty.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/// Marks range of bytes in RAM shadow as dirty and flushes
+/// the shadow if auto-flush threshold has been reached.
+/// param [in] offset   Offset of the first byte relative to database start.
+/// param [in] size     Number of bytes.
+/// returns: True on success, false otherwise.
+bool LessDb::markDirty(uint32_t offset, size_t size)
+{
+    for (size_t i = offset; i < offset + size; i++)
+    {
+        if (!_shadowDirty[i])
+        {
+            _shadowDirty[i] = true;
+            _dirtyBytes++;
+        }
+    }
+
+    if (_autoFlushThreshold && (_dirtyBytes >= _autoFlushThreshold))
+    {
+        return flush();
+    }
+
+    return true;
+}
+
+/// Checks if RAM shadow is enabled and loaded.
+bool LessDb::shadowActive() const
+{
+    return !_shadow.empty();
+}
+
+/// Starts a transaction. Until the transaction is committed, updates are only
+/// staged in RAM and visible to reads through this instance, while the storage
+/// (or RAM shadow) is left untouched.
+/// returns: True on success, false if layout isn't set or transaction is already active.
+bool LessDb::beginTransaction()
+{
+    if (_transactionActive || (_descriptorTable == nullptr))
+    {
+        return false;
+    }
+
+    _transaction.clear();
+    _transactionActive = true;
+
+    return true;
+}
+
+/// Writes all updates staged in active transaction.
+/// Staged bytes are written in runs of consecutive addresses. If journal is set,
+/// runs are first written to the journal and marked as committed with a single
+/// write, so that interrupted commit can be completed on next setJournal() call.
+/// returns: True on success, false otherwise. If writing to the journal or to the database
+///          fails, transaction stays active and can be committed again or rolled back.
+bool LessDb::commit()
+{
+    if (!_transactionActive)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> runs;
+
+    runs.reserve(_transaction.bytes + (_transaction.runs.size() * JOURNAL_RUN_HEADER_SIZE));
+
+    for (const auto& run : _transaction.runs)
+    {
+        // journal stores run size in two bytes, so longer runs are split
+        for (size_t offset = 0; offset < run.data.size(); offset += 0xFFFF)
+        {
+            const uint32_t ADDRESS = run.address + offset;
+            const size_t   SIZE    = std::min(run.data.size() - offset, static_cast<size_t>(0xFFFF));
+
+            runs.push_back(ADDRESS & 0xFF);
+            runs.push_back((ADDRESS >> 8) & 0xFF);
+            runs.push_back((ADDRESS >> 16) & 0xFF);
+            runs.push_back((ADDRESS >> 24) & 0xFF);
+            runs.push_back(SIZE & 0xFF);
+            runs.push_back(SIZE >> 8);
+            runs.insert(runs.end(), run.data.begin() + offset, run.data.begin() + offset + SIZE);
+        }
+    }
+
+    if (_journalSize && !writeJournal(runs))
+    {
+        return false;
+    }
+
+    // staged bytes are written outside of the transaction, which is kept until they're stored
+    _transactionActive = false;
+
+    bool result = applyRuns(runs.data(), runs.size(), false) && flush();
+
+    if (!result)
+    {
+        _transactionActive = true;
+        return false;
+    }
+
+    _transaction.clear();
+
+    if (_journalSize)
+    {
+        // changes are in the storage, journal is no longer needed
+        result = hwaWrite(_journalAddress, 0, sectionParameterType_t::DWORD);
+    }
+
+    return result;
+}
+
+/// Discards all updates staged in active transaction.
+void LessDb::rollback()
+{
+    _transactionActive = false;
+    _transaction.clear();
+}
+
+/// Enables tracking of changes needed for incremental checkpoints. Changes are tracked
+/// in pages of specified size: once any byte in a page is written, entire page is
+/// included in the next incremental checkpoint. Since changes made before the tracking
+/// is enabled are unknown, full checkpoint has to be created or restored first.
+/// param [in] pageSize     Size of the page in bytes. Set to 0 to disable tracking.
+/// returns: True on success, false if transaction is active.
+bool LessDb::setCheckpointPageSize(uint32_t pageSize)
+{
+    if (_transactionActive)
+    {
+        return false;
+    }
+
+    _checkpointPageSize = pageSize;
+    _checkpointSequence = 0;
+    resetCheckpointPages();
+
+    return true;
+}
+
+/// Writes the checkpoint of the database to specified sink. Checkpoint starts with a header
+/// holding the checkpoint type, layout hash and the sequence numbers of the checkpoint and
+/// the one it's based on, followed by ranges of database content, each preceded by its offset
+/// and size, and ends with FNV-1a checksum of everything before it. All values are stored in
+/// little-endian order. Full checkpoint holds entire database, while incremental one holds only
+/// the pages written since the previous checkpoint. Pending changes are flushed first.
+/// param [in] sink     Destination of the checkpoint.
+/// param [in] type     Type of the checkpoint.
+/// returns: True on success, false if change tracking isn't enabled, incremental checkpoint
+///          has no checkpoint to be based on, or if reading or writing fails.
+bool LessDb::checkpoint(DataSink& sink, checkpointType_t type)
+{
+    const bool FULL = type == checkpointType_t::FULL;
+
+    if (!_checkpointPageSize || (_descriptorTable == nullptr) || _transactionActive || (!FULL && !_checkpointSequence))
+    {
+        return false;
+    }
+
+    if (!flush())
+    {
+        return false;
+    }
+
+    // ranges are offset and size pairs, made of consecutive changed pages
+    std::vector<uint32_t> ranges;
+
+    if (FULL)
+    {
+        ranges = { 0, _memoryUsage };
+    }
+    else
+    {
+        for (size_t page = 0; page < _checkpointDirty.size();)
+        {
+            if (!_checkpointDirty[page])
+            {
+                page++;
+                continue;
+            }
+
+            const uint32_t START = page * _checkpointPageSize;
+
+            while ((page < _checkpointDirty.size()) && _checkpointDirty[page])
+            {
+                page++;
+            }
+
+            ranges.push_back(START);
+            ranges.push_back(std::min(static_cast<uint32_t>(page * _checkpointPageSize), _memoryUsage) - START);
+        }
+    }
+
+    const uint32_t SEQUENCE = (_checkpointSequence == 0xFFFFFFFF) ? 1 : (_checkpointSequence + 1);
+    const uint32_t HEADER[] = {
+        CHECKPOINT_MAGIC,
+        _layoutHash,
+        SEQUENCE,
+        _checkpointSequence,
+        _initialAddress,
+        _memoryUsage,
+        static_cast<uint32_t>(ranges.size() / 2),
+    };
+
+    uint8_t  buffer[RANGE_BUFFER_SIZE];
+    uint32_t hash = CHECKPOINT_CHECKSUM_BASIS;
+    size_t   size = 0;
+
+    auto put = [&](uint32_t value)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            buffer[size++] = value >> (8 * i);
+        }
+    };
+
+    auto emit = [&]()
+    {
+        hash = checksum(hash, buffer, size);
+
+        bool result = sink.write(buffer, size);
+
+        size = 0;
+        return result;
+    };
+
+    put(HEADER[0]);
+    buffer[size++] = CHECKPOINT_VERSION;
+    buffer[size++] = static_cast<uint8_t>(type);
+
+    for (size_t i = 1; i < (sizeof(HEADER) / sizeof(HEADER[0])); i++)
+    {
+        put(HEADER[i]);
+    }
+
+    if (!emit())
+    {
+        return false;
+    }
+
+    for (size_t range = 0; range < ranges.size(); range += 2)
+    {
+        put(ranges[range]);
+        put(ranges[range + 1]);
+
+        if (!emit())
+        {
+            return false;
+        }
+
+        for (uint32_t offset = 0; offset < ranges[range + 1]; offset += RANGE_BUFFER_SIZE)
+        {
+            size = std::min(static_cast<uint32_t>(RANGE_BUFFER_SIZE), ranges[range + 1] - offset);
+
+            if (!readBytes(_initialAddress + ranges[range] + offset, buffer, size) || !emit())
+            {
+                return false;
+            }
+        }
+    }
+
+    put(hash);
+
+    if (!sink.write(buffer, size))
+    {
+        return false;
+    }
+
+    _checkpointSequence = SEQUENCE;
+    _checkpointDirty.assign(_checkpointDirty.size(), false);
+
+    return true;
+}
+
+/// Writes the content of specified checkpoint to the database. Database can be brought
+/// to the state of any checkpoint by restoring the full checkpoint and then all the
+/// incremental ones which follow it, in order. Entire checkpoint is validated before
+/// anything is written.
+/// param [in] checkpoint   Checkpoint created with checkpoint().
+/// param [in] size         Size of the checkpoint in bytes.
+/// returns: True on success, false if checkpoint is malformed, belongs to different layout,
+///          doesn't follow the checkpoint restored last or if writing fails.
+bool LessDb::restore(const uint8_t* checkpoint, size_t size)
+{
+    if ((_descriptorTable == nullptr) || _transactionActive || (size < (CHECKPOINT_HEADER_SIZE + CHECKPOINT_CHECKSUM_SIZE)))
+    {
+        return false;
+    }
+
+    auto get = [checkpoint](size_t offset)
+    {
+        uint32_t value = 0;
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            value |= static_cast<uint32_t>(checkpoint[offset + i]) << (8 * i);
+        }
+
+        return value;
+    };
+
+    const size_t   END      = size - CHECKPOINT_CHECKSUM_SIZE;
+    const auto     TYPE     = static_cast<checkpointType_t>(checkpoint[5]);
+    const uint32_t SEQUENCE = get(10);
+    const uint32_t PREVIOUS = get(14);
+    const uint32_t RANGES   = get(26);
+
+    if ((get(0) != CHECKPOINT_MAGIC) ||
+        (checkpoint[4] != CHECKPOINT_VERSION) ||
+        (get(6) != _layoutHash) ||
+        (get(18) != _initialAddress) ||
+        (get(22) != _memoryUsage) ||
+        (get(END) != checksum(CHECKPOINT_CHECKSUM_BASIS, checkpoint, END)))
+    {
+        return false;
+    }
+
+    if (TYPE == checkpointType_t::INCREMENTAL)
+    {
+        if (!_checkpointSequence || (PREVIOUS != _checkpointSequence))
+        {
+            return false;
+        }
+    }
+    else if (TYPE != checkpointType_t::FULL)
+    {
+        return false;
+    }
+
+    // validate all ranges first so that malformed checkpoint isn't partially applied
+    for (int pass = 0; pass < 2; pass++)
+    {
+        size_t offset = CHECKPOINT_HEADER_SIZE;
+
+        for (uint32_t range = 0; range < RANGES; range++)
+        {
+            if ((END - offset) < CHECKPOINT_RANGE_HEADER_SIZE)
+            {
+                return false;
+            }
+
+            const uint32_t START = get(offset);
+            const uint32_t SIZE  = get(offset + 4);
+
+            offset += CHECKPOINT_RANGE_HEADER_SIZE;
+
+            if ((START > _memoryUsage) || (SIZE > (_memoryUsage - START)) || (SIZE > (END - offset)))
+            {
+                return false;
+            }
+
+            if (pass && !writeRange(_initialAddress + START, &checkpoint[offset], SIZE))
+            {
+                return false;
+            }
+
+            offset += SIZE;
+        }
+
+        if (offset != END)
+        {
+            return false;
+        }
+    }
+
+    if (!flush())
+    {
+        return false;
+    }
+
+    // database now holds the content of this checkpoint
+    _checkpointSequence = SEQUENCE;
+    _checkpointDirty.assign(_checkpointDirty.size(), false);
+
+    return true;
+}
+
+/// Returns the sequence number of the checkpoint created or restored last,
+/// or 0 if there is no checkpoint on which incremental checkpoint could be based.
+uint32_t LessDb::checkpointSequence() const
+{
+    return _checkpointSequence;
+}
+
+/// Writes the image of the database to specified sink. Image starts with a header holding
+/// the magic value, format version, layout hash and database size, followed by database
+/// content and FNV-1a checksum of everything before it. Content is compared with the
+/// default values of the layout and stored in runs: bytes which hold their defaults are
+/// stored only as the length of the run, repeated bytes are stored once and all other
+/// bytes are stored as they are. Pending changes are flushed first.
+/// param [in] sink     Destination of the image.
+/// returns: True on success, false if layout isn't set or if reading or writing fails.
+bool LessDb::exportImage(DataSink& sink)
+{
+    if ((_descriptorTable == nullptr) || _transactionActive || !flush())
+    {
+        return false;
+    }
+
+    uint32_t hash = IMAGE_CHECKSUM_BASIS;
+
+    auto output = [&](const uint8_t* data, size_t size)
+    {
+        hash = checksum(hash, data, size);
+        return sink.write(data, size);
+    };
+
+    uint8_t buffer[RANGE_BUFFER_SIZE];
+
+    const uint32_t HEADER[] = { IMAGE_MAGIC, _layoutHash, _memoryUsage };
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        buffer[i]     = HEADER[0] >> (8 * i);
+        buffer[5 + i] = HEADER[1] >> (8 * i);
+        buffer[9 + i] = HEADER[2] >> (8 * i);
+    }
+
+    buffer[4] = IMAGE_VERSION;
+
+    if (!output(buffer, IMAGE_HEADER_SIZE))
+    {
+        return false;
+    }
+
+    ImageEncoder encoder(output);
+
+    for (size_t section = 0; section < numberOfSections(); section++)
+    {
+        const SectionDescriptor& descriptor = _descriptorTable[section];
+        const uint32_t           SIZE       = sectionSize(descriptor.type, descriptor.numberOfParameters);
+
+        for (uint32_t offset = 0; offset < SIZE; offset += RANGE_BUFFER_SIZE)
+        {
+            const size_t CHUNK = (SIZE - offset) < RANGE_BUFFER_SIZE ? (SIZE - offset) : RANGE_BUFFER_SIZE;
+
+            if (!readBytes(descriptor.address + offset, buffer, CHUNK))
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < CHUNK; i++)
+            {
+                if (!encoder.append(buffer[i], defaultByte(descriptor, offset + i)))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (!encoder.finish())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < IMAGE_CHECKSUM_SIZE; i++)
+    {
+        buffer[i] = hash >> (8 * i);
+    }
+
+    return sink.write(buffer, IMAGE_CHECKSUM_SIZE);
+}
+
+/// Writes the content of database image created with exportImage() to the database.
+/// Entire image is validated before anything is written, and the content is written
+/// in ranges of RANGE_BUFFER_SIZE bytes.
+/// param [in] image    Database image.
+/// param [in] size     Size of the image in bytes.
+/// returns: True on success, false if image is malformed, belongs to different layout or if writing fails.
+bool LessDb::importImage(const uint8_t* image, size_t size)
+{
+    if ((_descriptorTable == nullptr) || _transactionActive || (size < (IMAGE_HEADER_SIZE + IMAGE_CHECKSUM_SIZE)))
+    {
+        return false;
+    }
+
+    auto get = [image](size_t offset)
+    {
+        uint32_t value = 0;
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            value |= static_cast<uint32_t>(image[offset + i]) << (8 * i);
+        }
+
+        return value;
+    };
+
+    const size_t END = size - IMAGE_CHECKSUM_SIZE;
+
+    if ((get(0) != IMAGE_MAGIC) ||
+        (image[4] != IMAGE_VERSION) ||
+        (get(5) != _layoutHash) ||
+        (get(9) != _memoryUsage) ||
+        (get(END) != checksum(IMAGE_CHECKSUM_BASIS, image, END)))
+    {
+        return false;
+    }
+
+    uint8_t buffer[RANGE_BUFFER_SIZE];
+
+    // first pass only validates the runs so that malformed image isn't partially applied
+    for (int pass = 0; pass < 2; pass++)
+    {
+        ImageDecoder decoder(&image[IMAGE_HEADER_SIZE], END - IMAGE_HEADER_SIZE);
+
+        for (size_t section = 0; section < numberOfSections(); section++)
+        {
+            const SectionDescriptor& descriptor = _descriptorTable[section];
+            const uint32_t           SIZE       = sectionSize(descriptor.type, descriptor.numberOfParameters);
+
+            for (uint32_t offset = 0; offset < SIZE; offset += RANGE_BUFFER_SIZE)
+            {
+                const size_t CHUNK = (SIZE - offset) < RANGE_BUFFER_SIZE ? (SIZE - offset) : RANGE_BUFFER_SIZE;
+
+                for (size_t i = 0; i < CHUNK; i++)
+                {
+                    if (!decoder.next(defaultByte(descriptor, offset + i), buffer[i]))
+                    {
+                        return false;
+                    }
+                }
+
+                if (pass && !writeRange(descriptor.address + offset, buffer, CHUNK))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (!decoder.done())
+        {
+            return false;
+        }
+    }
+
+    return flush();
+}
+
+/// Marks the pages holding specified range of bytes as changed since the last checkpoint.
+/// Bytes outside of the database are ignored.
+/// param [in] address  Address of the first byte.
+/// param [in] size     Number of bytes.
+void LessDb::markCheckpointDirty(uint32_t address, size_t size)
+{
+    if (_checkpointDirty.empty() || !size)
+    {
+        return;
+    }
+
+    const uint32_t START = std::max(address, _initialAddress);
+    const uint32_t STOP  = std::min(static_cast<uint32_t>(address + size), _initialAddress + _memoryUsage);
+
+    if (STOP <= START)
+    {
+        return;
+    }
+
+    for (size_t page = (START - _initialAddress) / _checkpointPageSize; page <= ((STOP - _initialAddress - 1) / _checkpointPageSize); page++)
+    {
+        _checkpointDirty[page] = true;
+    }
+}
+
+/// Allocates change tracking for the active layout. All pages are marked as changed.
+void LessDb::resetCheckpointPages()
+{
+    if (!_checkpointPageSize || (_descriptorTable == nullptr))
+    {
+        _checkpointDirty.clear();
+        return;
+    }
+
+    _checkpointDirty.assign((_memoryUsage + _checkpointPageSize - 1) / _checkpointPageSize, true);
+}
+
+/// Appends bytes to 32-bit FNV-1a hash.
+/// param [in] hash     Hash calculated so far, or FNV offset basis for the first bytes.
+/// param [in] data     Bytes to append.
+/// param [in] size     Number of bytes.
+/// returns: Updated hash.
+uint32_t LessDb::checksum(uint32_t hash, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619;
+    }
+
+    return hash;
+}
+
+/// Returns statistics collected since the database was created or statistics were reset.
+/// Statistics are collected only if the library is built with LESSDB_STATS defined,
+/// otherwise all values are zero.
+Stats LessDb::stats() const
+{
+    Stats stats = _stats.stats();
+
+    if constexpr (StatsCollector::ENABLED)
+    {
+        stats.cacheHits   = _readCacheHits;
+        stats.cacheMisses = _readCacheMisses;
+        stats.bytesWritten.resize(_numberOfBlocks);
+
+        for (size_t block = 0; block < _numberOfBlocks; block++)
+        {
+            for (size_t section = _blockTable[block]; section < _blockTable[block + 1]; section++)
+            {
+                stats.bytesWritten[block].push_back(_stats.sectionBytes(section));
+            }
+        }
+    }
+
+    return stats;
+}
+
+/// Resets all statistics, including read cache counters.
+/// Read cache counters are reset even if statistics aren't collected.
+void LessDb::resetStats()
+{
+    _stats.reset();
+
+    _readCacheHits   = 0;
+    _readCacheMisses = 0;
+}
+
+/// Checks whether transaction is active.
+bool LessDb::transactionActive() const
+{
+    return _transactionActive;
+}
+
+/// Sets the storage region used as transaction journal. Region must not overlap
+/// the database. If the journal holds committed changes which weren't completely
+/// written to the database, they are written now.
+/// param [in] address  Address of the journal.
+/// param [in] size     Size of the journal in bytes. Limits the amount of changes
+///                     per transaction. Set to 0 to disable the journal.
+/// returns: True on success, false otherwise.
+bool LessDb::setJournal(uint32_t address, uint32_t size)
+{
+    _journalAddress = 0;
+    _journalSize    = 0;
+
+    if (!size)
+    {
+        return true;
+    }
+
+    if ((size <= JOURNAL_HEADER_SIZE) || ((address + size) > _hwa.size()) || (address + size < address))
+    {
+        return false;
+    }
+
+    if ((_descriptorTable != nullptr) && (address < (_initialAddress + _memoryUsage)) && (_initialAddress < (address + size)))
+    {
+        return false;
+    }
+
+    _journalAddress = address;
+    _journalSize    = size;
+
+    return recoverJournal();
+}
+
+/// Assigns region of memory outside of the database in which database header is stored.
+/// Header holds the hash of the layout with which the data has been initialized, so that
+/// setLayout() can check whether stored data matches the layout with a single read
+/// instead of initializing the database on every start. Result of the check is
+/// available through layoutStatus().
+/// param [in] setting  Whether to use the header.
+/// param [in] address  Address of the header. Header takes HEADER_SIZE bytes.
+/// returns: True on success, false if header doesn't fit into memory, overlaps
+///          the database or can't be read.
+bool LessDb::setHeader(headerSetting_t setting, uint32_t address)
+{
+    _headerSetting = headerSetting_t::DISABLE;
+    _layoutStatus  = layoutStatus_t::UNKNOWN;
+
+    if (setting == headerSetting_t::DISABLE)
+    {
+        return true;
+    }
+
+    if (((address + HEADER_SIZE) > _hwa.size()) || ((address + HEADER_SIZE) < address))
+    {
+        return false;
+    }
+
+    _headerAddress = address;
+
+    if (_descriptorTable == nullptr)
+    {
+        _headerSetting = headerSetting_t::ENABLE;
+        return true;
+    }
+
+    if (headerOverlaps(_initialAddress, _memoryUsage))
+    {
+        return false;
+    }
+
+    _headerSetting = headerSetting_t::ENABLE;
+    return readHeader();
+}
+
+/// Returns whether the data in storage matches the active layout, as determined
+/// from database header when the layout was set.
+layoutStatus_t LessDb::layoutStatus() const
+{
+    return _layoutStatus;
+}
+
+/// Returns the hash of active layout, as stored in database header.
+/// Returns 0 if layout isn't set.
+uint32_t LessDb::layoutHash() const
+{
+    return _layoutHash;
+}
+
+/// Writes database header for active layout, so that the stored data is reported
+/// as valid on next start. Called by initData(). Applications which migrate
+/// the data from previous layout themselves should call it once the migration is done.
+/// returns: True on success, false if header isn't used, layout isn't set or writing fails.
+bool LessDb::writeHeader()
+{
+    if ((_headerSetting != headerSetting_t::ENABLE) || (_descriptorTable == nullptr))
+    {
+        return false;
+    }
+
+    const uint32_t VALUES[HEADER_SIZE / 4] = { HEADER_MAGIC, HEADER_VERSION, _layoutHash };
+    uint8_t        header[HEADER_SIZE];
+
+    for (size_t i = 0; i < HEADER_SIZE; i++)
+    {
+        header[i] = VALUES[i / 4] >> (8 * (i % 4));
+    }
+
+    if (!hwaWriteRange(_headerAddress, header, HEADER_SIZE))
+    {
+        return false;
+    }
+
+    _layoutStatus = layoutStatus_t::VALID;
+    return true;
+}
+
+/// Reads database header with a single storage access and compares it with active layout.
+/// returns: True on success, false if header can't be read.
+bool LessDb::readHeader()
+{
+    uint8_t  header[HEADER_SIZE];
+    uint32_t values[HEADER_SIZE / 4] = {};
+
+    _stats.hwaRangeRead();
+
+    if (!_hwa.readRange(_headerAddress, header, HEADER_SIZE))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < HEADER_SIZE; i++)
+    {
+        values[i / 4] |= static_cast<uint32_t>(header[i]) << (8 * (i % 4));
+    }
+
+    if (values[0] != HEADER_MAGIC)
+    {
+        _layoutStatus = layoutStatus_t::NEEDS_INIT;
+    }
+    else if ((values[1] != HEADER_VERSION) || (values[2] != _layoutHash))
+    {
+        _layoutStatus = layoutStatus_t::NEEDS_MIGRATION;
+    }
+    else
+    {
+        _layoutStatus = layoutStatus_t::VALID;
+    }
+
+    return true;
+}
+
+/// Checks whether database header overlaps specified region.
+/// param [in] address  Start of the region.
+/// param [in] size     Size of the region.
+/// returns: True if regions overlap, false otherwise.
+bool LessDb::headerOverlaps(uint32_t address, uint32_t size) const
+{
+    return (_headerAddress < (address + size)) && (address < (_headerAddress + HEADER_SIZE));
+}
+
+/// Assigns region of memory outside of the database in which the map of sections
+/// which are at defaults is stored, one bit per section. With lazy reset enabled,
+/// initData() only marks the sections in the map instead of writing all the
+/// parameters. Reads from marked sections return default values without accessing
+/// the storage, and the section is written with defaults once it is updated.
+/// Map is loaded when the layout is set, so initData() has to be called once
+/// after the region is assigned for the first time.
+/// Disabling lazy reset writes defaults to all sections which are still marked.
+/// param [in] setting  Whether to use lazy reset.
+/// param [in] address  Address of the map. Map takes one byte for every eight sections.
+/// returns: True on success, false if map doesn't fit into memory, overlaps
+///          the database or can't be accessed.
+bool LessDb::setLazyReset(lazyResetSetting_t setting, uint32_t address)
+{
+    if (_transactionActive)
+    {
+        return false;
+    }
+
+    if (setting == lazyResetSetting_t::DISABLE)
+    {
+        for (size_t section = 0; section < numberOfSections(); section++)
+        {
+            if (!materializeSection(section))
+            {
+                return false;
+            }
+        }
+
+        _lazyResetSetting = lazyResetSetting_t::DISABLE;
+        _defaultedMap.clear();
+        return flush();
+    }
+
+    if (address >= _hwa.size())
+    {
+        return false;
+    }
+
+    _lazyResetSetting = lazyResetSetting_t::DISABLE;
+    _lazyResetAddress = address;
+
+    if (_descriptorTable == nullptr)
+    {
+        _lazyResetSetting = setting;
+        return true;
+    }
+
+    const uint32_t MAP_SIZE = defaultedMapSize();
+
+    if (((address + MAP_SIZE) > _hwa.size()) ||
+        ((address < (_initialAddress + _memoryUsage)) && (_initialAddress < (address + MAP_SIZE))))
+    {
+        return false;
+    }
+
+    _lazyResetSetting = setting;
+    return loadDefaultedMap();
+}
+
+/// Checks whether specified section is at defaults after lazy reset.
+/// param [in] blockIndex     Block index.
+/// param [in] sectionIndex   Section index.
+/// returns: True if section hasn't been written since it was reset, false otherwise.
+bool LessDb::sectionDefaulted(size_t blockIndex, size_t sectionIndex) const
+{
+    if (parameterDescriptor(blockIndex, sectionIndex, 0) == nullptr)
+    {
+        return false;
+    }
+
+    return defaulted(_blockTable[blockIndex] + sectionIndex);
+}
+
+/// Reads the map of sections which are at defaults from the storage with a single access.
+/// returns: True on success, false otherwise.
+bool LessDb::loadDefaultedMap()
+{
+    _defaultedMap.assign(defaultedMapSize(), 0);
+    _defaultedSections = 0;
+
+    _stats.hwaRangeRead();
+
+    if (!_hwa.readRange(_lazyResetAddress, _defaultedMap.data(), _defaultedMap.size()))
+    {
+        _defaultedMap.assign(_defaultedMap.size(), 0);
+        return false;
+    }
+
+    // bits beyond the last section are ignored
+    if (numberOfSections() % 8)
+    {
+        _defaultedMap.back() &= (1 << (numberOfSections() % 8)) - 1;
+    }
+
+    for (size_t section = 0; section < numberOfSections(); section++)
+    {
+        _defaultedSections += (_defaultedMap[section / 8] & BIT_MASK[section % 8]) != 0;
+    }
+
+    return true;
+}
+
+/// Marks all sections affected by factory reset as being at defaults and stores the map.
+/// param [in] type     Type of initialization (partial or full).
+/// returns: True on success, false otherwise.
+bool LessDb::markDefaulted(factoryResetType_t type)
+{
+    for (size_t section = 0; section < numberOfSections(); section++)
+    {
+        if ((_descriptorTable[section].preserveOnPartialReset == preserveSetting_t::ENABLE) &&
+            (type == factoryResetType_t::PARTIAL))
+        {
+            continue;
+        }
+
+        setDefaulted(section, true);
+
+        // stored data doesn't change, but its content as seen by reads does
+        markCheckpointDirty(_descriptorTable[section].address, sectionSize(_descriptorTable[section].type, _descriptorTable[section].numberOfParameters));
+    }
+
+    if (_defaultedMap.empty())
+    {
+        return true;
+    }
+
+    return hwaWriteRange(_lazyResetAddress, _defaultedMap.data(), _defaultedMap.size());
+}
+
+/// Writes default values to section which is at defaults and clears its mark.
+/// Defaults are written outside of active transaction, since reads already return them.
+/// Mark is cleared in the storage only once the defaults have been stored.
+/// param [in] section  Index of the section in descriptor table.
+/// returns: True on success or if section isn't at defaults, false otherwise.
+bool LessDb::materializeSection(size_t section)
+{
+    if (!defaulted(section))
+    {
+        return true;
+    }
+
+    const bool TRANSACTION = _transactionActive;
+
+    // cleared first so that writing the defaults doesn't get here again
+    setDefaulted(section, false);
+    _transactionActive = false;
+
+    bool result = initSection(_descriptorTable[section]) && flush();
+
+    _transactionActive = TRANSACTION;
+
+    if (result)
+    {
+        result = hwaWrite(_lazyResetAddress + (section / 8), _defaultedMap[section / 8], sectionParameterType_t::BYTE);
+    }
+
+    if (!result)
+    {
+        setDefaulted(section, true);
+    }
+
+    return result;
+}
+
+/// Writes default values to all sections at defaults which overlap specified range.
+/// param [in] address  Address of the first byte in range.
+/// param [in] size     Number of bytes in range.
+/// returns: True on success, false otherwise.
+bool LessDb::materializeRange(uint32_t address, size_t size)
+{
+    // sections are stored in ascending order of addresses
+    for (size_t section = 0; _defaultedSections && (section < numberOfSections()); section++)
+    {
+        const SectionDescriptor& descriptor = _descriptorTable[section];
+
+        if (descriptor.address >= (address + size))
+        {
+            break;
         }
 
-        if (returnValue)
+        if (((descriptor.address + sectionSize(descriptor.type, descriptor.numberOfParameters)) > address) && !materializeSection(section))
         {
-            // sanitize
-            value &= static_cast<uint32_t>(0x0F);
+            return false;
         }
     }
-    break;
 
-    case sectionParameterType_t::WORD:
+    return true;
+}
+
+/// Replaces bytes of sections which are at defaults with default content.
+/// param [in] address      Address of the first byte in buffer.
+/// param [in, out] buffer  Bytes read from the storage.
+/// param [in] size         Number of bytes in buffer.
+void LessDb::overlayDefaults(uint32_t address, uint8_t* buffer, size_t size) const
+{
+    for (size_t section = 0; _defaultedSections && (section < numberOfSections()); section++)
     {
-        startAddress += parameterIndex * 2;
+        const SectionDescriptor& descriptor = _descriptorTable[section];
+
+        if (descriptor.address >= (address + size))
+        {
+            break;
+        }
 
-        if (_hwa.read(startAddress, value, sectionParameterType_t::WORD))
+        if (!defaulted(section))
         {
-            // sanitize
-            value &= static_cast<uint32_t>(0xFFFF);
+            continue;
         }
-        else
+
+        const uint32_t START = std::max(address, descriptor.address);
+        const uint32_t END   = std::min<uint32_t>(address + size, descriptor.address + sectionSize(descriptor.type, descriptor.numberOfParameters));
+
+        for (uint32_t byte = START; byte < END; byte++)
         {
-            returnValue = false;
+            buffer[byte - address] = defaultByte(descriptor, byte - descriptor.address);
         }
     }
-    break;
+}
 
-    default:
+/// Checks whether section is marked as being at defaults.
+/// param [in] section  Index of the section in descriptor table.
+bool LessDb::defaulted(size_t section) const
+{
+    return _defaultedSections && (_defaultedMap[section / 8] & BIT_MASK[section % 8]);
+}
+
+/// Marks or unmarks section as being at defaults in RAM copy of the map.
+/// param [in] section  Index of the section in descriptor table.
+/// param [in] state    True to mark the section, false to unmark it.
+void LessDb::setDefaulted(size_t section, bool state)
+{
+    if (((_defaultedMap[section / 8] & BIT_MASK[section % 8]) != 0) == state)
     {
-        // case sectionParameterType_t::dword:
-        startAddress += parameterIndex * 4;
-        return _hwa.read(startAddress, value, sectionParameterType_t::DWORD);
-    }
-    break;
+        return;
     }
 
-    if (returnValue)
+    if (state)
     {
-        _lastReadAddress = startAddress;
+        _defaultedMap[section / 8] |= BIT_MASK[section % 8];
+        _defaultedSections++;
+    }
+    else
+    {
+        _defaultedMap[section / 8] &= ~BIT_MASK[section % 8];
+        _defaultedSections--;
     }
-
-    return returnValue;
 }
 
-/// Reads a value from database with reduced error checking.
-/// param [in] blockIndex         Block index.
-/// param [in] sectionIndex       Section index.
-/// param [in] parameterIndex  Parameter index.
-/// returns: Value from database. In case of read failure, 0 will be returned.
-uint32_t LessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+/// Returns the size of the map of sections which are at defaults for active layout.
+uint32_t LessDb::defaultedMapSize() const
 {
-    uint32_t value = 0;
-    read(blockIndex, sectionIndex, parameterIndex, value);
-    return value;
+    return (numberOfSections() + 7) / 8;
 }
 
-/// Updates value for specified block and section in database.
-/// param [in] blockIndex         Block index.
-/// param [in] sectionIndex       Section index.
-/// param [in] parameterIndex  Parameter index.
-/// param [in] newValue        New value for parameter.
+/// Writes runs of staged bytes to the journal and marks them as committed.
+/// param [in] runs     Encoded runs: address, size and data for each run.
 /// returns: True on success, false otherwise.
-bool LessDb::update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue)
+bool LessDb::writeJournal(const std::vector<uint8_t>& runs)
 {
-    if (!LAYOUT_ACCESS.size())
+    if ((runs.size() + JOURNAL_HEADER_SIZE) > _journalSize)
     {
         return false;
     }
 
-    // sanity check
-    if (!checkParameters(blockIndex, sectionIndex, parameterIndex))
+    if (!hwaWriteRange(_journalAddress + JOURNAL_HEADER_SIZE, runs.data(), runs.size()))
     {
         return false;
     }
 
-    uint32_t               startAddress  = sectionAddress(blockIndex, sectionIndex);
-    sectionParameterType_t parameterType = LAYOUT_ACCESS[blockIndex]._sections[sectionIndex].PARAMETER_TYPE;
+    if (!hwaWrite(_journalAddress + 4, runs.size(), sectionParameterType_t::DWORD))
+    {
+        return false;
+    }
 
-    uint8_t  arrayIndex;
-    uint32_t arrayValue;
-    uint8_t  bitIndex;
+    // single write which makes the transaction committed
+    return hwaWrite(_journalAddress, JOURNAL_MAGIC, sectionParameterType_t::DWORD);
+}
 
-    switch (parameterType)
-    {
-    case sectionParameterType_t::BIT:
-    {
-        // reset cached address to initiate new read
-        _lastReadAddress = 0xFFFFFFFF;
-        // sanitize input
-        newValue &= static_cast<uint32_t>(0x01);
-        arrayIndex = parameterIndex / 8;
-        bitIndex   = parameterIndex - 8 * arrayIndex;
-        startAddress += arrayIndex;
+/// Completes the commit interrupted after the journal has been written.
+/// returns: True if journal is empty or its content has been written, false otherwise.
+bool LessDb::recoverJournal()
+{
+    uint32_t magic;
 
-        // read existing value first
-        if (_hwa.read(startAddress, arrayValue, sectionParameterType_t::BIT))
-        {
-            // update value with new bit
-            if (newValue)
-            {
-                arrayValue |= BIT_MASK[bitIndex];
-            }
-            else
-            {
-                arrayValue &= ~BIT_MASK[bitIndex];
-            }
+    _stats.hwaRead(sectionParameterType_t::DWORD);
 
-            return write(startAddress, arrayValue, sectionParameterType_t::BIT);
-        }
+    if (!_hwa.read(_journalAddress, magic, sectionParameterType_t::DWORD))
+    {
+        return false;
     }
-    break;
 
-    case sectionParameterType_t::BYTE:
+    if (magic != JOURNAL_MAGIC)
     {
-        // sanitize input
-        newValue &= static_cast<uint32_t>(0xFF);
-        startAddress += parameterIndex;
-        return write(startAddress, newValue, sectionParameterType_t::BYTE);
+        return true;
     }
-    break;
 
-    case sectionParameterType_t::HALF_BYTE:
-    {
-        // reset cached address to initiate new read
-        _lastReadAddress = 0xFFFFFFFF;
-        // sanitize input
-        newValue &= static_cast<uint32_t>(0x0F);
-        startAddress += (parameterIndex / 2);
+    uint32_t length;
 
-        // read old value first
-        if (_hwa.read(startAddress, arrayValue, sectionParameterType_t::HALF_BYTE))
-        {
-            if (parameterIndex % 2)
-            {
-                // clear content in bits 4-7 and update the value
-                arrayValue &= 0x0F;
-                arrayValue |= (newValue << 4);
-            }
-            else
-            {
-                // clear content in bits 0-3 and update the value
-                arrayValue &= 0xF0;
-                arrayValue |= newValue;
-            }
+    _stats.hwaRead(sectionParameterType_t::DWORD);
 
-            return write(startAddress, arrayValue, sectionParameterType_t::HALF_BYTE);
-        }
+    if (!_hwa.read(_journalAddress + 4, length, sectionParameterType_t::DWORD))
+    {
+        return false;
     }
-    break;
 
-    case sectionParameterType_t::WORD:
+    if (length > (_journalSize - JOURNAL_HEADER_SIZE))
     {
-        // sanitize input
-        newValue &= static_cast<uint32_t>(0xFFFF);
-        startAddress += (parameterIndex * 2);
-        return write(startAddress, newValue, sectionParameterType_t::WORD);
+        return false;
     }
-    break;
 
-    case sectionParameterType_t::DWORD:
+    std::vector<uint8_t> runs(length);
+
+    _stats.hwaRangeRead();
+
+    if (!_hwa.readRange(_journalAddress + JOURNAL_HEADER_SIZE, runs.data(), length))
     {
-        startAddress += (parameterIndex * 4);
-        return write(startAddress, newValue, sectionParameterType_t::DWORD);
+        return false;
     }
-    break;
+
+    if (!applyRuns(runs.data(), length, true))
+    {
+        return false;
     }
 
-    return false;
-}
+    resetReadCache();
 
-/// Convenience function to write value at specified address.
-/// param [in] address Address to which to write the variable.
-/// param [in] value   Value to write.
-/// param [in] type    Type of variable.
-/// returns: True if writing succedes and read value matches the specified value, false otherwise.
-bool LessDb::write(uint32_t address, uint32_t value, sectionParameterType_t type)
-{
-    if (_hwa.write(address, value, type))
+    if (shadowActive() && !loadShadow())
     {
-        uint32_t readValue;
-
-        if (_hwa.read(address, readValue, type))
-        {
-            return (value == readValue);
-        }
+        return false;
     }
 
-    return false;
-}
-
-/// Clears entire memory.
-bool LessDb::clear()
-{
-    return _hwa.clear();
+    return hwaWrite(_journalAddress, 0, sectionParameterType_t::DWORD);
 }
 
-/// Writes default values to memory.
-/// param [in] type     Type of initialization (partial or full).
-///                     Full will simply overwrite currently existing data.
-///                     Partial will leave data as is, but only if
-///                     preserveOnPartialReset parameter is set to true.
-bool LessDb::initData(factoryResetType_t type)
+/// Writes runs of bytes encoded in the journal format.
+/// param [in] runs     Encoded runs: address, size and data for each run.
+/// param [in] size     Total size of encoded runs.
+/// param [in] direct   If set to true, runs are written directly to the storage, bypassing RAM shadow.
+/// returns: True on success, false otherwise.
+bool LessDb::applyRuns(const uint8_t* runs, size_t size, bool direct)
 {
-    for (size_t block = 0; block < LAYOUT_ACCESS.size(); block++)
+    for (size_t offset = 0; (offset + JOURNAL_RUN_HEADER_SIZE) <= size;)
     {
-        for (size_t section = 0; section < LAYOUT_ACCESS[block]._sections.size(); section++)
-        {
-            if (
-                (LAYOUT_ACCESS[block]._sections[section].PRESERVE_ON_PARTIAL_RESET == preserveSetting_t::ENABLE) &&
-                (type == factoryResetType_t::PARTIAL))
-            {
-                continue;
-            }
+        const uint8_t* header  = &runs[offset];
+        uint32_t       address = 0;
 
-            uint32_t startAddress = sectionAddress(block, section);
-
-            auto  parameterType      = LAYOUT_ACCESS[block]._sections[section].PARAMETER_TYPE;
-            auto  defaultValue       = LAYOUT_ACCESS[block]._sections[section].DEFAULT_VALUE;
-            auto& defaultValues      = LAYOUT_ACCESS[block]._sections[section].DEFAULT_VALUES;
-            auto  numberOfParameters = LAYOUT_ACCESS[block]._sections[section].NUMBER_OF_PARAMETERS;
+        for (size_t i = 0; i < 4; i++)
+        {
+            address |= static_cast<uint32_t>(header[i]) << (8 * i);
+        }
 
-            switch (parameterType)
-            {
-            case sectionParameterType_t::BYTE:
-            case sectionParameterType_t::WORD:
-            case sectionParameterType_t::DWORD:
-            {
-                for (size_t parameter = 0; parameter < numberOfParameters; parameter++)
-                {
-                    if (LAYOUT_ACCESS[block]._sections[section].AUTO_INCREMENT == autoIncrementSetting_t::ENABLE)
-                    {
-                        if (!write(startAddress, defaultValue + parameter, parameterType))
-                        {
-                            return false;
-                        }
-                    }
-                    else
-                    {
-                        // use values from vector only when:
-                        // 1) auto-increment is disabled
-                        // 2)vector size matches the amount of parameters
-
-                        if (defaultValues.size() == numberOfParameters)
-                        {
-                            defaultValue = defaultValues.at(parameter);
-                        }
-
-                        if (!write(startAddress, defaultValue, parameterType))
-                        {
-                            return false;
-                        }
-                    }
+        const size_t RUN_SIZE = header[4] | (header[5] << 8);
 
-                    if (parameterType == sectionParameterType_t::BYTE)
-                    {
-                        startAddress++;
-                    }
-                    else if (parameterType == sectionParameterType_t::WORD)
-                    {
-                        startAddress += 2;
-                    }
-                    else if (parameterType == sectionParameterType_t::DWORD)
-                    {
-                        startAddress += 4;
-                    }
-                }
-            }
-            break;
+        offset += JOURNAL_RUN_HEADER_SIZE;
 
-            case sectionParameterType_t::BIT:
-            {
-                // no auto-increment here
-                size_t loops = (numberOfParameters / 8) + ((numberOfParameters % 8) != 0);
+        if ((offset + RUN_SIZE) > size)
+        {
+            return false;
+        }
 
-                // optimize the writing - merge values into single byte
-                for (size_t loop = 0; loop < loops; loop++)
-                {
-                    uint8_t value = 0;
+        if (!(direct ? hwaWriteRange(address, &runs[offset], RUN_SIZE) : writeRange(address, &runs[offset], RUN_SIZE)))
+        {
+            return false;
+        }
 
-                    for (uint8_t bit = 0; bit < 8; bit++)
-                    {
-                        const size_t PARAMETER = (loop * 8) + bit;
+        offset += RUN_SIZE;
+    }
 
-                        if (PARAMETER >= numberOfParameters)
-                        {
-                            break;
-                        }
+    return true;
+}
 
-                        if (defaultValues.size() == numberOfParameters)
-                        {
-                            defaultValue = defaultValues.at(PARAMETER) & 0x01;
-                        }
+/// Sets the number of entries in read cache.
+/// Cache holds recently read values of all types and is used only
+/// when reading from the storage, that is, when shadowing is disabled.
+/// Storage must not be modified outside of this instance while cache is enabled.
+/// Hit and miss counters are reset.
+/// param [in] entries  Number of entries. Must be a power of two not larger
+///                     than READ_CACHE_MAX_SIZE. Set to 0 to disable the cache.
+/// returns: True on success, false if specified number of entries isn't supported.
+bool LessDb::setReadCacheSize(size_t entries)
+{
+    if ((entries > READ_CACHE_MAX_SIZE) || (entries & (entries - 1)))
+    {
+        return false;
+    }
 
-                        value <<= 1;
-                        value |= defaultValue;
-                    }
+    _readCacheSize   = entries;
+    _readCacheHits   = 0;
+    _readCacheMisses = 0;
+    resetReadCache();
 
-                    if (!write(startAddress, value, sectionParameterType_t::BYTE))
-                    {
-                        return false;
-                    }
+    return true;
+}
 
-                    startAddress++;
-                }
-            }
-            break;
+/// Returns the number of reads served from read cache since last reset.
+uint32_t LessDb::readCacheHits() const
+{
+    return _readCacheHits;
+}
 
-            case sectionParameterType_t::HALF_BYTE:
-            {
-                // no auto-increment here
-                size_t loops = (numberOfParameters / 2) + ((numberOfParameters % 2) != 0);
+/// Returns the number of reads which had to access the storage since last reset.
+uint32_t LessDb::readCacheMisses() const
+{
+    return _readCacheMisses;
+}
 
-                // optimize the writing - merge values into single byte
-                for (size_t loop = 0; loop < loops; loop++)
-                {
-                    uint8_t value = 0;
+/// Invalidates all read cache entries. Hit and miss counters are kept.
+void LessDb::resetReadCache()
+{
+    for (auto& entry : _readCache)
+    {
+        entry.size = 0;
+    }
+}
 
-                    for (uint8_t halfByte = 0; halfByte < 2; halfByte++)
-                    {
-                        const size_t PARAMETER = (loop * 2) + halfByte;
+/// Invalidates read cache entries holding any of the bytes in specified range.
+/// param [in] address  Address of the first byte.
+/// param [in] size     Number of bytes.
+void LessDb::invalidateReadCache(uint32_t address, size_t size)
+{
+    for (size_t i = 0; i < _readCacheSize; i++)
+    {
+        ReadCacheEntry& entry = _readCache[i];
 
-                        if (PARAMETER >= numberOfParameters)
-                        {
-                            break;
-                        }
+        if (entry.size && (entry.address < (address + size)) && (address < (entry.address + entry.size)))
+        {
+            entry.size = 0;
+        }
+    }
+}
 
-                        if (defaultValues.size() == numberOfParameters)
-                        {
-                            defaultValue = defaultValues.at(PARAMETER) & 0x0F;
-                        }
+/// Returns read cache entry to which specified address is mapped.
+/// Address is scaled by value width so that consecutive parameters
+/// of any type map to consecutive entries.
+/// param [in] address  Address of the value.
+/// param [in] type     Type of the value.
+LessDb::ReadCacheEntry& LessDb::readCacheEntry(uint32_t address, sectionParameterType_t type)
+{
+    return _readCache[(address >> (typeWidth(type) >> 1)) & (_readCacheSize - 1)];
+}
 
-                        value <<= 4;
-                        value |= defaultValue;
-                    }
+/// Returns the amount of bytes used by specified parameter type in storage.
+uint8_t LessDb::typeWidth(sectionParameterType_t type)
+{
+    switch (type)
+    {
+    case sectionParameterType_t::WORD:
+        return 2;
 
-                    if (!write(startAddress, value, sectionParameterType_t::BYTE))
-                    {
-                        return false;
-                    }
+    case sectionParameterType_t::DWORD:
+        return 4;
 
-                    startAddress++;
-                }
-            }
-            break;
-            }
-        }
+    default:
+        return 1;
     }
-
-    return true;
 }
 
 /// Checks for total memory usage of database.
@@ -713,37 +3531,156 @@ uint32_t LessDb::nextParameterAddress() const
     return _nextBlockAddress;
 }
 
-/// Validates input parameters before attempting to read or write data.
+/// Returns the total number of sections in active layout.
+size_t LessDb::numberOfSections() const
+{
+    return _numberOfBlocks ? _blockTable[_numberOfBlocks] : 0;
+}
+
+/// Validates input parameters and retrieves descriptor of the section in which parameter is located.
 /// param [in] blockIndex         Block index.
 /// param [in] sectionIndex       Section index.
-/// param [in] parameterID     Parameter index.
-/// returns: True if parameters are valid, false otherwise.
-bool LessDb::checkParameters(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+/// param [in] parameterIndex     Parameter index.
+/// returns: Pointer to section descriptor if parameters are valid, nullptr otherwise.
+const LessDb::SectionDescriptor* LessDb::parameterDescriptor(size_t blockIndex, size_t sectionIndex, size_t parameterIndex) const
 {
     // sanity check
-    if (blockIndex >= LAYOUT_ACCESS.size())
+    if (blockIndex >= _numberOfBlocks)
     {
-        return false;
+        return nullptr;
     }
 
-    if (sectionIndex >= LAYOUT_ACCESS[blockIndex]._sections.size())
+    const size_t INDEX = _blockTable[blockIndex] + sectionIndex;
+
+    if (INDEX >= _blockTable[blockIndex + 1])
     {
-        return false;
+        return nullptr;
     }
 
-    if (parameterIndex >= LAYOUT_ACCESS[blockIndex]._sections[sectionIndex].NUMBER_OF_PARAMETERS)
+    if (parameterIndex >= _descriptorTable[INDEX].numberOfParameters)
     {
-        return false;
+        return nullptr;
     }
 
-    return true;
+    return &_descriptorTable[INDEX];
 }
 
-/// Returns section address for specified section within block.
-/// param [in] blockIndex     Block index.
-/// param [in] sectionIndex   Section index.
-/// returns: Section address.
-uint32_t LessDb::sectionAddress(size_t blockIndex, size_t sectionIndex)
+/// Validates parameters passed to public functions, counting rejected requests.
+/// returns: Pointer to section descriptor if parameters are valid, nullptr otherwise.
+const LessDb::SectionDescriptor* LessDb::checkParameters(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+{
+    const SectionDescriptor* descriptor = parameterDescriptor(blockIndex, sectionIndex, parameterIndex);
+
+    if (descriptor == nullptr)
+    {
+        _stats.rejected();
+    }
+
+    return descriptor;
+}
+
+/// Attributes bytes written to the storage to the sections in which they are located,
+/// marks the pages in which they are located as changed since the last checkpoint and
+/// drops pending verification of earlier writes to them, since they're overwritten.
+/// param [in] address  Address of the first written byte.
+/// param [in] size     Number of written bytes.
+void LessDb::recordWrite(uint32_t address, size_t size)
+{
+    markCheckpointDirty(address, size);
+    dropPendingVerify(address, size);
+
+    if constexpr (StatsCollector::ENABLED)
+    {
+        const SectionDescriptor* first = _descriptorTable;
+        const SectionDescriptor* last  = _descriptorTable + numberOfSections();
+        const uint32_t           END   = address + size;
+
+        // sections are stored in ascending order of addresses
+        const SectionDescriptor* section = std::upper_bound(first, last, address, [](uint32_t value, const SectionDescriptor& descriptor)
+                                                            {
+                                                                return value < descriptor.address;
+                                                            });
+
+        if (section != first)
+        {
+            section--;
+        }
+
+        for (; (section != last) && (section->address < END); section++)
+        {
+            const uint32_t START = std::max(address, section->address);
+            const uint32_t STOP  = std::min(END, section->address + sectionSize(section->type, section->numberOfParameters));
+
+            if (STOP > START)
+            {
+                _stats.sectionWritten(section - first, STOP - START);
+            }
+        }
+    }
+}
+
+/// Returns the address of the byte in which specified parameter is stored.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index.
+uint32_t LessDb::parameterAddress(const SectionDescriptor& descriptor, size_t parameterIndex)
+{
+    return descriptor.address + ((parameterIndex >> descriptor.indexShift) << descriptor.widthShift);
+}
+
+/// Extracts the value of specified parameter from raw bytes in which it is stored.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] data             Pointer to the first byte in which parameter is stored.
+/// param [in] parameterIndex   Parameter index.
+uint32_t LessDb::unpackValue(const SectionDescriptor& descriptor, const uint8_t* data, size_t parameterIndex)
+{
+    uint32_t value = 0;
+
+    for (uint8_t byte = 0; byte < typeWidth(descriptor.type); byte++)
+    {
+        value |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+    }
+
+    return (value >> valueShift(descriptor, parameterIndex)) & descriptor.valueMask;
+}
+
+/// Stores the value of specified parameter into raw bytes, leaving other
+/// parameters stored in the same byte intact.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in, out] data        Pointer to the first byte in which parameter is stored.
+/// param [in] parameterIndex   Parameter index.
+/// param [in] value            Sanitized value to store.
+void LessDb::packValue(const SectionDescriptor& descriptor, uint8_t* data, size_t parameterIndex, uint32_t value)
+{
+    const uint8_t WIDTH = typeWidth(descriptor.type);
+
+    if (WIDTH == 1)
+    {
+        const uint8_t SHIFT = valueShift(descriptor, parameterIndex);
+
+        data[0] = (data[0] & ~(descriptor.valueMask << SHIFT)) | (value << SHIFT);
+        return;
+    }
+
+    for (uint8_t byte = 0; byte < WIDTH; byte++)
+    {
+        data[byte] = value >> (8 * byte);
+    }
+}
+
+/// Returns the position of bit or half-byte parameter within its byte.
+/// param [in] descriptor       Descriptor of the section in which parameter is located.
+/// param [in] parameterIndex   Parameter index.
+uint8_t LessDb::valueShift(const SectionDescriptor& descriptor, size_t parameterIndex)
 {
-    return LAYOUT_ACCESS[blockIndex]._address + LAYOUT_ACCESS[blockIndex]._sections[sectionIndex]._address;
-}
\ No newline at end of file
+    if (descriptor.type == sectionParameterType_t::BIT)
+    {
+        return parameterIndex & 0x07;
+    }
+
+    if (descriptor.type == sectionParameterType_t::HALF_BYTE)
+    {
+        return (parameterIndex & 0x01) << 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <string.h>
+#include <thread>
+#include "lib/lessdb/parallel_init.h"
+
+using namespace lib::lessdb;
+
+ParallelInit::ParallelInit(LessDb& db, size_t workers)
+    : _db(db)
+    , WORKERS(workers ? workers : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+{}
+
+/// Writes default values to all sections, as LessDb::initData does.
+/// param [in] type     Type of initialization (partial or full).
+///                     Partial initialization skips the sections which are
+///                     preserved on partial reset.
+/// returns: True on success, false otherwise.
+bool ParallelInit::initData(factoryResetType_t type)
+{
+    if (!parallel())
+    {
+        const auto START  = std::chrono::steady_clock::now();
+        const bool RESULT = _db.initData(type);
+
+        WorkerReport report;
+
+        for (size_t i = 0; i < _db.numberOfSections(); i++)
+        {
+            const SectionDescriptor& descriptor = _db._descriptorTable[i];
+
+            if ((descriptor.preserveOnPartialReset == preserveSetting_t::ENABLE) && (type == factoryResetType_t::PARTIAL))
+            {
+                continue;
+            }
+
+            report.bytes += LessDb::sectionSize(descriptor.type, descriptor.numberOfParameters);
+        }
+
+        report.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
+        _report.assign(1, report);
+
+        return RESULT;
+    }
+
+    auto timer = _db._stats.initData();
+
+    std::vector<Chunk> chunks;
+
+    _db.resetReadCache();
+
+    for (size_t i = 0; i < _db.numberOfSections(); i++)
+    {
+        const SectionDescriptor& descriptor = _db._descriptorTable[i];
+
+        if ((descriptor.preserveOnPartialReset == preserveSetting_t::ENABLE) && (type == factoryResetType_t::PARTIAL))
+        {
+            continue;
+        }
+
+        addChunks(chunks, descriptor);
+    }
+
+    if (!run(chunks))
+    {
+        return false;
+    }
+
+    return _db.completeInit();
+}
+
+/// Sets all parameters in specified section to the same value.
+/// param [in] blockIndex     Block index.
+/// param [in] sectionIndex   Section index.
+/// param [in] value          Value to which all parameters are set.
+/// returns: True on success, false otherwise.
+bool ParallelInit::fillSection(size_t blockIndex, size_t sectionIndex, uint32_t value)
+{
+    const SectionDescriptor* descriptor = _db.checkParameters(blockIndex, sectionIndex, 0);
+
+    if (descriptor == nullptr)
+    {
+        return false;
+    }
+
+    if (!parallel())
+    {
+        const auto START  = std::chrono::steady_clock::now();
+        const bool RESULT = _db.updateSection(blockIndex, sectionIndex, std::vector<uint32_t>(descriptor->numberOfParameters, value).data(), descriptor->numberOfParameters);
+
+        WorkerReport report;
+
+        report.bytes = LessDb::sectionSize(descriptor->type, descriptor->numberOfParameters);
+        report.ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
+        _report.assign(1, report);
+
+        return RESULT;
+    }
+
+    // section filled with a value is written just like section whose only default is that value
+    SectionDescriptor fill = *descriptor;
+
+    fill.defaultValue  = value & descriptor->valueMask;
+    fill.defaultValues = nullptr;
+    fill.autoIncrement = autoIncrementSetting_t::DISABLE;
+
+    std::vector<Chunk> chunks;
+
+    addChunks(chunks, fill);
+    _db.invalidateReadCache(fill.address, LessDb::sectionSize(fill.type, fill.numberOfParameters));
+
+    return run(chunks);
+}
+
+/// Returns the number of worker threads.
+size_t ParallelInit::workers() const
+{
+    return WORKERS;
+}
+
+/// Returns the amount of work done by each worker during the last operation.
+/// If the operation was done by the database itself, report holds single entry.
+const std::vector<ParallelInit::WorkerReport>& ParallelInit::report() const
+{
+    return _report;
+}
+
+/// Checks whether sections can be written from multiple threads.
+bool ParallelInit::parallel()
+{
+    return (WORKERS > 1) &&
+           _db._hwa.rangeAccessSupported() &&
+           _db._hwa.concurrentAccessSupported() &&
+           !_db.shadowActive() &&
+           !_db._combineSize &&
+           !_db._transactionActive &&
+           (_db._lazyResetSetting == lazyResetSetting_t::DISABLE);
+}
+
+/// Writes all chunks from worker threads and verifies them according to
+/// verification policy of the database. Statistics are updated once all
+/// workers are done, since the database collects them without locking.
+/// param [in, out] chunks  Chunks to write.
+/// returns: True if all chunks have been written and verified, false otherwise.
+bool ParallelInit::run(std::vector<Chunk>& chunks)
+{
+    const bool VERIFY = _db._verifyPolicy != verifyPolicy_t::NEVER;
+
+    std::atomic<size_t>      next   = 0;
+    std::atomic<bool>        failed = false;
+    std::vector<std::thread> threads;
+
+    _report.assign(std::min(WORKERS, std::max<size_t>(chunks.size(), 1)), {});
+
+    for (size_t worker = 0; worker < _report.size(); worker++)
+    {
+        threads.emplace_back([&, worker]()
+                             {
+                                 std::vector<uint8_t> buffer(CHUNK_SIZE);
+                                 std::vector<uint8_t> readBuffer(VERIFY ? CHUNK_SIZE : 0);
+                                 WorkerReport&        report = _report[worker];
+
+                                 const auto START = std::chrono::steady_clock::now();
+
+                                 for (size_t index = next++; (index < chunks.size()) && !failed; index = next++)
+                                 {
+                                     Chunk&         chunk   = chunks[index];
+                                     const uint32_t ADDRESS = chunk.descriptor->address + chunk.offset;
+
+                                     for (size_t i = 0; i < chunk.size; i++)
+                                     {
+                                         buffer[i] = LessDb::defaultByte(*chunk.descriptor, chunk.offset + i);
+                                     }
+
+                                     chunk.written = _db._hwa.writeRange(ADDRESS, buffer.data(), chunk.size);
+
+                                     if (chunk.written && VERIFY)
+                                     {
+                                         chunk.verified = _db._hwa.readRange(ADDRESS, readBuffer.data(), chunk.size);
+                                         chunk.match    = chunk.verified && (memcmp(buffer.data(), readBuffer.data(), chunk.size) == 0);
+                                     }
+
+                                     if (!chunk.written || (VERIFY && !chunk.match))
+                                     {
+                                         failed = true;
+                                         break;
+                                     }
+
+                                     report.bytes += chunk.size;
+                                     report.chunks++;
+                                 }
+
+                                 report.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
+                             });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const auto& chunk : chunks)
+    {
+        if (!chunk.written)
+        {
+            continue;
+        }
+
+        _db._stats.hwaRangeWrite();
+        _db.recordWrite(chunk.descriptor->address + chunk.offset, chunk.size);
+
+        if (chunk.verified)
+        {
+            _db._stats.hwaRangeRead();
+            _db._stats.verifyRead(chunk.match);
+        }
+    }
+
+    return !failed;
+}
+
+/// Splits specified section into chunks of at most CHUNK_SIZE bytes.
+/// param [in, out] chunks      List to which chunks are appended.
+/// param [in] descriptor       Descriptor of the section.
+void ParallelInit::addChunks(std::vector<Chunk>& chunks, const SectionDescriptor& descriptor)
+{
+    const uint32_t SIZE = LessDb::sectionSize(descriptor.type, descriptor.numberOfParameters);
+
+    for (uint32_t offset = 0; offset < SIZE; offset += CHUNK_SIZE)
+    {
+        chunks.push_back({ &descriptor, offset, static_cast<uint32_t>(std::min<size_t>(SIZE - offset, CHUNK_SIZE)), false, false, false });
+    }
+}
@@ -0,0 +1,363 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <string.h>
+#include "lib/lessdb/snapshot.h"
+
+using namespace lib::lessdb;
+
+SnapshotLessDb::~SnapshotLessDb()
+{
+    stop();
+    flush();
+}
+
+/// Loads current database contents into RAM images and starts background flushing.
+/// Must be called once the layout of the database is set.
+/// returns: True on success, false otherwise.
+bool SnapshotLessDb::init()
+{
+    stop();
+
+    // changes made with previous layout are written to their original addresses
+    flush();
+
+    std::lock_guard<std::mutex> flushLock(_flushMutex);
+    std::lock_guard<std::mutex> writeLock(_writeMutex);
+
+    const uint32_t SIZE = _db.currentDatabaseSize();
+
+    _numberOfBlocks = 0;
+    _initialAddress = _db._initialAddress;
+    _image[0].assign(SIZE, 0);
+
+    if (SIZE && !_db.readBytes(_initialAddress, _image[0].data(), SIZE))
+    {
+        return false;
+    }
+
+    _image[1] = _image[0];
+    _dirty.assign(SIZE, false);
+    _flushImage.assign(SIZE, 0);
+    _flushDirty.assign(SIZE, false);
+    _dirtyBytes = 0;
+    _dirtyStart = SIZE;
+    _dirtyEnd   = 0;
+    _blocks     = std::vector<BlockState>(_db._numberOfBlocks);
+
+    for (size_t block = 0; block < _db._numberOfBlocks; block++)
+    {
+        const size_t FIRST = _db._blockTable[block];
+        const size_t LAST  = _db._blockTable[block + 1];
+
+        if (FIRST == LAST)
+        {
+            continue;
+        }
+
+        const auto& lastSection = _db._descriptorTable[LAST - 1];
+
+        _blocks[block].start = _db._descriptorTable[FIRST].address - _initialAddress;
+        _blocks[block].size  = lastSection.address + LessDb::sectionSize(lastSection.type, lastSection.numberOfParameters) - _initialAddress - _blocks[block].start;
+    }
+
+    _numberOfBlocks = _db._numberOfBlocks;
+    _stopThread     = false;
+    _flushThread    = std::thread(&SnapshotLessDb::flushLoop, this);
+
+    return true;
+}
+
+/// Reads a value from RAM image. Never blocks.
+/// param [in] blockIndex         Block index.
+/// param [in] sectionIndex       Section index.
+/// param [in] parameterIndex     Parameter index.
+/// param [in, out] value         Reference to variable in which read value will be stored.
+/// returns: True on success, false otherwise.
+bool SnapshotLessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t& value)
+{
+    bool result = false;
+
+    readBlock(blockIndex, [&](const BlockView& view)
+              {
+                  result = view.read(sectionIndex, parameterIndex, value);
+              });
+
+    return result;
+}
+
+/// Reads a value from RAM image with reduced error checking. Never blocks.
+/// returns: Value from database. In case of read failure, 0 will be returned.
+uint32_t SnapshotLessDb::read(size_t blockIndex, size_t sectionIndex, size_t parameterIndex)
+{
+    uint32_t value = 0;
+    read(blockIndex, sectionIndex, parameterIndex, value);
+    return value;
+}
+
+/// Updates value in RAM image. Change is written to the database later.
+/// param [in] blockIndex         Block index.
+/// param [in] sectionIndex       Section index.
+/// param [in] parameterIndex     Parameter index.
+/// param [in] newValue           New value for parameter.
+/// returns: True on success, false otherwise.
+bool SnapshotLessDb::update(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint32_t newValue)
+{
+    return updateBlock(blockIndex, [&](BlockWriter& writer)
+                       {
+                           writer.update(sectionIndex, parameterIndex, newValue);
+                       });
+}
+
+/// Writes all changes made in RAM image to the database.
+/// returns: True on success, false otherwise.
+bool SnapshotLessDb::flush()
+{
+    std::lock_guard<std::mutex> flushLock(_flushMutex);
+
+    uint32_t start;
+    uint32_t end;
+
+    {
+        std::lock_guard<std::mutex> writeLock(_writeMutex);
+
+        if (!_dirtyBytes)
+        {
+            return true;
+        }
+
+        start = _dirtyStart;
+        end   = _dirtyEnd;
+
+        // both images are identical while writer isn't active
+        for (uint32_t offset = start; offset < end; offset++)
+        {
+            if (_dirty[offset])
+            {
+                _flushImage[offset] = _image[0][offset];
+                _flushDirty[offset] = true;
+                _dirty[offset]      = false;
+            }
+        }
+
+        _dirtyBytes = 0;
+        _dirtyStart = _dirty.size();
+        _dirtyEnd   = 0;
+    }
+
+    bool     result = true;
+    uint32_t offset = start;
+
+    while (offset < end)
+    {
+        if (!_flushDirty[offset])
+        {
+            offset++;
+            continue;
+        }
+
+        uint32_t runEnd = offset;
+
+        while ((runEnd < end) && _flushDirty[runEnd])
+        {
+            _flushDirty[runEnd++] = false;
+        }
+
+        if (!_db.writeRange(_initialAddress + offset, &_flushImage[offset], runEnd - offset))
+        {
+            // retry on next flush
+            std::lock_guard<std::mutex> writeLock(_writeMutex);
+            markDirty(offset, runEnd - offset);
+            result = false;
+        }
+
+        offset = runEnd;
+    }
+
+    return result && _db.flush();
+}
+
+/// Returns the number of bytes changed in RAM image but not yet written to the database.
+uint32_t SnapshotLessDb::pendingBytes()
+{
+    std::lock_guard<std::mutex> writeLock(_writeMutex);
+    return _dirtyBytes;
+}
+
+bool SnapshotLessDb::BlockView::read(size_t sectionIndex, size_t parameterIndex, uint32_t& value) const
+{
+    return _snapshot.readParameter(BLOCK_INDEX, sectionIndex, parameterIndex, _image, value);
+}
+
+uint32_t SnapshotLessDb::BlockView::read(size_t sectionIndex, size_t parameterIndex) const
+{
+    uint32_t value = 0;
+    read(sectionIndex, parameterIndex, value);
+    return value;
+}
+
+bool SnapshotLessDb::BlockWriter::update(size_t sectionIndex, size_t parameterIndex, uint32_t newValue)
+{
+    if (!_snapshot.writeParameter(BLOCK_INDEX, sectionIndex, parameterIndex, _image, newValue))
+    {
+        _result = false;
+        return false;
+    }
+
+    return true;
+}
+
+/// Registers reader of specified block.
+/// param [in] blockIndex   Block index.
+/// param [out] image       Image which reader can safely use until it leaves.
+/// returns: Version which must be passed to depart once reader is done.
+uint8_t SnapshotLessDb::arrive(size_t blockIndex, const uint8_t*& image)
+{
+    BlockState&   state   = _blocks[blockIndex];
+    const uint8_t VERSION = state.versionIndex.load();
+
+    state.readers[VERSION].fetch_add(1);
+    image = _image[state.leftRight.load()].data();
+
+    return VERSION;
+}
+
+void SnapshotLessDb::depart(size_t blockIndex, uint8_t version)
+{
+    _blocks[blockIndex].readers[version].fetch_sub(1);
+}
+
+/// Returns the image of specified block which no reader is using.
+uint8_t* SnapshotLessDb::inactiveImage(size_t blockIndex)
+{
+    return _image[_blocks[blockIndex].leftRight.load() ^ 1].data();
+}
+
+/// Makes updated image of specified block visible to readers and copies
+/// the changes into the other image once all readers have left it.
+void SnapshotLessDb::publish(size_t blockIndex)
+{
+    BlockState&   state = _blocks[blockIndex];
+    const uint8_t SIDE  = state.leftRight.load();
+
+    state.leftRight.store(SIDE ^ 1);
+
+    // readers which arrived before the switch may still use the previous image
+    const uint8_t VERSION = state.versionIndex.load();
+
+    while (state.readers[VERSION ^ 1].load())
+    {
+        std::this_thread::yield();
+    }
+
+    state.versionIndex.store(VERSION ^ 1);
+
+    while (state.readers[VERSION].load())
+    {
+        std::this_thread::yield();
+    }
+
+    memcpy(&_image[SIDE][state.start], &_image[SIDE ^ 1][state.start], state.size);
+}
+
+bool SnapshotLessDb::readParameter(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, const uint8_t* image, uint32_t& value) const
+{
+    const LessDb::SectionDescriptor* descriptor = _db.parameterDescriptor(blockIndex, sectionIndex, parameterIndex);
+
+    if (descriptor == nullptr)
+    {
+        return false;
+    }
+
+    value = LessDb::unpackValue(*descriptor, &image[LessDb::parameterAddress(*descriptor, parameterIndex) - _initialAddress], parameterIndex);
+    return true;
+}
+
+bool SnapshotLessDb::writeParameter(size_t blockIndex, size_t sectionIndex, size_t parameterIndex, uint8_t* image, uint32_t newValue)
+{
+    const LessDb::SectionDescriptor* descriptor = _db.parameterDescriptor(blockIndex, sectionIndex, parameterIndex);
+
+    if (descriptor == nullptr)
+    {
+        return false;
+    }
+
+    const uint32_t OFFSET = LessDb::parameterAddress(*descriptor, parameterIndex) - _initialAddress;
+
+    newValue &= descriptor->valueMask;
+
+    if (LessDb::unpackValue(*descriptor, &image[OFFSET], parameterIndex) == newValue)
+    {
+        return true;
+    }
+
+    LessDb::packValue(*descriptor, &image[OFFSET], parameterIndex, newValue);
+    markDirty(OFFSET, LessDb::typeWidth(descriptor->type));
+
+    return true;
+}
+
+void SnapshotLessDb::markDirty(uint32_t offset, size_t size)
+{
+    for (size_t i = offset; i < (offset + size); i++)
+    {
+        if (!_dirty[i])
+        {
+            _dirty[i] = true;
+            _dirtyBytes++;
+        }
+    }
+
+    _dirtyStart = std::min<uint32_t>(_dirtyStart, offset);
+    _dirtyEnd   = std::max<uint32_t>(_dirtyEnd, offset + size);
+}
+
+/// Periodically writes changes to the database while running.
+void SnapshotLessDb::flushLoop()
+{
+    std::unique_lock<std::mutex> lock(_threadMutex);
+
+    while (!_stopThread)
+    {
+        _threadCondition.wait_for(lock, std::chrono::milliseconds(FLUSH_PERIOD_MS));
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+/// Stops background flushing.
+void SnapshotLessDb::stop()
+{
+    if (_flushThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_threadMutex);
+            _stopThread = true;
+        }
+
+        _threadCondition.notify_all();
+        _flushThread.join();
+    }
+}
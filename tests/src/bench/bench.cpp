@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <random>
+#include <string.h>
+#include <benchmark/benchmark.h>
+#include "lib/lessdb/lessdb.h"
+
+using namespace lib::lessdb;
+
+namespace
+{
+    constexpr uint32_t STORAGE_SIZE = 65536;
+
+    enum class accessPattern_t : uint8_t
+    {
+        SEQUENTIAL,    ///< Parameters are accessed one after another.
+        RANDOM,        ///< Parameters are accessed in random order.
+        REPEATED,      ///< Same parameter is accessed every time.
+    };
+
+    /// Storage kept entirely in RAM.
+    class HwaRam : public Hwa
+    {
+        public:
+        bool init() override
+        {
+            return true;
+        }
+
+        uint32_t size() override
+        {
+            return STORAGE_SIZE;
+        }
+
+        bool clear() override
+        {
+            memset(_memory, 0, STORAGE_SIZE);
+            return true;
+        }
+
+        bool read(uint32_t address, uint32_t& value, sectionParameterType_t type) override
+        {
+            value = 0;
+
+            for (size_t i = 0; i < width(type); i++)
+            {
+                value |= static_cast<uint32_t>(_memory[address + i]) << (8 * i);
+            }
+
+            return true;
+        }
+
+        bool write(uint32_t address, uint32_t value, sectionParameterType_t type) override
+        {
+            for (size_t i = 0; i < width(type); i++)
+            {
+                _memory[address + i] = value >> (8 * i);
+            }
+
+            return true;
+        }
+
+        bool rangeAccessSupported() override
+        {
+            return true;
+        }
+
+        bool readRange(uint32_t address, uint8_t* buffer, size_t size) override
+        {
+            memcpy(buffer, &_memory[address], size);
+            return true;
+        }
+
+        bool writeRange(uint32_t address, const uint8_t* buffer, size_t size) override
+        {
+            memcpy(&_memory[address], buffer, size);
+            return true;
+        }
+
+        private:
+        uint8_t _memory[STORAGE_SIZE] = {};
+
+        static size_t width(sectionParameterType_t type)
+        {
+            switch (type)
+            {
+            case sectionParameterType_t::WORD:
+                return 2;
+
+            case sectionParameterType_t::DWORD:
+                return 4;
+
+            default:
+                return 1;
+            }
+        }
+    };
+
+    /// Forwards all accesses to RAM storage and counts the transactions
+    /// which would be made with the actual backend.
+    class HwaCounting : public Hwa
+    {
+        public:
+        bool init() override
+        {
+            return _storage.init();
+        }
+
+        uint32_t size() override
+        {
+            return _storage.size();
+        }
+
+        bool clear() override
+        {
+            _transactions++;
+            return _storage.clear();
+        }
+
+        bool read(uint32_t address, uint32_t& value, sectionParameterType_t type) override
+        {
+            _transactions++;
+            return _storage.read(address, value, type);
+        }
+
+        bool write(uint32_t address, uint32_t value, sectionParameterType_t type) override
+        {
+            _transactions++;
+            return _storage.write(address, value, type);
+        }
+
+        bool rangeAccessSupported() override
+        {
+            return _rangeAccess;
+        }
+
+        bool readRange(uint32_t address, uint8_t* buffer, size_t size) override
+        {
+            if (!_rangeAccess)
+            {
+                return Hwa::readRange(address, buffer, size);
+            }
+
+            _transactions++;
+            return _storage.readRange(address, buffer, size);
+        }
+
+        bool writeRange(uint32_t address, const uint8_t* buffer, size_t size) override
+        {
+            if (!_rangeAccess)
+            {
+                return Hwa::writeRange(address, buffer, size);
+            }
+
+            _transactions++;
+            return _storage.writeRange(address, buffer, size);
+        }
+
+        HwaRam   _storage;
+        bool     _rangeAccess  = false;
+        uint64_t _transactions = 0;
+    };
+
+    /// Database with single block holding single section of specified type.
+    class BenchDb
+    {
+        public:
+        BenchDb(sectionParameterType_t type, size_t numberOfParameters)
+            : _sections{
+                { numberOfParameters,
+                  type,
+                  preserveSetting_t::DISABLE,
+                  autoIncrementSetting_t::DISABLE,
+                  0 },
+            }
+            , _layout{ Block(_sections) }
+        {
+            _db.init();
+            _db.setLayout(_layout);
+            _db.initData();
+        }
+
+        HwaCounting          _hwa;
+        LessDb               _db = LessDb(_hwa);
+        std::vector<Section> _sections;
+        std::vector<Block>   _layout;
+    };
+
+    uint32_t valueMask(sectionParameterType_t type)
+    {
+        switch (type)
+        {
+        case sectionParameterType_t::BIT:
+            return 0x01;
+
+        case sectionParameterType_t::HALF_BYTE:
+            return 0x0F;
+
+        case sectionParameterType_t::BYTE:
+            return 0xFF;
+
+        case sectionParameterType_t::WORD:
+            return 0xFFFF;
+
+        default:
+            return 0xFFFFFFFF;
+        }
+    }
+
+    /// Returns parameter indexes in the order in which they are accessed.
+    std::vector<size_t> accessOrder(accessPattern_t pattern, size_t numberOfParameters)
+    {
+        std::vector<size_t> order(numberOfParameters, 0);
+
+        if (pattern == accessPattern_t::REPEATED)
+        {
+            return order;
+        }
+
+        for (size_t i = 0; i < numberOfParameters; i++)
+        {
+            order[i] = i;
+        }
+
+        if (pattern == accessPattern_t::RANDOM)
+        {
+            std::shuffle(order.begin(), order.end(), std::mt19937(numberOfParameters));
+        }
+
+        return order;
+    }
+
+    void reportTransactions(benchmark::State& state, const HwaCounting& hwa)
+    {
+        state.counters["transactions/op"] = benchmark::Counter(hwa._transactions, benchmark::Counter::kAvgIterations);
+    }
+
+    template<sectionParameterType_t Type, accessPattern_t Pattern>
+    void benchRead(benchmark::State& state)
+    {
+        BenchDb  bench(Type, state.range(0));
+        auto     order = accessOrder(Pattern, state.range(0));
+        size_t   index = 0;
+        uint32_t value = 0;
+
+        bench._hwa._transactions = 0;
+
+        for (auto _ : state)
+        {
+            bench._db.read(0, 0, order[index], value);
+            benchmark::DoNotOptimize(value);
+
+            if (++index == order.size())
+            {
+                index = 0;
+            }
+        }
+
+        reportTransactions(state, bench._hwa);
+    }
+
+    template<sectionParameterType_t Type, accessPattern_t Pattern>
+    void benchUpdate(benchmark::State& state)
+    {
+        BenchDb  bench(Type, state.range(0));
+        auto     order = accessOrder(Pattern, state.range(0));
+        size_t   index = 0;
+        uint32_t value = 1;
+
+        bench._hwa._transactions = 0;
+
+        // value changes on every pass so that writes aren't skipped
+        for (auto _ : state)
+        {
+            bench._db.update(0, 0, order[index], value & valueMask(Type));
+
+            if ((++index == order.size()) || (Pattern == accessPattern_t::REPEATED))
+            {
+                index = 0;
+                value++;
+            }
+        }
+
+        reportTransactions(state, bench._hwa);
+    }
+
+    /// Repeated reads of parameters packed into the same byte, with and without read cache.
+    template<sectionParameterType_t Type>
+    void benchReadCache(benchmark::State& state)
+    {
+        BenchDb  bench(Type, 64);
+        size_t   index = 0;
+        uint32_t value = 0;
+
+        bench._db.setReadCacheSize(state.range(0));
+        bench._hwa._transactions = 0;
+
+        for (auto _ : state)
+        {
+            bench._db.read(0, 0, index, value);
+            benchmark::DoNotOptimize(value);
+            index = (index + 1) & 0x07;
+        }
+
+        reportTransactions(state, bench._hwa);
+    }
+
+    template<sectionParameterType_t Type>
+    void benchBulkRead(benchmark::State& state)
+    {
+        BenchDb               bench(Type, state.range(0));
+        std::vector<uint32_t> values(state.range(0));
+
+        bench._hwa._rangeAccess  = state.range(1);
+        bench._hwa._transactions = 0;
+
+        for (auto _ : state)
+        {
+            bench._db.readSection(0, 0, values.data(), values.size());
+            benchmark::DoNotOptimize(values.data());
+        }
+
+        reportTransactions(state, bench._hwa);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template<sectionParameterType_t Type>
+    void benchInitData(benchmark::State& state)
+    {
+        BenchDb bench(Type, state.range(0));
+
+        bench._hwa._rangeAccess  = state.range(1);
+        bench._hwa._transactions = 0;
+
+        for (auto _ : state)
+        {
+            bench._db.initData();
+        }
+
+        reportTransactions(state, bench._hwa);
+    }
+
+    void benchSetLayout(benchmark::State& state)
+    {
+        std::vector<Section> sections;
+        HwaCounting          hwa;
+        LessDb               db(hwa);
+
+        for (int64_t i = 0; i < state.range(0); i++)
+        {
+            sections.push_back({ 16,
+                                 static_cast<sectionParameterType_t>(i % 5),
+                                 preserveSetting_t::DISABLE,
+                                 autoIncrementSetting_t::DISABLE,
+                                 0 });
+        }
+
+        std::vector<Block> layout = { Block(sections) };
+
+        db.init();
+        hwa._transactions = 0;
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(db.setLayout(layout));
+        }
+
+        reportTransactions(state, hwa);
+    }
+
+#define LESSDB_BENCH_ACCESS(function, type)                                                                                     \
+    BENCHMARK_TEMPLATE(function, sectionParameterType_t::type, accessPattern_t::SEQUENTIAL)->RangeMultiplier(16)->Range(16, 4096); \
+    BENCHMARK_TEMPLATE(function, sectionParameterType_t::type, accessPattern_t::RANDOM)->RangeMultiplier(16)->Range(16, 4096);     \
+    BENCHMARK_TEMPLATE(function, sectionParameterType_t::type, accessPattern_t::REPEATED)->RangeMultiplier(16)->Range(16, 4096);
+
+#define LESSDB_BENCH_TYPE(type)                                                                         \
+    LESSDB_BENCH_ACCESS(benchRead, type)                                                                \
+    LESSDB_BENCH_ACCESS(benchUpdate, type)                                                              \
+    BENCHMARK_TEMPLATE(benchBulkRead, sectionParameterType_t::type)->ArgsProduct({ { 16, 256, 4096 }, { 0, 1 } }); \
+    BENCHMARK_TEMPLATE(benchInitData, sectionParameterType_t::type)->ArgsProduct({ { 16, 256, 4096 }, { 0, 1 } });
+
+    LESSDB_BENCH_TYPE(BIT)
+    LESSDB_BENCH_TYPE(HALF_BYTE)
+    LESSDB_BENCH_TYPE(BYTE)
+    LESSDB_BENCH_TYPE(WORD)
+    LESSDB_BENCH_TYPE(DWORD)
+
+    BENCHMARK_TEMPLATE(benchReadCache, sectionParameterType_t::BIT)->Arg(0)->Arg(8);
+    BENCHMARK_TEMPLATE(benchReadCache, sectionParameterType_t::HALF_BYTE)->Arg(0)->Arg(8);
+    BENCHMARK(benchSetLayout)->RangeMultiplier(8)->Range(1, 512);
+}    // namespace
+
+BENCHMARK_MAIN();
@@ -1,5 +1,20 @@
+#include <thread>
 #include "tests/common.h"
 #include "lib/lessdb/lessdb.h"
+#include "lib/lessdb/static_layout.h"
+#include "lib/lessdb/hwa_flash.h"
+#include "lib/lessdb/hwa_trace.h"
+#include "lib/lessdb/coroutine.h"
+
+#ifdef __unix__
+#include <filesystem>
+#include <unistd.h>
+#include "lib/lessdb/hwa_mmap.h"
+#include "lib/lessdb/concurrent.h"
+#include "lib/lessdb/snapshot.h"
+#include "lib/lessdb/parallel_init.h"
+#include "lib/lessdb/async.h"
+#endif
 
 using namespace lib::lessdb;
 
@@ -55,14 +70,58 @@ namespace
 
             bool read(uint32_t address, uint32_t& value, sectionParameterType_t type) override
             {
+                _readCount++;
                 return _readCallback(address, value, type);
             }
 
             bool write(uint32_t address, uint32_t value, sectionParameterType_t type) override
             {
+                _writeCount++;
                 return _writeCallback(address, value, type);
             }
 
+            bool rangeAccessSupported() override
+            {
+                return _rangeAccess;
+            }
+
+            bool readRange(uint32_t address, uint8_t* buffer, size_t size) override
+            {
+                if (!_rangeAccess)
+                {
+                    return Hwa::readRange(address, buffer, size);
+                }
+
+                _readRangeCount++;
+                memcpy(buffer, &_memoryArray[address], size);
+                return true;
+            }
+
+            bool writeRange(uint32_t address, const uint8_t* buffer, size_t size) override
+            {
+                if (!_rangeAccess)
+                {
+                    return Hwa::writeRange(address, buffer, size);
+                }
+
+                _writeRangeCount++;
+                memcpy(&_memoryArray[address], buffer, size);
+                return true;
+            }
+
+            uint32_t milliseconds() override
+            {
+                return _milliseconds;
+            }
+
+            void resetCounters()
+            {
+                _readCount       = 0;
+                _writeCount      = 0;
+                _readRangeCount  = 0;
+                _writeRangeCount = 0;
+            }
+
             bool memoryReadFail(uint32_t address, uint32_t& value, sectionParameterType_t type)
             {
                 return false;
@@ -144,6 +203,12 @@ namespace
 
             std::function<bool(uint32_t address, uint32_t& value, sectionParameterType_t type)> _readCallback;
             std::function<bool(uint32_t address, uint32_t value, sectionParameterType_t type)>  _writeCallback;
+            bool                                                                                _rangeAccess     = false;
+            size_t                                                                              _readCount       = 0;
+            size_t                                                                              _writeCount      = 0;
+            size_t                                                                              _readRangeCount  = 0;
+            size_t                                                                              _writeRangeCount = 0;
+            uint32_t                                                                            _milliseconds    = 0;
 
             private:
             uint8_t _memoryArray[DatabaseTest::LESSDB_SIZE];
@@ -1093,4 +1158,2652 @@ TEST_F(DatabaseTest, CachingBit)
 
     ASSERT_TRUE(db3.read(0, 1, TEST_CACHING_BIT_AMOUNT_OF_PARAMS - 1, readValue));
     ASSERT_EQ(TEST_CACHING_BIT_SECTION_1_DEFAULT_VALUE, readValue);
-}
\ No newline at end of file
+}
+
+TEST_F(DatabaseTest, RangeAccess)
+{
+    _hwa.clear();
+    _hwa._rangeAccess = true;
+    _hwa.resetCounters();
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    // each section fits into a single range transaction
+    size_t totalSections = 0;
+
+    for (size_t block = 0; block < DB_LAYOUT.size(); block++)
+    {
+        totalSections += SECTION_PARAMS.size();
+    }
+
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(totalSections, _hwa._writeRangeCount);
+    ASSERT_EQ(totalSections, _hwa._readRangeCount);
+
+    uint32_t value;
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+        {
+            ASSERT_TRUE(_lessdb.read(TEST_BLOCK_INDEX, section, i, value));
+
+            // autoincrement is enabled for section 1
+            ASSERT_EQ(DEFAULT_VALUES[section] + (section == 1 ? i : 0), value);
+        }
+    }
+}
+
+TEST_F(DatabaseTest, BulkRead)
+{
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    // change some values so that the sections don't hold only defaults
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i += 3)
+        {
+            ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, section, i, i & 0x01));
+        }
+    }
+
+    auto verifySections = [&]()
+    {
+        for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+        {
+            std::vector<uint32_t> values(SECTION_PARAMS[section]);
+
+            ASSERT_TRUE(_lessdb.readSection(TEST_BLOCK_INDEX, section, values.data(), values.size()));
+
+            for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+            {
+                ASSERT_EQ(_lessdb.read(TEST_BLOCK_INDEX, section, i), values[i]);
+            }
+
+            // ranges starting in the middle of a byte
+            for (size_t first = 0; first < SECTION_PARAMS[section]; first++)
+            {
+                const size_t COUNT = SECTION_PARAMS[section] - first;
+
+                ASSERT_TRUE(_lessdb.readRange(TEST_BLOCK_INDEX, section, first, COUNT, values.data()));
+
+                for (size_t i = 0; i < COUNT; i++)
+                {
+                    ASSERT_EQ(_lessdb.read(TEST_BLOCK_INDEX, section, first + i), values[i]);
+                }
+            }
+        }
+    };
+
+    verifySections();
+
+    _hwa._rangeAccess = true;
+    verifySections();
+
+    // each section is read in a single transaction
+    _hwa.resetCounters();
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        std::vector<uint32_t> values(SECTION_PARAMS[section]);
+        ASSERT_TRUE(_lessdb.readSection(TEST_BLOCK_INDEX, section, values.data(), values.size()));
+    }
+
+    ASSERT_EQ(0, _hwa._readCount);
+    ASSERT_EQ(SECTION_PARAMS.size(), _hwa._readRangeCount);
+
+    _hwa._rangeAccess = false;
+
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    verifySections();
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::DISABLE));
+
+    // invalid arguments
+    uint32_t values[16] = {};
+
+    ASSERT_FALSE(_lessdb.readSection(TEST_BLOCK_INDEX, 0, values, SECTION_PARAMS[0] - 1));
+    ASSERT_FALSE(_lessdb.readSection(DB_LAYOUT.size(), 0, values, 16));
+    ASSERT_FALSE(_lessdb.readRange(TEST_BLOCK_INDEX, 0, 1, SECTION_PARAMS[0], values));
+    ASSERT_FALSE(_lessdb.readRange(TEST_BLOCK_INDEX, SECTION_PARAMS.size(), 0, 1, values));
+    ASSERT_TRUE(_lessdb.readRange(TEST_BLOCK_INDEX, 0, 0, 0, values));
+}
+
+TEST_F(DatabaseTest, BulkUpdate)
+{
+    const std::vector<uint32_t> MAX_VALUE = {
+        0x01,
+        0xFF,
+        0x0F,
+        0xFFFF,
+        0xFFFFFFFF,
+        0xFF,
+    };
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    auto updateAndVerify = [&](uint32_t seed)
+    {
+        for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+        {
+            std::vector<uint32_t> values(SECTION_PARAMS[section]);
+
+            // ranges starting and ending in the middle of a byte
+            for (size_t first = 0; first < SECTION_PARAMS[section]; first++)
+            {
+                const size_t COUNT = SECTION_PARAMS[section] - first - (first % 2);
+
+                std::vector<uint32_t> expected(SECTION_PARAMS[section]);
+
+                for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+                {
+                    expected[i] = _lessdb.read(TEST_BLOCK_INDEX, section, i);
+                }
+
+                for (size_t i = 0; i < COUNT; i++)
+                {
+                    values[i] = seed + first + i * 7;
+                    expected[first + i] = values[i] & MAX_VALUE[section];
+                }
+
+                ASSERT_TRUE(_lessdb.updateRange(TEST_BLOCK_INDEX, section, first, COUNT, values.data()));
+
+                for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+                {
+                    ASSERT_EQ(expected[i], _lessdb.read(TEST_BLOCK_INDEX, section, i));
+                }
+            }
+
+            for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+            {
+                values[i] = seed * i;
+            }
+
+            ASSERT_TRUE(_lessdb.updateSection(TEST_BLOCK_INDEX, section, values.data(), values.size()));
+
+            for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+            {
+                ASSERT_EQ(values[i] & MAX_VALUE[section], _lessdb.read(TEST_BLOCK_INDEX, section, i));
+            }
+        }
+
+        // other blocks must stay intact
+        ASSERT_EQ(DEFAULT_VALUES[1], _lessdb.read(TEST_BLOCK_INDEX + 1, 0, 0));
+    };
+
+    updateAndVerify(1);
+
+    _lessdb.setCompareBeforeWrite(compareBeforeWriteSetting_t::DISABLE);
+    updateAndVerify(3);
+
+    _hwa._rangeAccess = true;
+    updateAndVerify(5);
+
+    _lessdb.setCompareBeforeWrite(compareBeforeWriteSetting_t::ENABLE);
+    updateAndVerify(7);
+
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::DEFERRED));
+    updateAndVerify(9);
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::ALWAYS));
+
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    updateAndVerify(11);
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::DISABLE));
+
+    // whole bit section is written with a single transaction
+    std::vector<uint32_t> bits(SECTION_PARAMS[0], 0);
+
+    for (size_t i = 0; i < bits.size(); i++)
+    {
+        bits[i] = !_lessdb.read(TEST_BLOCK_INDEX, 0, i);
+    }
+
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.updateSection(TEST_BLOCK_INDEX, 0, bits.data(), bits.size()));
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(1, _hwa._writeRangeCount);
+
+    // unchanged values aren't written at all
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.updateSection(TEST_BLOCK_INDEX, 0, bits.data(), bits.size()));
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._writeRangeCount);
+
+    _hwa._rangeAccess = false;
+
+    // invalid arguments
+    uint32_t values[16] = {};
+
+    ASSERT_FALSE(_lessdb.updateSection(TEST_BLOCK_INDEX, 0, values, SECTION_PARAMS[0] - 1));
+    ASSERT_FALSE(_lessdb.updateRange(TEST_BLOCK_INDEX, 0, 1, SECTION_PARAMS[0], values));
+    ASSERT_FALSE(_lessdb.updateRange(DB_LAYOUT.size(), 0, 0, 1, values));
+}
+
+TEST_F(DatabaseTest, ReadCache)
+{
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_EQ(0, _lessdb.readCacheHits());
+    ASSERT_EQ(0, _lessdb.readCacheMisses());
+
+    // parameters from different sections and of different types
+    // alternate without evicting each other
+    auto readAll = [&]()
+    {
+        ASSERT_EQ(DEFAULT_VALUES[0], _lessdb.read(TEST_BLOCK_INDEX, 0, 0));
+        ASSERT_EQ(DEFAULT_VALUES[2], _lessdb.read(TEST_BLOCK_INDEX, 2, 0));
+        ASSERT_EQ(DEFAULT_VALUES[3], _lessdb.read(TEST_BLOCK_INDEX, 3, 1));
+        ASSERT_EQ(DEFAULT_VALUES[4], _lessdb.read(TEST_BLOCK_INDEX, 4, 3));
+    };
+
+    _hwa.resetCounters();
+
+    for (int i = 0; i < 10; i++)
+    {
+        readAll();
+    }
+
+    ASSERT_EQ(4, _hwa._readCount);
+    ASSERT_EQ(4, _lessdb.readCacheMisses());
+    ASSERT_EQ(36, _lessdb.readCacheHits());
+
+    // writing invalidates only the written value
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 1, 1234));
+    ASSERT_EQ(1234, _lessdb.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 1, DEFAULT_VALUES[3]));
+
+    const uint32_t MISSES = _lessdb.readCacheMisses();
+    readAll();
+    ASSERT_EQ(MISSES + 1, _lessdb.readCacheMisses());
+
+    // bit sharing the byte with cached one
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, 1, 0));
+    ASSERT_EQ(0, _lessdb.read(TEST_BLOCK_INDEX, 0, 1));
+    ASSERT_EQ(DEFAULT_VALUES[0], _lessdb.read(TEST_BLOCK_INDEX, 0, 0));
+
+    // bulk updates invalidate cache as well
+    const uint32_t BITS[5] = { 0, 0, 0, 0, 0 };
+    ASSERT_TRUE(_lessdb.updateSection(TEST_BLOCK_INDEX, 0, BITS, 5));
+    ASSERT_EQ(0, _lessdb.read(TEST_BLOCK_INDEX, 0, 0));
+
+    // clear and initData invalidate the cache, but keep the counters
+    const uint32_t HITS         = _lessdb.readCacheHits();
+    const uint32_t CLEAR_MISSES = _lessdb.readCacheMisses();
+
+    ASSERT_TRUE(_lessdb.clear());
+    ASSERT_EQ(HITS, _lessdb.readCacheHits());
+    ASSERT_EQ(CLEAR_MISSES, _lessdb.readCacheMisses());
+    ASSERT_EQ(0, _lessdb.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_EQ(CLEAR_MISSES + 1, _lessdb.readCacheMisses());
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_EQ(HITS, _lessdb.readCacheHits());
+    ASSERT_EQ(CLEAR_MISSES + 1, _lessdb.readCacheMisses());
+    readAll();
+    ASSERT_EQ(CLEAR_MISSES + 5, _lessdb.readCacheMisses());
+
+    // counters are reset only on request
+    _lessdb.resetStats();
+    ASSERT_EQ(0, _lessdb.readCacheHits());
+    ASSERT_EQ(0, _lessdb.readCacheMisses());
+
+    // invalid sizes
+    ASSERT_FALSE(_lessdb.setReadCacheSize(3));
+    ASSERT_FALSE(_lessdb.setReadCacheSize(1024));
+
+    // disabled cache
+    ASSERT_TRUE(_lessdb.setReadCacheSize(0));
+    _hwa.resetCounters();
+    readAll();
+    readAll();
+    ASSERT_EQ(8, _hwa._readCount);
+    ASSERT_EQ(0, _lessdb.readCacheHits());
+    ASSERT_EQ(0, _lessdb.readCacheMisses());
+
+    // single entry
+    ASSERT_TRUE(_lessdb.setReadCacheSize(1));
+    ASSERT_EQ(DEFAULT_VALUES[3], _lessdb.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_EQ(DEFAULT_VALUES[3], _lessdb.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_EQ(1, _lessdb.readCacheHits());
+}
+
+TEST_F(DatabaseTest, DefaultValuesVector)
+{
+    const std::vector<uint32_t> BIT_DEFAULTS       = { 1, 0, 0, 1, 1, 0, 1, 0, 1, 1 };
+    const std::vector<uint32_t> HALF_BYTE_DEFAULTS = { 1, 2, 3, 15, 7 };
+    const std::vector<uint32_t> WORD_DEFAULTS      = { 0x1234, 0xABCD, 7 };
+
+    std::vector<Section> sections = {
+        {
+            BIT_DEFAULTS.size(),
+            sectionParameterType_t::BIT,
+            preserveSetting_t::DISABLE,
+            autoIncrementSetting_t::DISABLE,
+            BIT_DEFAULTS,
+        },
+
+        {
+            HALF_BYTE_DEFAULTS.size(),
+            sectionParameterType_t::HALF_BYTE,
+            preserveSetting_t::DISABLE,
+            autoIncrementSetting_t::DISABLE,
+            HALF_BYTE_DEFAULTS,
+        },
+
+        {
+            WORD_DEFAULTS.size(),
+            sectionParameterType_t::WORD,
+            preserveSetting_t::DISABLE,
+            autoIncrementSetting_t::DISABLE,
+            WORD_DEFAULTS,
+        },
+    };
+
+    std::vector<Block> layout = {
+        {
+            sections,
+        },
+    };
+
+    ASSERT_TRUE(_lessdb.setLayout(layout, 0));
+
+    // verify both single-value and range initialization
+    for (int pass = 0; pass < 2; pass++)
+    {
+        _hwa.clear();
+        _hwa._rangeAccess = pass;
+        ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+        LessDb db(_hwa);
+        ASSERT_TRUE(db.setLayout(layout, 0));
+
+        for (size_t i = 0; i < BIT_DEFAULTS.size(); i++)
+        {
+            ASSERT_EQ(BIT_DEFAULTS[i], db.read(0, 0, i));
+        }
+
+        for (size_t i = 0; i < HALF_BYTE_DEFAULTS.size(); i++)
+        {
+            ASSERT_EQ(HALF_BYTE_DEFAULTS[i], db.read(0, 1, i));
+        }
+
+        for (size_t i = 0; i < WORD_DEFAULTS.size(); i++)
+        {
+            ASSERT_EQ(WORD_DEFAULTS[i], db.read(0, 2, i));
+        }
+    }
+}
+
+TEST_F(DatabaseTest, Shadow)
+{
+    _hwa._rangeAccess = true;
+
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    ASSERT_TRUE(_lessdb.setLayout(DB_LAYOUT));
+    ASSERT_EQ(0, _lessdb.dirtyBytes());
+
+    _hwa.resetCounters();
+
+    // reads and updates shouldn't touch the storage
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+        {
+            ASSERT_EQ(DEFAULT_VALUES[section] + (section == 1 ? i : 0), _lessdb.read(TEST_BLOCK_INDEX, section, i));
+        }
+    }
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, 1, 0));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 2, 3, 7));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 0, 0xBEEF));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 1, 0xCAFE));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 2, 0x12345678));
+
+    ASSERT_EQ(0, _hwa._readCount);
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._readRangeCount);
+    ASSERT_EQ(0, _hwa._writeRangeCount);
+    ASSERT_EQ(1 + 1 + 4 + 4, _lessdb.dirtyBytes());
+
+    ASSERT_EQ(0, _lessdb.read(TEST_BLOCK_INDEX, 0, 1));
+    ASSERT_EQ(7, _lessdb.read(TEST_BLOCK_INDEX, 2, 3));
+    ASSERT_EQ(0xBEEF, _lessdb.read(TEST_BLOCK_INDEX, 3, 0));
+    ASSERT_EQ(0xCAFE, _lessdb.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_EQ(0x12345678, _lessdb.read(TEST_BLOCK_INDEX, 4, 2));
+
+    // enabling already active shadow keeps dirty bytes
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    ASSERT_EQ(1 + 1 + 4 + 4, _lessdb.dirtyBytes());
+    ASSERT_EQ(0xBEEF, _lessdb.read(TEST_BLOCK_INDEX, 3, 0));
+    ASSERT_EQ(0, _hwa._readRangeCount);
+
+    // storage still holds the old values
+    // second instance doesn't cache reads since storage is modified behind its back
+    LessDb db(_hwa);
+    ASSERT_TRUE(db.setReadCacheSize(0));
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+    ASSERT_EQ(DEFAULT_VALUES[3], db.read(TEST_BLOCK_INDEX, 3, 0));
+
+    // consecutive dirty bytes are written in a single range
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.flush());
+    ASSERT_EQ(0, _lessdb.dirtyBytes());
+    ASSERT_EQ(4, _hwa._writeRangeCount);
+
+    ASSERT_EQ(0, db.read(TEST_BLOCK_INDEX, 0, 1));
+    ASSERT_EQ(7, db.read(TEST_BLOCK_INDEX, 2, 3));
+    ASSERT_EQ(0xBEEF, db.read(TEST_BLOCK_INDEX, 3, 0));
+    ASSERT_EQ(0xCAFE, db.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_EQ(0x12345678, db.read(TEST_BLOCK_INDEX, 4, 2));
+
+    // nothing left to write
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.flush());
+    ASSERT_EQ(0, _hwa._writeRangeCount);
+
+    // factory reset is written to the storage immediately
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_EQ(0, _lessdb.dirtyBytes());
+    ASSERT_EQ(DEFAULT_VALUES[3], db.read(TEST_BLOCK_INDEX, 3, 0));
+
+    // automatic flush
+    _lessdb.setAutoFlushThreshold(4);
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 0, 1));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 1, 2));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 2, 3));
+    ASSERT_EQ(3, _lessdb.dirtyBytes());
+    ASSERT_EQ(DEFAULT_VALUES[1], db.read(TEST_BLOCK_INDEX, 1, 0));
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 3, 4));
+    ASSERT_EQ(0, _lessdb.dirtyBytes());
+    ASSERT_EQ(1, db.read(TEST_BLOCK_INDEX, 1, 0));
+    ASSERT_EQ(4, db.read(TEST_BLOCK_INDEX, 1, 3));
+
+    // disabling the shadow writes pending changes
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 4, 5));
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::DISABLE));
+    ASSERT_EQ(5, db.read(TEST_BLOCK_INDEX, 1, 4));
+    ASSERT_EQ(5, _lessdb.read(TEST_BLOCK_INDEX, 1, 4));
+}
+
+TEST_F(DatabaseTest, CompareBeforeWrite)
+{
+    // enabled by default
+    _hwa.resetCounters();
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, section, 0, DEFAULT_VALUES[section]));
+    }
+
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(SECTION_PARAMS.size(), _lessdb.skippedWrites());
+
+    // changed values are still written
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, 0, 0));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 2, 1, 3));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 0, 0xFFFFFFFF));
+    ASSERT_EQ(3, _hwa._writeCount);
+    ASSERT_EQ(SECTION_PARAMS.size(), _lessdb.skippedWrites());
+    ASSERT_EQ(0, _lessdb.read(TEST_BLOCK_INDEX, 0, 0));
+    ASSERT_EQ(3, _lessdb.read(TEST_BLOCK_INDEX, 2, 1));
+    ASSERT_EQ(0xFFFFFFFF, _lessdb.read(TEST_BLOCK_INDEX, 4, 0));
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 0, 0xFFFFFFFF));
+    ASSERT_EQ(3, _hwa._writeCount);
+    ASSERT_EQ(SECTION_PARAMS.size() + 1, _lessdb.skippedWrites());
+
+    // always write when disabled
+    _lessdb.setCompareBeforeWrite(compareBeforeWriteSetting_t::DISABLE);
+    _hwa.resetCounters();
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, section, 1, DEFAULT_VALUES[section] + (section == 1)));
+    }
+
+    ASSERT_EQ(SECTION_PARAMS.size(), _hwa._writeCount);
+    ASSERT_EQ(SECTION_PARAMS.size() + 1, _lessdb.skippedWrites());
+}
+
+TEST_F(DatabaseTest, VerifyPolicy)
+{
+    _lessdb.setCompareBeforeWrite(compareBeforeWriteSetting_t::DISABLE);
+
+    // always: every write is read back
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 0, 1));
+    ASSERT_EQ(1, _hwa._writeCount);
+    ASSERT_EQ(1, _hwa._readCount);
+
+    // never: no read back
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::NEVER));
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 0, 2));
+    ASSERT_EQ(1, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._readCount);
+    ASSERT_EQ(2, _lessdb.read(TEST_BLOCK_INDEX, 1, 0));
+
+    // deferred: writes are verified on request
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::DEFERRED));
+    _hwa.resetCounters();
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, i, 100 + i));
+    }
+
+    ASSERT_EQ(5, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._readCount);
+    ASSERT_TRUE(_lessdb.verify());
+    ASSERT_EQ(5, _hwa._readCount);
+
+    // nothing left to verify
+    ASSERT_TRUE(_lessdb.verify());
+    ASSERT_EQ(5, _hwa._readCount);
+
+    // corrupt the written values
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value + 1, type);
+    };
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 0, 50));
+    ASSERT_FALSE(_lessdb.verify());
+
+    // full list of pending writes is verified automatically
+    _hwa.resetCounters();
+    bool result = true;
+
+    for (size_t i = 0; i < 16; i++)
+    {
+        result &= (i < SECTION_PARAMS[3]) ? _lessdb.update(TEST_BLOCK_INDEX, 3, i, i)
+                                          : _lessdb.update(TEST_BLOCK_INDEX, 5, i - SECTION_PARAMS[3], i);
+    }
+
+    ASSERT_FALSE(result);
+    ASSERT_EQ(16, _hwa._readCount);
+
+    // factory reset is verified once all sections are written
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    _hwa._rangeAccess = true;
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_EQ(SECTION_PARAMS.size() * DB_LAYOUT.size(), _hwa._writeRangeCount);
+    ASSERT_EQ(SECTION_PARAMS.size() * DB_LAYOUT.size(), _hwa._readRangeCount);
+
+    // same without range access
+    _hwa._rangeAccess = false;
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value ^ 0x01, type);
+    };
+
+    ASSERT_FALSE(_lessdb.initData(factoryResetType_t::FULL));
+
+    // only the last write to the same address is verified
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, 0, 0));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, 1, 0));
+    ASSERT_TRUE(_lessdb.verify());
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 5, 0, 5));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 5, 0, 6));
+    ASSERT_TRUE(_lessdb.verify());
+
+    // repeated updates don't fill the list of pending writes
+    for (size_t i = 0; i < 32; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 5, 0, i));
+    }
+
+    ASSERT_TRUE(_lessdb.verify());
+
+    // writes overwritten by initialization or cleared aren't verified
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 5, 1, 0x11));
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_TRUE(_lessdb.verify());
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 5, 1, 0x11));
+    ASSERT_TRUE(_lessdb.clear());
+    ASSERT_TRUE(_lessdb.verify());
+}
+
+TEST_F(DatabaseTest, NoLayout)
+{
+    LessDb   db(_hwa);
+    uint32_t value;
+
+    ASSERT_FALSE(db.read(0, 0, 0, value));
+    ASSERT_FALSE(db.update(0, 0, 0, 1));
+    ASSERT_TRUE(db.initData(factoryResetType_t::FULL));
+
+    // failed layout shouldn't be partially applied
+    std::vector<Section> outOfBoundsSection = {
+        {
+            LESSDB_SIZE,
+            sectionParameterType_t::BYTE,
+            preserveSetting_t::DISABLE,
+            autoIncrementSetting_t::DISABLE,
+            1,
+        },
+    };
+
+    std::vector<Block> outOfBoundsLayout = {
+        {
+            outOfBoundsSection,
+        },
+    };
+
+    ASSERT_FALSE(db.setLayout(outOfBoundsLayout, 1));
+    ASSERT_FALSE(db.read(0, 0, 0, value));
+    ASSERT_TRUE(db.setLayout(outOfBoundsLayout, 0));
+    ASSERT_TRUE(db.read(0, 0, LESSDB_SIZE - 1, value));
+
+    // empty layout writes pending changes of the previous one and deactivates it
+    std::vector<Block> emptyLayout = {};
+
+    ASSERT_TRUE(db.setShadow(shadowSetting_t::ENABLE));
+    ASSERT_TRUE(db.update(0, 0, 3, 0x5A));
+    ASSERT_EQ(1, db.dirtyBytes());
+    ASSERT_FALSE(db.setLayout(emptyLayout));
+    ASSERT_EQ(0, db.dirtyBytes());
+    ASSERT_FALSE(db.read(0, 0, 3, value));
+    ASSERT_FALSE(db.beginTransaction());
+    ASSERT_EQ(0, db.currentDatabaseSize());
+    ASSERT_TRUE(_hwa.memoryRead(3, value, sectionParameterType_t::BYTE));
+    ASSERT_EQ(0x5A, value);
+}
+
+namespace
+{
+    enum class staticBlock_t : uint8_t
+    {
+        GENERAL,
+        MIDI,
+    };
+
+    enum class staticMidiSection_t : uint8_t
+    {
+        CHANNEL,
+        VELOCITY,
+        PITCH,
+        TIMESTAMP,
+        PROGRAM,
+        ENABLED,
+    };
+
+    // same as the first two blocks of test layout
+    using StaticTestLayout = StaticLayout<
+        0,
+        StaticBlock<
+            StaticSection<5, sectionParameterType_t::BIT, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 1>,
+            StaticSection<10, sectionParameterType_t::BYTE, preserveSetting_t::ENABLE, autoIncrementSetting_t::ENABLE, 10>,
+            StaticSection<15, sectionParameterType_t::HALF_BYTE, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 15>,
+            StaticSection<10, sectionParameterType_t::WORD, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 20>,
+            StaticSection<15, sectionParameterType_t::DWORD, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 25>,
+            StaticSection<10, sectionParameterType_t::BYTE, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 30>>,
+        StaticBlock<
+            StaticSection<10, sectionParameterType_t::BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 10>,
+            StaticSection<15, sectionParameterType_t::HALF_BYTE, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 15>,
+            StaticSection<10, sectionParameterType_t::WORD, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 20>,
+            StaticSection<15, sectionParameterType_t::DWORD, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 25>,
+            StaticSection<10, sectionParameterType_t::BYTE, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 30>,
+            StaticSection<5, sectionParameterType_t::BIT, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 1>>>;
+
+    static_assert(StaticTestLayout::SIZE == (109 * 2));
+    static_assert(StaticTestLayout::PARAMETERS == (65 * 2));
+    static_assert(StaticTestLayout::sectionAddress<0, 3>() == 1 + 10 + 8);
+    static_assert(StaticTestLayout::sectionAddress<1, 0>() == 109);
+    static_assert(StaticTestLayout::sectionAddress<1, 3>() == 109 + 10 + 8 + 20);
+
+    constexpr std::array<uint32_t, 3> STATIC_HALF_BYTE_DEFAULTS = { 3, 7, 12 };
+    constexpr std::array<uint32_t, 4> STATIC_WORD_DEFAULTS      = { 100, 0, 0xFFFF, 1234 };
+
+    using StaticDefaultsLayout = StaticLayout<
+        0,
+        StaticBlock<
+            StaticSection<3, sectionParameterType_t::HALF_BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0, STATIC_HALF_BYTE_DEFAULTS>,
+            StaticSection<4, sectionParameterType_t::WORD, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0, STATIC_WORD_DEFAULTS>>>;
+}    // namespace
+
+TEST_F(DatabaseTest, StaticLayout)
+{
+    StaticLessDb<StaticTestLayout, LESSDB_SIZE> db(_hwa);
+
+    ASSERT_TRUE(db.init());
+    ASSERT_EQ(StaticTestLayout::SIZE, db.database().currentDatabaseSize());
+    ASSERT_EQ(StaticTestLayout::PARAMETERS, db.database().currentDatabaseParameters());
+
+    std::vector<Block> runtimeLayout = {
+        {
+            BLOCK_0_SECTIONS,
+        },
+
+        {
+            BLOCK_1_SECTIONS,
+        },
+    };
+
+    ASSERT_EQ(LessDb::layoutUid(runtimeLayout, 0x1234), StaticTestLayout::uid(0x1234));
+
+    // runtime layout with the same sections uses the same addresses
+    _hwa.clear();
+    ASSERT_TRUE(db.initData());
+    ASSERT_TRUE(_lessdb.setLayout(runtimeLayout));
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+        {
+            ASSERT_EQ(DEFAULT_VALUES[section] + (section == 1 ? i : 0), _lessdb.read(TEST_BLOCK_INDEX, section, i));
+        }
+    }
+
+    ASSERT_EQ(15, (db.read<staticBlock_t::MIDI, staticMidiSection_t::VELOCITY>(14)));
+    ASSERT_EQ(1, (db.read<staticBlock_t::MIDI, staticMidiSection_t::ENABLED>(4)));
+    ASSERT_EQ(25, (db.read<1, 3>(0)));
+
+    ASSERT_TRUE((db.update<staticBlock_t::MIDI, staticMidiSection_t::CHANNEL>(9, 0xAB)));
+    ASSERT_TRUE((db.update<staticBlock_t::MIDI, staticMidiSection_t::TIMESTAMP>(14, 0xDEADBEEF)));
+    ASSERT_TRUE((db.update<0, 0>(4, 0)));
+    ASSERT_EQ(0xAB, (db.read<staticBlock_t::MIDI, staticMidiSection_t::CHANNEL>(9)));
+    ASSERT_EQ(0xDEADBEEF, _lessdb.read(1, 3, 14));
+    ASSERT_EQ(0, _lessdb.read(0, 0, 4));
+
+    // out of range
+    uint32_t value;
+    ASSERT_FALSE((db.read<staticBlock_t::MIDI, staticMidiSection_t::TIMESTAMP>(15, value)));
+    ASSERT_FALSE((db.update<0, 0>(5, 1)));
+
+    // index-based access works as well
+    ASSERT_EQ(0xAB, db.database().read(1, 0, 9));
+
+    uint32_t values[15] = {};
+
+    ASSERT_TRUE((db.readSection<staticBlock_t::MIDI, staticMidiSection_t::TIMESTAMP>(values, 15)));
+    ASSERT_EQ(25, values[0]);
+    ASSERT_EQ(0xDEADBEEF, values[14]);
+    ASSERT_FALSE((db.readSection<staticBlock_t::MIDI, staticMidiSection_t::TIMESTAMP>(values, 14)));
+
+    // per-parameter default values
+    StaticLessDb<StaticDefaultsLayout, LESSDB_SIZE> defaultsDb(_hwa);
+
+    ASSERT_TRUE(defaultsDb.init());
+    ASSERT_TRUE(defaultsDb.initData());
+
+    for (size_t i = 0; i < STATIC_HALF_BYTE_DEFAULTS.size(); i++)
+    {
+        ASSERT_EQ(STATIC_HALF_BYTE_DEFAULTS[i], (defaultsDb.read<0, 0>(i)));
+    }
+
+    for (size_t i = 0; i < STATIC_WORD_DEFAULTS.size(); i++)
+    {
+        ASSERT_EQ(STATIC_WORD_DEFAULTS[i], (defaultsDb.read<0, 1>(i)));
+    }
+
+    ASSERT_TRUE((defaultsDb.update<0, 0>(1, 9)));
+    ASSERT_EQ(3, (defaultsDb.read<0, 0>(0)));
+    ASSERT_EQ(9, (defaultsDb.read<0, 0>(1)));
+    ASSERT_EQ(12, (defaultsDb.read<0, 0>(2)));
+}
+
+TEST_F(DatabaseTest, FlashBackend)
+{
+    static constexpr size_t PAGE_SIZE       = 512;
+    static constexpr size_t NUMBER_OF_PAGES = 8;
+
+    RamFlashPages pages(PAGE_SIZE, NUMBER_OF_PAGES);
+    HwaFlash      flash(pages, LESSDB_SIZE);
+    LessDb        db(flash);
+
+    auto totalErases = [&]()
+    {
+        uint32_t total = 0;
+
+        for (size_t page = 0; page < NUMBER_OF_PAGES; page++)
+        {
+            total += pages.eraseCount(page);
+        }
+
+        return total;
+    };
+
+    ASSERT_TRUE(db.init());
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+    ASSERT_TRUE(db.initData());
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+        {
+            ASSERT_EQ(DEFAULT_VALUES[section] + (section == 1 ? i : 0), db.read(TEST_BLOCK_INDEX, section, i));
+        }
+    }
+
+    // updates are appended without erasing
+    const uint32_t ERASES = totalErases();
+
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 3, 0, 0x1234));
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 0, 0x12345678));
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 0, 0, 0));
+    ASSERT_EQ(ERASES, totalErases());
+
+    // hammer the same parameters so that pages get compacted
+    for (uint32_t i = 0; i < 4500; i++)
+    {
+        ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 3, i % SECTION_PARAMS[3], i));
+        ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 2, i % SECTION_PARAMS[2], i & 0x0F));
+    }
+
+    ASSERT_GT(flash.compactions(), 0);
+
+    // erase cycles are spread across all pages
+    uint32_t minErases = 0xFFFFFFFF;
+    uint32_t maxErases = 0;
+
+    for (size_t page = 0; page < NUMBER_OF_PAGES; page++)
+    {
+        minErases = std::min(minErases, pages.eraseCount(page));
+        maxErases = std::max(maxErases, pages.eraseCount(page));
+    }
+
+    ASSERT_LE(maxErases - minErases, 1);
+
+    auto verify = [&](LessDb& database)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[3]; i++)
+        {
+            ASSERT_EQ((4500 - SECTION_PARAMS[3] + i), database.read(TEST_BLOCK_INDEX, 3, i));
+        }
+
+        for (size_t i = 0; i < SECTION_PARAMS[2]; i++)
+        {
+            ASSERT_EQ((4500 - SECTION_PARAMS[2] + i) & 0x0F, database.read(TEST_BLOCK_INDEX, 2, i));
+        }
+
+        ASSERT_EQ(0x12345678, database.read(TEST_BLOCK_INDEX, 4, 0));
+        ASSERT_EQ(0, database.read(TEST_BLOCK_INDEX, 0, 0));
+        ASSERT_EQ(DEFAULT_VALUES[0], database.read(TEST_BLOCK_INDEX, 0, 1));
+        ASSERT_EQ(DEFAULT_VALUES[5], database.read(TEST_BLOCK_INDEX, 5, 9));
+    };
+
+    verify(db);
+
+    // index is rebuilt from flash content
+    HwaFlash flash2(pages, LESSDB_SIZE);
+    LessDb   db2(flash2);
+
+    ASSERT_TRUE(db2.init());
+    ASSERT_TRUE(db2.setLayout(DB_LAYOUT));
+    verify(db2);
+
+    ASSERT_TRUE(db2.clear());
+    ASSERT_EQ(0, db2.read(TEST_BLOCK_INDEX, 4, 0));
+
+    // power lost during compaction, before the oldest page is erased
+    class CutFlashPages : public RamFlashPages
+    {
+        public:
+        using RamFlashPages::RamFlashPages;
+
+        bool erasePage(size_t page) override
+        {
+            return !_powerCut && RamFlashPages::erasePage(page);
+        }
+
+        bool _powerCut = false;
+    };
+
+    CutFlashPages cutPages(PAGE_SIZE, NUMBER_OF_PAGES);
+    HwaFlash      cutFlash(cutPages, LESSDB_SIZE);
+    LessDb        cutDb(cutFlash);
+
+    ASSERT_TRUE(cutDb.init());
+    ASSERT_TRUE(cutDb.setLayout(DB_LAYOUT));
+    ASSERT_TRUE(cutDb.initData());
+    ASSERT_TRUE(cutDb.update(TEST_BLOCK_INDEX, 4, 0, 0x12345678));
+
+    cutPages._powerCut = true;
+    uint32_t written   = 0;
+
+    // byte parameter is stored in a single record, so failed update leaves nothing behind
+    while ((written < 4500) && cutDb.update(TEST_BLOCK_INDEX, 5, 0, written & 0xFF))
+    {
+        written++;
+    }
+
+    ASSERT_LT(written, 4500);
+    ASSERT_EQ(0, cutFlash.compactions());
+
+    cutPages._powerCut = false;
+
+    // compaction is completed on next mount
+    HwaFlash recovered(cutPages, LESSDB_SIZE);
+    LessDb   recoveredDb(recovered);
+
+    ASSERT_TRUE(recoveredDb.init());
+    ASSERT_TRUE(recoveredDb.setLayout(DB_LAYOUT));
+    ASSERT_EQ(1, recovered.compactions());
+    ASSERT_EQ((written - 1) & 0xFF, recoveredDb.read(TEST_BLOCK_INDEX, 5, 0));
+    ASSERT_EQ(0x12345678, recoveredDb.read(TEST_BLOCK_INDEX, 4, 0));
+    ASSERT_EQ(DEFAULT_VALUES[5], recoveredDb.read(TEST_BLOCK_INDEX, 5, 9));
+
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        ASSERT_TRUE(recoveredDb.update(TEST_BLOCK_INDEX, 5, 0, i & 0xFF));
+    }
+
+    ASSERT_EQ(999 & 0xFF, recoveredDb.read(TEST_BLOCK_INDEX, 5, 0));
+    ASSERT_EQ(0x12345678, recoveredDb.read(TEST_BLOCK_INDEX, 4, 0));
+
+    // power lost while a record is programmed, after only part of it has reached the flash
+    class TornFlashPages : public RamFlashPages
+    {
+        public:
+        using RamFlashPages::RamFlashPages;
+
+        bool program(size_t page, size_t offset, const uint8_t* data, size_t size) override
+        {
+            if (!_tear)
+            {
+                return RamFlashPages::program(page, offset, data, size);
+            }
+
+            RamFlashPages::program(page, offset + _tearStart, data + _tearStart, _tearSize);
+            return false;
+        }
+
+        bool   _tear      = false;
+        size_t _tearStart = 0;
+        size_t _tearSize  = 0;
+    };
+
+    TornFlashPages tornPages(PAGE_SIZE, NUMBER_OF_PAGES);
+
+    {
+        HwaFlash tornFlash(tornPages, LESSDB_SIZE);
+        LessDb   tornDb(tornFlash);
+
+        ASSERT_TRUE(tornDb.init());
+        ASSERT_TRUE(tornDb.setLayout(DB_LAYOUT));
+        ASSERT_TRUE(tornDb.initData());
+        ASSERT_TRUE(tornDb.update(TEST_BLOCK_INDEX, 5, 0, 0x12));
+    }
+
+    // header only, data only and header without the checksum
+    for (const auto& [start, size] : std::vector<std::pair<size_t, size_t>>{ { 0, 4 }, { 4, 4 }, { 0, 3 } })
+    {
+        HwaFlash tornFlash(tornPages, LESSDB_SIZE);
+        LessDb   tornDb(tornFlash);
+
+        ASSERT_TRUE(tornDb.init());
+        ASSERT_TRUE(tornDb.setLayout(DB_LAYOUT));
+
+        tornPages._tear      = true;
+        tornPages._tearStart = start;
+        tornPages._tearSize  = size;
+
+        ASSERT_FALSE(tornDb.update(TEST_BLOCK_INDEX, 5, 0, 0xA5));
+
+        tornPages._tear = false;
+
+        // torn record is ignored and new records are appended after it
+        HwaFlash remounted(tornPages, LESSDB_SIZE);
+        LessDb   remountedDb(remounted);
+
+        ASSERT_TRUE(remountedDb.init());
+        ASSERT_TRUE(remountedDb.setLayout(DB_LAYOUT));
+        ASSERT_EQ(0x12, remountedDb.read(TEST_BLOCK_INDEX, 5, 0));
+        ASSERT_TRUE(remountedDb.update(TEST_BLOCK_INDEX, 5, 1, 0x34));
+        ASSERT_EQ(0x34, remountedDb.read(TEST_BLOCK_INDEX, 5, 1));
+    }
+
+    // layout doesn't fit into flash
+    RamFlashPages smallPages(PAGE_SIZE, 3);
+    HwaFlash      smallFlash(smallPages, LESSDB_SIZE);
+
+    ASSERT_FALSE(smallFlash.init());
+}
+
+TEST_F(DatabaseTest, Transaction)
+{
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    ASSERT_FALSE(_lessdb.commit());
+    ASSERT_TRUE(_lessdb.beginTransaction());
+    ASSERT_FALSE(_lessdb.beginTransaction());
+    ASSERT_TRUE(_lessdb.transactionActive());
+
+    _hwa.resetCounters();
+
+    for (size_t i = 0; i < SECTION_PARAMS[0]; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, i, 0));
+    }
+
+    for (size_t i = 0; i < SECTION_PARAMS[3]; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, i, 0x1000 + i));
+    }
+
+    // nothing is written while transaction is active
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._writeRangeCount);
+
+    // staged values are visible through this instance only
+    LessDb db(_hwa);
+    ASSERT_TRUE(db.setReadCacheSize(0));
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+
+    for (size_t i = 0; i < SECTION_PARAMS[3]; i++)
+    {
+        ASSERT_EQ(0x1000 + i, _lessdb.read(TEST_BLOCK_INDEX, 3, i));
+        ASSERT_EQ(DEFAULT_VALUES[3], db.read(TEST_BLOCK_INDEX, 3, i));
+    }
+
+    std::vector<uint32_t> bits(SECTION_PARAMS[0]);
+    ASSERT_TRUE(_lessdb.readSection(TEST_BLOCK_INDEX, 0, bits.data(), bits.size()));
+    ASSERT_EQ(std::vector<uint32_t>(SECTION_PARAMS[0], 0), bits);
+
+    // initialization isn't allowed in the middle of transaction
+    ASSERT_FALSE(_lessdb.initData());
+    ASSERT_FALSE(_lessdb.clear());
+
+    // staged bytes are written in as many runs as there are separate regions
+    _hwa._rangeAccess = true;
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.commit());
+    ASSERT_FALSE(_lessdb.transactionActive());
+    ASSERT_EQ(2, _hwa._writeRangeCount);
+
+    for (size_t i = 0; i < SECTION_PARAMS[3]; i++)
+    {
+        ASSERT_EQ(0x1000 + i, db.read(TEST_BLOCK_INDEX, 3, i));
+    }
+
+    ASSERT_EQ(0, db.read(TEST_BLOCK_INDEX, 0, 0));
+
+    // rolled back changes are discarded
+    ASSERT_TRUE(_lessdb.beginTransaction());
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 0, 0xABCD));
+    ASSERT_EQ(0xABCD, _lessdb.read(TEST_BLOCK_INDEX, 4, 0));
+    _lessdb.rollback();
+    ASSERT_EQ(DEFAULT_VALUES[4], _lessdb.read(TEST_BLOCK_INDEX, 4, 0));
+    ASSERT_EQ(DEFAULT_VALUES[4], db.read(TEST_BLOCK_INDEX, 4, 0));
+
+    // out of order and overlapping updates are merged into a single run
+    const uint32_t RANGE[3] = { 0x3133, 0x3134, 0x3135 };
+
+    ASSERT_TRUE(_lessdb.beginTransaction());
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 6, 0x2006));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 2, 0x2002));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 3, 4, 0x2004));
+    ASSERT_TRUE(_lessdb.updateRange(TEST_BLOCK_INDEX, 3, 3, 3, RANGE));
+    ASSERT_EQ(0x2002, _lessdb.read(TEST_BLOCK_INDEX, 3, 2));
+    ASSERT_EQ(0x3134, _lessdb.read(TEST_BLOCK_INDEX, 3, 4));
+    ASSERT_EQ(0x2006, _lessdb.read(TEST_BLOCK_INDEX, 3, 6));
+
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.commit());
+    ASSERT_EQ(1, _hwa._writeRangeCount);
+    ASSERT_EQ(0x1001, db.read(TEST_BLOCK_INDEX, 3, 1));
+    ASSERT_EQ(0x2002, db.read(TEST_BLOCK_INDEX, 3, 2));
+    ASSERT_EQ(0x3133, db.read(TEST_BLOCK_INDEX, 3, 3));
+    ASSERT_EQ(0x3135, db.read(TEST_BLOCK_INDEX, 3, 5));
+    ASSERT_EQ(0x2006, db.read(TEST_BLOCK_INDEX, 3, 6));
+    ASSERT_EQ(0x1007, db.read(TEST_BLOCK_INDEX, 3, 7));
+
+    // commit through shadow ends up in the storage
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    ASSERT_TRUE(_lessdb.beginTransaction());
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 1, 0xABCD));
+    ASSERT_TRUE(_lessdb.commit());
+    ASSERT_EQ(0, _lessdb.dirtyBytes());
+    ASSERT_EQ(0xABCD, db.read(TEST_BLOCK_INDEX, 4, 1));
+
+    // staged section isn't read back before it's committed
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::DISABLE));
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::DEFERRED));
+
+    std::vector<uint32_t> values(SECTION_PARAMS[5], 0x5A);
+    ASSERT_TRUE(_lessdb.beginTransaction());
+    ASSERT_TRUE(_lessdb.updateSection(TEST_BLOCK_INDEX, 5, values.data(), values.size()));
+    ASSERT_TRUE(_lessdb.commit());
+    ASSERT_TRUE(_lessdb.verify());
+    ASSERT_EQ(0x5A, db.read(TEST_BLOCK_INDEX, 5, SECTION_PARAMS[5] - 1));
+
+    // committed runs are read back as soon as they're written
+    _hwa._rangeAccess   = false;
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value ^ 0x01, type);
+    };
+
+    values.assign(values.size(), 0x3C);
+
+    ASSERT_TRUE(_lessdb.beginTransaction());
+    ASSERT_TRUE(_lessdb.updateSection(TEST_BLOCK_INDEX, 5, values.data(), values.size()));
+    ASSERT_FALSE(_lessdb.commit());
+
+    // failed commit keeps the transaction so that it can be retried
+    ASSERT_TRUE(_lessdb.transactionActive());
+    ASSERT_EQ(0x3C, _lessdb.read(TEST_BLOCK_INDEX, 5, 0));
+
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    ASSERT_TRUE(_lessdb.commit());
+    ASSERT_FALSE(_lessdb.transactionActive());
+    ASSERT_EQ(0x3C, db.read(TEST_BLOCK_INDEX, 5, SECTION_PARAMS[5] - 1));
+}
+
+TEST_F(DatabaseTest, TransactionJournal)
+{
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    const uint32_t JOURNAL_ADDRESS = _lessdb.nextParameterAddress();
+    const uint32_t JOURNAL_SIZE    = LESSDB_SIZE - JOURNAL_ADDRESS;
+
+    // journal can't overlap the database
+    ASSERT_FALSE(_lessdb.setJournal(JOURNAL_ADDRESS - 1, JOURNAL_SIZE));
+    ASSERT_FALSE(_lessdb.setJournal(JOURNAL_ADDRESS, JOURNAL_SIZE + 1));
+    ASSERT_TRUE(_lessdb.setJournal(JOURNAL_ADDRESS, JOURNAL_SIZE));
+
+    ASSERT_TRUE(_lessdb.beginTransaction());
+
+    for (size_t i = 0; i < SECTION_PARAMS[4]; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, i, 0x10000 + i));
+    }
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 1, 0, 123));
+
+    // simulate power loss once the journal has been written
+    _hwa._writeCallback = [this, JOURNAL_ADDRESS](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        if (address < JOURNAL_ADDRESS)
+        {
+            return false;
+        }
+
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    ASSERT_FALSE(_lessdb.commit());
+
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    LessDb db(_hwa);
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+    ASSERT_EQ(DEFAULT_VALUES[4], db.read(TEST_BLOCK_INDEX, 4, 0));
+
+    // committed changes are completed once the journal is set
+    ASSERT_TRUE(db.setJournal(JOURNAL_ADDRESS, JOURNAL_SIZE));
+
+    for (size_t i = 0; i < SECTION_PARAMS[4]; i++)
+    {
+        ASSERT_EQ(0x10000 + i, db.read(TEST_BLOCK_INDEX, 4, i));
+    }
+
+    ASSERT_EQ(123, db.read(TEST_BLOCK_INDEX, 1, 0));
+
+    // journal is empty now
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 1, 0, 7));
+    ASSERT_TRUE(db.setJournal(JOURNAL_ADDRESS, JOURNAL_SIZE));
+    ASSERT_EQ(7, db.read(TEST_BLOCK_INDEX, 1, 0));
+
+    // transaction which doesn't fit into journal isn't committed
+    ASSERT_TRUE(db.setJournal(JOURNAL_ADDRESS, 16));
+    ASSERT_TRUE(db.beginTransaction());
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 0, 1));
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 2, 1));
+    ASSERT_FALSE(db.commit());
+    ASSERT_TRUE(db.transactionActive());
+    db.rollback();
+    ASSERT_EQ(0x10000, db.read(TEST_BLOCK_INDEX, 4, 0));
+}
+
+#ifdef __unix__
+TEST_F(DatabaseTest, MmapBackend)
+{
+    const std::string PATH = (std::filesystem::temp_directory_path() / ("lessdb-test-" + std::to_string(getpid()) + ".bin")).string();
+
+    std::filesystem::remove(PATH);
+
+    {
+        HwaMmap storage(PATH, LESSDB_SIZE, msyncPolicy_t::EVERY_WRITE);
+        LessDb  db(storage);
+
+        ASSERT_TRUE(db.init());
+        ASSERT_EQ(LESSDB_SIZE, std::filesystem::file_size(PATH));
+        ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+        ASSERT_TRUE(db.initData());
+
+        const uint32_t SYNCS = storage.syncCount();
+
+        ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 0, 0xDEADBEEF));
+        ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 2, 3, 7));
+        ASSERT_EQ(SYNCS + 2, storage.syncCount());
+    }
+
+    {
+        HwaMmap storage(PATH, LESSDB_SIZE, msyncPolicy_t::ON_FLUSH);
+        LessDb  db(storage);
+
+        ASSERT_TRUE(db.init());
+        ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+
+        // values written by previous instance are preserved
+        ASSERT_EQ(0xDEADBEEF, db.read(TEST_BLOCK_INDEX, 4, 0));
+        ASSERT_EQ(7, db.read(TEST_BLOCK_INDEX, 2, 3));
+        ASSERT_EQ(DEFAULT_VALUES[1] + 5, db.read(TEST_BLOCK_INDEX, 1, 5));
+
+        ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 0, 1));
+        ASSERT_EQ(0, storage.syncCount());
+        ASSERT_TRUE(storage.flush());
+        ASSERT_EQ(1, storage.syncCount());
+    }
+
+    {
+        HwaMmap storage(PATH, LESSDB_SIZE, msyncPolicy_t::TIMER, 1);
+        LessDb  db(storage);
+
+        ASSERT_TRUE(db.init());
+        ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+        ASSERT_EQ(1, db.read(TEST_BLOCK_INDEX, 4, 0));
+        ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 0, 2));
+
+        for (int i = 0; (i < 1000) && !storage.syncCount(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ASSERT_GT(storage.syncCount(), 0);
+    }
+
+    std::filesystem::remove(PATH);
+}
+#endif
+
+#ifdef __unix__
+TEST_F(DatabaseTest, ConcurrentAccess)
+{
+    static constexpr size_t BLOCKS     = 4;
+    static constexpr size_t PARAMETERS = 8;
+    static constexpr size_t ITERATIONS = 2000;
+
+    const std::string PATH = (std::filesystem::temp_directory_path() / ("lessdb-concurrent-" + std::to_string(getpid()) + ".bin")).string();
+
+    std::vector<Section> sections = {
+        {
+            PARAMETERS,
+            sectionParameterType_t::WORD,
+            preserveSetting_t::DISABLE,
+            autoIncrementSetting_t::DISABLE,
+            0x0101,
+        },
+
+        {
+            PARAMETERS,
+            sectionParameterType_t::BIT,
+            preserveSetting_t::DISABLE,
+            autoIncrementSetting_t::DISABLE,
+            0,
+        },
+    };
+
+    std::vector<Block> layout(BLOCKS, Block(sections));
+
+    std::filesystem::remove(PATH);
+
+    HwaMmap          storage(PATH, LESSDB_SIZE, msyncPolicy_t::OS);
+    LessDb           db(storage);
+    ConcurrentLessDb concurrentDb(db);
+
+    ASSERT_TRUE(db.init());
+    ASSERT_TRUE(concurrentDb.setLayout(layout));
+    ASSERT_TRUE(concurrentDb.initData());
+
+    std::atomic<size_t>      tornReads = 0;
+    std::atomic<bool>        done      = false;
+    std::vector<std::thread> writers;
+    std::vector<std::thread> readers;
+
+    // each writer owns a block and always writes the same value into both bytes of a word
+    for (size_t block = 0; block < BLOCKS; block++)
+    {
+        writers.emplace_back([&, block]()
+                             {
+                                 for (size_t i = 0; i < ITERATIONS; i++)
+                                 {
+                                     const uint32_t BYTE = (i + block) & 0xFF;
+
+                                     concurrentDb.update(block, 0, i % PARAMETERS, (BYTE << 8) | BYTE);
+                                     concurrentDb.update(block, 1, i % PARAMETERS, i & 0x01);
+                                 }
+                             });
+    }
+
+    for (size_t reader = 0; reader < 4; reader++)
+    {
+        readers.emplace_back([&]()
+                             {
+                                 while (!done)
+                                 {
+                                     for (size_t block = 0; block < BLOCKS; block++)
+                                     {
+                                         for (size_t parameter = 0; parameter < PARAMETERS; parameter++)
+                                         {
+                                             const uint32_t VALUE = concurrentDb.read(block, 0, parameter);
+
+                                             if ((VALUE >> 8) != (VALUE & 0xFF))
+                                             {
+                                                 tornReads++;
+                                             }
+                                         }
+                                     }
+                                 }
+                             });
+    }
+
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+
+    done = true;
+
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    ASSERT_EQ(0, tornReads);
+
+    for (size_t block = 0; block < BLOCKS; block++)
+    {
+        for (size_t parameter = 0; parameter < PARAMETERS; parameter++)
+        {
+            // last iteration which wrote this parameter
+            const size_t   LAST = ITERATIONS - PARAMETERS + parameter;
+            const uint32_t BYTE = (LAST + block) & 0xFF;
+
+            ASSERT_EQ((BYTE << 8) | BYTE, concurrentDb.read(block, 0, parameter));
+            ASSERT_EQ(LAST & 0x01, concurrentDb.read(block, 1, parameter));
+            ASSERT_EQ((BYTE << 8) | BYTE, db.read(block, 0, parameter));
+        }
+    }
+
+    // repeated reads are served from the cache of calling thread
+    concurrentDb.read(TEST_BLOCK_INDEX, 0, 0);
+    const uint32_t HITS = concurrentDb.cacheHits();
+
+    ASSERT_EQ(0x0101 * ((ITERATIONS - PARAMETERS + TEST_BLOCK_INDEX) & 0xFF), concurrentDb.read(TEST_BLOCK_INDEX, 0, 0));
+    ASSERT_EQ(HITS + 1, concurrentDb.cacheHits());
+
+    // update invalidates cached value
+    ASSERT_TRUE(concurrentDb.update(TEST_BLOCK_INDEX, 0, 0, 0x1234));
+    ASSERT_EQ(0x1234, concurrentDb.read(TEST_BLOCK_INDEX, 0, 0));
+    ASSERT_EQ(HITS + 1, concurrentDb.cacheHits());
+
+    const uint32_t SKIPPED = concurrentDb.skippedWrites();
+
+    ASSERT_TRUE(concurrentDb.update(TEST_BLOCK_INDEX, 0, 0, 0x1234));
+    ASSERT_EQ(SKIPPED + 1, concurrentDb.skippedWrites());
+
+    // changes made with exclusive access invalidate caches of all threads
+    ASSERT_TRUE(concurrentDb.exclusive([](LessDb& db)
+                                       {
+                                           return db.update(TEST_BLOCK_INDEX, 0, 0, 0x4321);
+                                       }));
+
+    ASSERT_EQ(0x4321, concurrentDb.read(TEST_BLOCK_INDEX, 0, 0));
+
+    // settings which don't allow concurrent access are reverted after exclusive access
+    concurrentDb.exclusive([](LessDb& db)
+                           {
+                               db.setReadCacheSize(16);
+                               db.setShadow(shadowSetting_t::ENABLE);
+                               db.setWriteCombining(64);
+                           });
+
+    ASSERT_TRUE(concurrentDb.update(TEST_BLOCK_INDEX, 0, 1, 0x5678));
+    ASSERT_EQ(0, db.dirtyBytes());
+    ASSERT_EQ(0, db.combinedBytes());
+    ASSERT_EQ(0x5678, db.read(TEST_BLOCK_INDEX, 0, 1));
+    ASSERT_EQ(0x5678, db.read(TEST_BLOCK_INDEX, 0, 1));
+    ASSERT_EQ(0, db.readCacheHits());
+
+    std::filesystem::remove(PATH);
+}
+#endif
+
+#ifdef __unix__
+TEST_F(DatabaseTest, Snapshot)
+{
+    static constexpr size_t WORD_SECTION = 3;
+    static constexpr size_t ITERATIONS   = 2000;
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 1, 0xDEADBEEF));
+
+    {
+        SnapshotLessDb snapshot(_lessdb, 1000);
+
+        ASSERT_TRUE(snapshot.init());
+
+        // image is loaded from the database
+        ASSERT_EQ(0xDEADBEEF, snapshot.read(TEST_BLOCK_INDEX, 4, 1));
+        ASSERT_EQ(DEFAULT_VALUES[1] + 3, snapshot.read(TEST_BLOCK_INDEX, 1, 3));
+
+        uint32_t value;
+        ASSERT_FALSE(snapshot.read(TEST_BLOCK_INDEX, WORD_SECTION, SECTION_PARAMS[WORD_SECTION], value));
+        ASSERT_FALSE(snapshot.update(TEST_BLOCK_INDEX, WORD_SECTION, SECTION_PARAMS[WORD_SECTION], 0));
+
+        // updates are visible immediately, but written to the database only once flushed
+        _hwa.resetCounters();
+
+        ASSERT_TRUE(snapshot.update(TEST_BLOCK_INDEX, 0, 2, 0));
+        ASSERT_TRUE(snapshot.update(TEST_BLOCK_INDEX, 2, 3, 0x1A));
+        ASSERT_EQ(0, snapshot.read(TEST_BLOCK_INDEX, 0, 2));
+        ASSERT_EQ(0x0A, snapshot.read(TEST_BLOCK_INDEX, 2, 3));
+        ASSERT_EQ(2, snapshot.pendingBytes());
+        ASSERT_EQ(0, _hwa._writeCount);
+
+        ASSERT_TRUE(snapshot.flush());
+        ASSERT_EQ(0, snapshot.pendingBytes());
+    }
+
+    ASSERT_EQ(0, _lessdb.read(TEST_BLOCK_INDEX, 0, 2));
+    ASSERT_EQ(0x0A, _lessdb.read(TEST_BLOCK_INDEX, 2, 3));
+    ASSERT_EQ(DEFAULT_VALUES[0], _lessdb.read(TEST_BLOCK_INDEX, 0, 1));
+
+    {
+        SnapshotLessDb      snapshot(_lessdb, 1);
+        std::atomic<bool>   done         = false;
+        std::atomic<size_t> inconsistent = 0;
+
+        ASSERT_TRUE(snapshot.init());
+
+        // reader must always see all parameters in section updated together
+        std::thread reader([&]()
+                           {
+                               while (!done)
+                               {
+                                   snapshot.readBlock(TEST_BLOCK_INDEX, [&](const SnapshotLessDb::BlockView& view)
+                                                      {
+                                                          const uint32_t FIRST = view.read(WORD_SECTION, 0);
+
+                                                          for (size_t i = 1; i < SECTION_PARAMS[WORD_SECTION]; i++)
+                                                          {
+                                                              if (view.read(WORD_SECTION, i) != FIRST)
+                                                              {
+                                                                  inconsistent++;
+                                                              }
+                                                          }
+                                                      });
+                               }
+                           });
+
+        for (size_t iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            ASSERT_TRUE(snapshot.updateBlock(TEST_BLOCK_INDEX, [&](SnapshotLessDb::BlockWriter& writer)
+                                             {
+                                                 for (size_t i = 0; i < SECTION_PARAMS[WORD_SECTION]; i++)
+                                                 {
+                                                     writer.update(WORD_SECTION, i, iteration);
+                                                 }
+                                             }));
+        }
+
+        done = true;
+        reader.join();
+
+        ASSERT_EQ(0, inconsistent);
+    }
+
+    // remaining changes are written once snapshot is destroyed
+    for (size_t i = 0; i < SECTION_PARAMS[WORD_SECTION]; i++)
+    {
+        ASSERT_EQ(ITERATIONS - 1, _lessdb.read(TEST_BLOCK_INDEX, WORD_SECTION, i));
+    }
+}
+#endif
+
+TEST_F(DatabaseTest, Stats)
+{
+    _lessdb.resetStats();
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 0, 0xDEADBEEF));
+    ASSERT_EQ(0xDEADBEEF, _lessdb.read(TEST_BLOCK_INDEX, 4, 0));
+    ASSERT_EQ(0xDEADBEEF, _lessdb.read(TEST_BLOCK_INDEX, 4, 0));
+
+    uint32_t value;
+    ASSERT_FALSE(_lessdb.read(TEST_BLOCK_INDEX, 0, SECTION_PARAMS[0], value));
+    ASSERT_FALSE(_lessdb.update(TEST_BLOCK_INDEX, 6, 0, 0));
+
+    // stored value differs from the written one
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value ^ 0x01, type);
+    };
+
+    ASSERT_FALSE(_lessdb.update(TEST_BLOCK_INDEX, 1, 0, 0x10));
+
+    Stats stats = _lessdb.stats();
+
+    if constexpr (!StatsCollector::ENABLED)
+    {
+        ASSERT_EQ(0, stats.hwaWrites[static_cast<uint8_t>(sectionParameterType_t::DWORD)]);
+        ASSERT_EQ(0, stats.readLatency.count);
+        ASSERT_TRUE(stats.bytesWritten.empty());
+        return;
+    }
+
+    ASSERT_EQ(1, stats.hwaWrites[static_cast<uint8_t>(sectionParameterType_t::DWORD)]);
+    ASSERT_EQ(1, stats.hwaWrites[static_cast<uint8_t>(sectionParameterType_t::BYTE)]);
+    ASSERT_EQ(0, stats.hwaWrites[static_cast<uint8_t>(sectionParameterType_t::WORD)]);
+    ASSERT_EQ(2, stats.verifyReads);
+    ASSERT_EQ(1, stats.verifyMismatches);
+    ASSERT_EQ(1, stats.cacheHits);
+    ASSERT_EQ(2, stats.rejectedParameters);
+
+    // compare-before-write reads, verification reads and one cache miss
+    ASSERT_EQ(3, stats.hwaReads[static_cast<uint8_t>(sectionParameterType_t::DWORD)]);
+
+    ASSERT_EQ(DB_LAYOUT.size(), stats.bytesWritten.size());
+    ASSERT_EQ(SECTION_PARAMS.size(), stats.bytesWritten[TEST_BLOCK_INDEX].size());
+    ASSERT_EQ(4, stats.bytesWritten[TEST_BLOCK_INDEX][4]);
+    ASSERT_EQ(1, stats.bytesWritten[TEST_BLOCK_INDEX][1]);
+    ASSERT_EQ(0, stats.bytesWritten[TEST_BLOCK_INDEX][0]);
+
+    ASSERT_EQ(3, stats.readLatency.count);
+    ASSERT_EQ(3, stats.updateLatency.count);
+    ASSERT_EQ(0, stats.initDataLatency.count);
+
+    uint32_t total = 0;
+
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; i++)
+    {
+        total += stats.readLatency.buckets[i];
+    }
+
+    ASSERT_EQ(3, total);
+
+    // range writes are attributed to all sections they span
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    _hwa._rangeAccess = true;
+    _lessdb.resetStats();
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+
+    stats = _lessdb.stats();
+
+    ASSERT_EQ(1, stats.initDataLatency.count);
+    ASSERT_EQ(0, stats.hwaWrites[static_cast<uint8_t>(sectionParameterType_t::BYTE)]);
+    ASSERT_GT(stats.hwaRangeWrites, 0);
+
+    for (size_t block = 0; block < DB_LAYOUT.size(); block++)
+    {
+        for (size_t section = 0; section < stats.bytesWritten[block].size(); section++)
+        {
+            ASSERT_GT(stats.bytesWritten[block][section], 0);
+        }
+    }
+
+    ASSERT_EQ(SECTION_PARAMS[4] * 4, stats.bytesWritten[TEST_BLOCK_INDEX][4]);
+}
+
+TEST_F(DatabaseTest, TraceReplay)
+{
+    MemoryTraceOutput output;
+    HwaTrace          trace(_hwa, output);
+    LessDb            db(trace);
+
+    ASSERT_TRUE(db.init());
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+    ASSERT_TRUE(db.initData(factoryResetType_t::FULL));
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 3, 0, 0x1234));
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 1, 0x12345678));
+    ASSERT_EQ(0x1234, db.read(TEST_BLOCK_INDEX, 3, 0));
+    ASSERT_EQ(DEFAULT_VALUES[5], db.read(TEST_BLOCK_INDEX, 5, 2));
+
+    // failed accesses are traced as well
+    _hwa._writeCallback = [](uint32_t, uint32_t, sectionParameterType_t)
+    {
+        return false;
+    };
+
+    ASSERT_FALSE(db.update(TEST_BLOCK_INDEX, 4, 0, 0));
+
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 4, 0, 0x11));
+
+    // range accesses carry written data
+    _hwa._rangeAccess = true;
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 1, 2, 0x55));
+    ASSERT_TRUE(db.initData(factoryResetType_t::PARTIAL));
+
+    uint32_t storageSize;
+
+    ASSERT_TRUE(TraceReplay::storageSize(output._data.data(), output._data.size(), storageSize));
+    ASSERT_EQ(LESSDB_SIZE, storageSize);
+    ASSERT_GT(trace.records(), 0);
+
+    // replaying on another backend results in the same stored data
+    RamFlashPages pages(512, 8);
+    HwaFlash      flash(pages, storageSize);
+    ReplayResult  result;
+
+    ASSERT_TRUE(TraceReplay::replay(output._data.data(), output._data.size(), flash, result));
+
+    uint32_t operations = 0;
+
+    for (size_t i = 0; i < static_cast<size_t>(traceOperation_t::AMOUNT); i++)
+    {
+        operations += result.operations[i];
+    }
+
+    ASSERT_EQ(trace.records(), operations);
+    ASSERT_EQ(1, result.operations[static_cast<uint8_t>(traceOperation_t::INIT)]);
+    ASSERT_GT(result.operations[static_cast<uint8_t>(traceOperation_t::WRITE)], 0);
+    ASSERT_GT(result.operations[static_cast<uint8_t>(traceOperation_t::WRITE_RANGE)], 0);
+    ASSERT_GT(result.bytesWritten, 0);
+
+    // flash accepts the write which failed while tracing,
+    // so the next read of that parameter returns different value
+    ASSERT_EQ(1, result.failures);
+    ASSERT_EQ(1, result.mismatches);
+
+    LessDb replayed(flash);
+
+    ASSERT_TRUE(replayed.setLayout(DB_LAYOUT));
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+        {
+            ASSERT_EQ(db.read(TEST_BLOCK_INDEX, section, i), replayed.read(TEST_BLOCK_INDEX, section, i));
+        }
+    }
+
+    // truncated trace is rejected
+    ASSERT_FALSE(TraceReplay::replay(output._data.data(), HwaTrace::HEADER_SIZE - 1, flash, result));
+
+    // ranges outside of the traced storage are rejected before anything is allocated or written
+    for (auto operation : { traceOperation_t::READ_RANGE, traceOperation_t::WRITE_RANGE })
+    {
+        std::vector<uint8_t> malformed(output._data.begin(), output._data.begin() + HwaTrace::HEADER_SIZE);
+
+        malformed.insert(malformed.end(), { static_cast<uint8_t>(operation), 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F });
+        ASSERT_FALSE(TraceReplay::replay(malformed.data(), malformed.size(), flash, result));
+
+        malformed.resize(HwaTrace::HEADER_SIZE);
+        malformed.insert(malformed.end(), { static_cast<uint8_t>(operation), 0x00, 0x80, 0x80, 0x04, 0x01, 0x00 });
+        ASSERT_FALSE(TraceReplay::replay(malformed.data(), malformed.size(), flash, result));
+    }
+}
+
+TEST_F(DatabaseTest, LayoutHeader)
+{
+    const uint32_t HEADER_ADDRESS = _lessdb.nextParameterAddress();
+
+    ASSERT_EQ(layoutStatus_t::UNKNOWN, _lessdb.layoutStatus());
+    ASSERT_NE(0, _lessdb.layoutHash());
+
+    // header can't overlap the database or exceed the memory
+    ASSERT_FALSE(_lessdb.setHeader(headerSetting_t::ENABLE, HEADER_ADDRESS - 1));
+    ASSERT_FALSE(_lessdb.setHeader(headerSetting_t::ENABLE, LESSDB_SIZE - 11));
+
+    // database has been initialized before the header was enabled
+    ASSERT_TRUE(_lessdb.setHeader(headerSetting_t::ENABLE, HEADER_ADDRESS));
+    ASSERT_EQ(layoutStatus_t::NEEDS_INIT, _lessdb.layoutStatus());
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::PARTIAL));
+    ASSERT_EQ(layoutStatus_t::VALID, _lessdb.layoutStatus());
+
+    // unchanged layout is validated with single read and no writes
+    LessDb db(_hwa);
+
+    _hwa._rangeAccess = true;
+    _hwa.resetCounters();
+
+    ASSERT_TRUE(db.setHeader(headerSetting_t::ENABLE, HEADER_ADDRESS));
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+    ASSERT_EQ(layoutStatus_t::VALID, db.layoutStatus());
+    ASSERT_EQ(_lessdb.layoutHash(), db.layoutHash());
+    ASSERT_EQ(1, _hwa._readRangeCount);
+    ASSERT_EQ(0, _hwa._readCount);
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._writeRangeCount);
+
+    // swapped parameter counts don't change layout UID, but change the hash
+    std::vector<Section> sectionsA = {
+        { 10, sectionParameterType_t::BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0 },
+        { 20, sectionParameterType_t::WORD, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0 },
+    };
+
+    std::vector<Section> sectionsB = {
+        { 20, sectionParameterType_t::BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0 },
+        { 10, sectionParameterType_t::WORD, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0 },
+    };
+
+    std::vector<Section> sectionsC = {
+        { 10, sectionParameterType_t::BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 1 },
+        { 20, sectionParameterType_t::WORD, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0 },
+    };
+
+    std::vector<Block> layoutA = { Block(sectionsA) };
+    std::vector<Block> layoutB = { Block(sectionsB) };
+    std::vector<Block> layoutC = { Block(sectionsC) };
+
+    ASSERT_EQ(LessDb::layoutUid(layoutA), LessDb::layoutUid(layoutB));
+
+    ASSERT_TRUE(db.setLayout(layoutA));
+    ASSERT_EQ(layoutStatus_t::NEEDS_MIGRATION, db.layoutStatus());
+    ASSERT_TRUE(db.initData());
+    ASSERT_EQ(layoutStatus_t::VALID, db.layoutStatus());
+
+    const uint32_t HASH = db.layoutHash();
+
+    ASSERT_TRUE(db.setLayout(layoutB));
+    ASSERT_EQ(layoutStatus_t::NEEDS_MIGRATION, db.layoutStatus());
+    ASSERT_NE(HASH, db.layoutHash());
+
+    // different default value or start address
+    ASSERT_TRUE(db.setLayout(layoutC));
+    ASSERT_EQ(layoutStatus_t::NEEDS_MIGRATION, db.layoutStatus());
+    ASSERT_TRUE(db.setLayout(layoutA, 1));
+    ASSERT_EQ(layoutStatus_t::NEEDS_MIGRATION, db.layoutStatus());
+
+    // migrated data is marked as valid without initialization
+    ASSERT_TRUE(db.setLayout(layoutB));
+    ASSERT_TRUE(db.writeHeader());
+    ASSERT_TRUE(db.setLayout(layoutB));
+    ASSERT_EQ(layoutStatus_t::VALID, db.layoutStatus());
+
+    // different header format
+    ASSERT_TRUE(_hwa.write(HEADER_ADDRESS + 4, 2, sectionParameterType_t::DWORD));
+    ASSERT_TRUE(db.setLayout(layoutB));
+    ASSERT_EQ(layoutStatus_t::NEEDS_MIGRATION, db.layoutStatus());
+
+    ASSERT_TRUE(db.clear());
+    ASSERT_EQ(layoutStatus_t::NEEDS_INIT, db.layoutStatus());
+
+    // layout can't overlap the header
+    ASSERT_FALSE(db.setLayout(layoutB, HEADER_ADDRESS - 1));
+
+    ASSERT_TRUE(db.setHeader(headerSetting_t::DISABLE));
+    ASSERT_TRUE(db.setLayout(layoutB));
+    ASSERT_EQ(layoutStatus_t::UNKNOWN, db.layoutStatus());
+    ASSERT_FALSE(db.writeHeader());
+}
+
+TEST_F(DatabaseTest, LazyReset)
+{
+    const uint32_t MAP_ADDRESS = _lessdb.nextParameterAddress();
+
+    // map can't overlap the database
+    ASSERT_FALSE(_lessdb.setLazyReset(lazyResetSetting_t::ENABLE, MAP_ADDRESS - 1));
+    ASSERT_TRUE(_lessdb.setLazyReset(lazyResetSetting_t::ENABLE, MAP_ADDRESS));
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 0, 0x12345678));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 2, 1, 0x03));
+
+    // factory reset only writes the map
+    _hwa._rangeAccess = true;
+    _hwa.resetCounters();
+
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_EQ(1, _hwa._writeRangeCount);
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_TRUE(_lessdb.sectionDefaulted(TEST_BLOCK_INDEX, 4));
+    ASSERT_FALSE(_lessdb.sectionDefaulted(TEST_BLOCK_INDEX, SECTION_PARAMS.size()));
+
+    // defaults are returned without accessing the storage
+    _hwa.resetCounters();
+
+    for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+    {
+        for (size_t i = 0; i < SECTION_PARAMS[section]; i++)
+        {
+            ASSERT_EQ(DEFAULT_VALUES[section] + (section == 1 ? i : 0), _lessdb.read(TEST_BLOCK_INDEX, section, i));
+        }
+    }
+
+    uint32_t values[SECTION_PARAMS[4]] = {};
+
+    ASSERT_TRUE(_lessdb.readSection(TEST_BLOCK_INDEX, 4, values, SECTION_PARAMS[4]));
+    ASSERT_EQ(DEFAULT_VALUES[4], values[0]);
+    ASSERT_EQ(0, _hwa._readCount);
+
+    // stored data hasn't been touched
+    LessDb raw(_hwa);
+
+    ASSERT_TRUE(raw.setReadCacheSize(0));
+    ASSERT_TRUE(raw.setLayout(DB_LAYOUT));
+    ASSERT_EQ(0x12345678, raw.read(TEST_BLOCK_INDEX, 4, 0));
+
+    // updating the parameter to its default value keeps the section at defaults
+    _hwa.resetCounters();
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 0, DEFAULT_VALUES[4]));
+    ASSERT_TRUE(_lessdb.sectionDefaulted(TEST_BLOCK_INDEX, 4));
+    ASSERT_EQ(0, _hwa._writeCount + _hwa._writeRangeCount);
+
+    // first update writes the defaults to the section
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 1, 0x55));
+    ASSERT_FALSE(_lessdb.sectionDefaulted(TEST_BLOCK_INDEX, 4));
+    ASSERT_EQ(0x55, _lessdb.read(TEST_BLOCK_INDEX, 4, 1));
+    ASSERT_EQ(DEFAULT_VALUES[4], _lessdb.read(TEST_BLOCK_INDEX, 4, 0));
+    ASSERT_EQ(DEFAULT_VALUES[4], raw.read(TEST_BLOCK_INDEX, 4, 0));
+
+    // range update of half-byte section
+    const uint32_t HALF_BYTES[3] = { 1, 2, 3 };
+
+    ASSERT_TRUE(_lessdb.updateRange(TEST_BLOCK_INDEX, 2, 1, 3, HALF_BYTES));
+    ASSERT_FALSE(_lessdb.sectionDefaulted(TEST_BLOCK_INDEX, 2));
+    ASSERT_EQ(DEFAULT_VALUES[2], raw.read(TEST_BLOCK_INDEX, 2, 0));
+    ASSERT_EQ(3, raw.read(TEST_BLOCK_INDEX, 2, 3));
+    ASSERT_EQ(DEFAULT_VALUES[2], raw.read(TEST_BLOCK_INDEX, 2, 4));
+
+    // map is persisted
+    LessDb db(_hwa);
+
+    ASSERT_TRUE(db.setLazyReset(lazyResetSetting_t::ENABLE, MAP_ADDRESS));
+    ASSERT_TRUE(db.setLayout(DB_LAYOUT));
+    ASSERT_FALSE(db.sectionDefaulted(TEST_BLOCK_INDEX, 4));
+    ASSERT_TRUE(db.sectionDefaulted(TEST_BLOCK_INDEX, 5));
+    ASSERT_EQ(0x55, db.read(TEST_BLOCK_INDEX, 4, 1));
+
+    // defaults aren't part of the transaction
+    ASSERT_TRUE(db.beginTransaction());
+    ASSERT_TRUE(db.update(TEST_BLOCK_INDEX, 3, 0, 0x1234));
+    db.rollback();
+    ASSERT_FALSE(db.sectionDefaulted(TEST_BLOCK_INDEX, 3));
+    ASSERT_EQ(DEFAULT_VALUES[3], db.read(TEST_BLOCK_INDEX, 3, 0));
+
+    // disabling lazy reset writes defaults to all remaining sections
+    ASSERT_TRUE(db.setLazyReset(lazyResetSetting_t::DISABLE));
+    ASSERT_FALSE(db.sectionDefaulted(TEST_BLOCK_INDEX, 5));
+    ASSERT_EQ(DEFAULT_VALUES[5], raw.read(TEST_BLOCK_INDEX, 5, 0));
+
+    // with RAM shadow, defaults are stored before the section is unmarked
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    ASSERT_TRUE(_lessdb.initData(factoryResetType_t::FULL));
+    ASSERT_EQ(DEFAULT_VALUES[4], _lessdb.read(TEST_BLOCK_INDEX, 4, 1));
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 4, 2, 0x66));
+    ASSERT_EQ(DEFAULT_VALUES[4], raw.read(TEST_BLOCK_INDEX, 4, 1));
+    ASSERT_EQ(0x66, _lessdb.read(TEST_BLOCK_INDEX, 4, 2));
+
+    ASSERT_TRUE(_lessdb.clear());
+    ASSERT_FALSE(_lessdb.sectionDefaulted(TEST_BLOCK_INDEX, 5));
+}
+
+#ifdef __unix__
+TEST_F(DatabaseTest, ParallelInit)
+{
+    static constexpr uint32_t STORAGE_SIZE = 300000;
+    static constexpr size_t   WORKERS      = 4;
+
+    const std::string PATH = (std::filesystem::temp_directory_path() / ("lessdb-parallel-" + std::to_string(getpid()) + ".bin")).string();
+
+    std::vector<Section> sections = {
+        { 200000, sectionParameterType_t::BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::ENABLE, 0 },
+        { 10000, sectionParameterType_t::WORD, preserveSetting_t::ENABLE, autoIncrementSetting_t::DISABLE, 0x1234 },
+        { 1000, sectionParameterType_t::BIT, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 1 },
+        { 1001, sectionParameterType_t::HALF_BYTE, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0x0A },
+    };
+
+    std::vector<Block> layout = { Block(sections) };
+
+    std::filesystem::remove(PATH);
+
+    {
+        HwaMmap      storage(PATH, STORAGE_SIZE, msyncPolicy_t::OS);
+        LessDb       db(storage);
+        ParallelInit parallelInit(db, WORKERS);
+
+        ASSERT_TRUE(storage.concurrentAccessSupported());
+        ASSERT_TRUE(db.init());
+        ASSERT_TRUE(db.setLayout(layout));
+        ASSERT_TRUE(parallelInit.initData());
+
+        auto verify = [&](uint32_t wordValue)
+        {
+            for (size_t i = 0; i < 200000; i += 997)
+            {
+                ASSERT_EQ(i & 0xFF, db.read(0, 0, i));
+            }
+
+            ASSERT_EQ(199999 & 0xFF, db.read(0, 0, 199999));
+            ASSERT_EQ(wordValue, db.read(0, 1, 9999));
+            ASSERT_EQ(1, db.read(0, 2, 999));
+            ASSERT_EQ(0x0A, db.read(0, 3, 1000));
+        };
+
+        verify(0x1234);
+
+        // work is spread across all workers
+        uint64_t bytes = 0;
+
+        ASSERT_EQ(WORKERS, parallelInit.report().size());
+
+        for (const auto& report : parallelInit.report())
+        {
+            bytes += report.bytes;
+        }
+
+        ASSERT_EQ(db.currentDatabaseSize(), bytes);
+
+        // partial initialization skips preserved sections
+        ASSERT_TRUE(db.update(0, 0, 5, 0x77));
+        ASSERT_TRUE(db.update(0, 1, 9999, 0x4321));
+        ASSERT_TRUE(parallelInit.initData(factoryResetType_t::PARTIAL));
+        verify(0x4321);
+
+        // filled values replace cached ones
+        ASSERT_EQ(0x1234, db.read(0, 1, 5));
+        ASSERT_TRUE(parallelInit.fillSection(0, 1, 0xBEEF));
+
+        for (size_t i = 0; i < 10000; i++)
+        {
+            ASSERT_EQ(0xBEEF, db.read(0, 1, i));
+        }
+
+        ASSERT_TRUE(parallelInit.fillSection(0, 2, 0));
+        ASSERT_EQ(0, db.read(0, 2, 999));
+        ASSERT_FALSE(parallelInit.fillSection(0, 4, 0));
+    }
+
+    std::filesystem::remove(PATH);
+
+    // storage which doesn't support concurrent access is initialized by the database itself
+    ParallelInit parallelInit(_lessdb, WORKERS);
+
+    ASSERT_TRUE(_lessdb.update(TEST_BLOCK_INDEX, 0, 0, 0));
+    ASSERT_TRUE(parallelInit.initData());
+    ASSERT_EQ(DEFAULT_VALUES[0], _lessdb.read(TEST_BLOCK_INDEX, 0, 0));
+    ASSERT_EQ(1, parallelInit.report().size());
+    ASSERT_EQ(_lessdb.currentDatabaseSize(), parallelInit.report()[0].bytes);
+
+    ASSERT_TRUE(parallelInit.fillSection(TEST_BLOCK_INDEX, 4, 7));
+    ASSERT_EQ(7, _lessdb.read(TEST_BLOCK_INDEX, 4, SECTION_PARAMS[4] - 1));
+}
+#endif
+
+#ifdef __unix__
+TEST_F(DatabaseTest, AsyncAccess)
+{
+    AsyncLessDb::Result result;
+
+    {
+        // storage used in tests can't be accessed concurrently
+        AsyncLessDb async(_lessdb, 4);
+
+        ASSERT_EQ(1, async.workers());
+
+        auto ticket = async.submitUpdate(0, 5, 0, 0x55);
+
+        ASSERT_NE(AsyncLessDb::INVALID_TICKET, ticket);
+        ASSERT_TRUE(async.wait(ticket, result));
+        ASSERT_TRUE(result.success);
+        ASSERT_EQ(0x55, result.value);
+
+        // result can be retrieved only once
+        ASSERT_FALSE(async.wait(ticket, result));
+        ASSERT_FALSE(async.poll(ticket, result));
+
+        ticket = async.submitRead(0, 5, 0);
+        async.drain();
+        ASSERT_EQ(0, async.pending());
+        ASSERT_TRUE(async.poll(ticket, result));
+        ASSERT_TRUE(result.success);
+        ASSERT_EQ(0x55, result.value);
+
+        // invalid parameter
+        ticket = async.submitRead(0, 5, SECTION_PARAMS[5]);
+        ASSERT_TRUE(async.wait(ticket, result));
+        ASSERT_FALSE(result.success);
+
+        // results of operations with callback are delivered only to the callback
+        std::atomic<uint32_t> readValue = 0;
+
+        ticket = async.submitRead(0, 3, 0, [&](AsyncLessDb::ticket_t, const AsyncLessDb::Result& result)
+                                  {
+                                      if (result.success)
+                                      {
+                                          readValue = result.value;
+                                      }
+                                  });
+
+        async.drain();
+        ASSERT_EQ(DEFAULT_VALUES[3], readValue);
+        ASSERT_FALSE(async.poll(ticket, result));
+
+        // hold the worker in the first write so that following operations end up in the same batch
+        std::atomic<bool> blocked  = false;
+        std::atomic<bool> released = false;
+
+        _hwa._writeCallback = [&](uint32_t address, uint32_t value, sectionParameterType_t type)
+        {
+            blocked = true;
+
+            while (!released)
+            {
+                std::this_thread::yield();
+            }
+
+            return _hwa.memoryWrite(address, value, type);
+        };
+
+        async.submitUpdate(0, 5, 1, 1);
+
+        while (!blocked)
+        {
+            std::this_thread::yield();
+        }
+
+        std::vector<AsyncLessDb::ticket_t> tickets = {
+            async.submitUpdate(0, 5, 2, 2),
+            async.submitUpdate(0, 5, 2, 3),
+            async.submitUpdate(0, 5, 2, 4),
+            async.submitRead(0, 5, 2),
+            async.submitUpdate(0, 5, 2, 5),
+            async.submitUpdate(0, 5, 2, 6),
+        };
+
+        _hwa.resetCounters();
+        released = true;
+        async.drain();
+
+        // updates to 2, 3 and 5 are overwritten before anyone reads them
+        ASSERT_EQ(3, async.coalescedUpdates());
+
+        const std::vector<uint32_t> EXPECTED = { 2, 3, 4, 4, 5, 6 };
+
+        for (size_t i = 0; i < tickets.size(); i++)
+        {
+            ASSERT_TRUE(async.poll(tickets[i], result));
+            ASSERT_TRUE(result.success);
+            ASSERT_EQ(EXPECTED[i], result.value);
+        }
+
+        ASSERT_EQ(6, _lessdb.read(0, 5, 2));
+
+        // skipped updates complete in the order in which they were submitted as well
+        std::vector<AsyncLessDb::ticket_t> completed;
+
+        auto record = [&](AsyncLessDb::ticket_t ticket, const AsyncLessDb::Result&)
+        {
+            completed.push_back(ticket);
+        };
+
+        blocked  = false;
+        released = false;
+
+        async.submitUpdate(0, 5, 1, 2);
+
+        while (!blocked)
+        {
+            std::this_thread::yield();
+        }
+
+        tickets = {
+            async.submitUpdate(0, 5, 3, 1, record),
+            async.submitRead(0, 5, 4, record),
+            async.submitUpdate(0, 5, 3, 2, record),
+            async.submitUpdate(0, 5, 4, 3, record),
+        };
+
+        released = true;
+        async.drain();
+
+        ASSERT_EQ(4, async.coalescedUpdates());
+        ASSERT_EQ(tickets, completed);
+        ASSERT_EQ(2, _lessdb.read(0, 5, 3));
+    }
+
+    // multiple workers
+    static constexpr size_t   BLOCKS       = 4;
+    static constexpr size_t   PARAMETERS   = 500;
+    static constexpr uint32_t STORAGE_SIZE = BLOCKS * PARAMETERS * 2;
+
+    const std::string PATH = (std::filesystem::temp_directory_path() / ("lessdb-async-" + std::to_string(getpid()) + ".bin")).string();
+
+    std::vector<Section> sections = {
+        { PARAMETERS, sectionParameterType_t::WORD, preserveSetting_t::DISABLE, autoIncrementSetting_t::DISABLE, 0 },
+    };
+
+    std::vector<Block> layout(BLOCKS, Block(sections));
+
+    std::filesystem::remove(PATH);
+
+    {
+        HwaMmap storage(PATH, STORAGE_SIZE, msyncPolicy_t::OS);
+        LessDb  db(storage);
+
+        ASSERT_TRUE(db.init());
+        ASSERT_TRUE(db.setLayout(layout));
+        ASSERT_TRUE(db.initData());
+
+        AsyncLessDb           async(db, BLOCKS);
+        std::atomic<uint32_t> failed = 0;
+
+        ASSERT_EQ(BLOCKS, async.workers());
+
+        for (size_t parameter = 0; parameter < PARAMETERS; parameter++)
+        {
+            for (size_t block = 0; block < BLOCKS; block++)
+            {
+                async.submitUpdate(block, 0, parameter, block * 1000 + parameter, [&](AsyncLessDb::ticket_t, const AsyncLessDb::Result& result)
+                                   {
+                                       failed += !result.success;
+                                   });
+            }
+        }
+
+        async.drain();
+        ASSERT_EQ(0, failed);
+
+        for (size_t block = 0; block < BLOCKS; block++)
+        {
+            for (size_t parameter = 0; parameter < PARAMETERS; parameter += 7)
+            {
+                auto ticket = async.submitRead(block, 0, parameter);
+
+                ASSERT_TRUE(async.wait(ticket, result));
+                ASSERT_EQ(block * 1000 + parameter, result.value);
+            }
+        }
+    }
+
+    std::filesystem::remove(PATH);
+}
+#endif
+
+TEST_F(DatabaseTest, InitDataSteps)
+{
+    static constexpr uint32_t STEP_SIZE = 100;
+
+    // not started
+    ASSERT_EQ(initStatus_t::FAILED, _lessdb.continueInitData(STEP_SIZE));
+
+    for (auto policy : { verifyPolicy_t::ALWAYS, verifyPolicy_t::DEFERRED })
+    {
+        ASSERT_TRUE(_lessdb.setVerifyPolicy(policy));
+
+        for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+        {
+            ASSERT_TRUE(_lessdb.update(0, section, 1, 0));
+        }
+
+        ASSERT_TRUE(_lessdb.startInitData());
+        _hwa.resetCounters();
+
+        size_t       steps  = 0;
+        initStatus_t status = initStatus_t::IN_PROGRESS;
+
+        while (status == initStatus_t::IN_PROGRESS)
+        {
+            const size_t WRITES = _hwa._writeCount;
+
+            status = _lessdb.continueInitData(STEP_SIZE);
+            steps++;
+
+            // storage without range access is written one byte at a time
+            ASSERT_LE(_hwa._writeCount - WRITES, STEP_SIZE);
+        }
+
+        ASSERT_EQ(initStatus_t::DONE, status);
+        ASSERT_GE(steps, _lessdb.currentDatabaseSize() / STEP_SIZE);
+        ASSERT_EQ(initStatus_t::FAILED, _lessdb.continueInitData(STEP_SIZE));
+
+        for (size_t section = 0; section < SECTION_PARAMS.size(); section++)
+        {
+            ASSERT_EQ(section == 1 ? DEFAULT_VALUES[1] + 1 : DEFAULT_VALUES[section], _lessdb.read(0, section, 1));
+        }
+    }
+
+    // partial initialization in steps skips preserved sections
+    ASSERT_TRUE(_lessdb.update(0, 0, 0, 0));
+    ASSERT_TRUE(_lessdb.update(0, 5, 0, 0x12));
+    ASSERT_TRUE(_lessdb.startInitData(factoryResetType_t::PARTIAL));
+
+    while (_lessdb.continueInitData(1) == initStatus_t::IN_PROGRESS)
+    {
+    }
+
+    ASSERT_EQ(DEFAULT_VALUES[0], _lessdb.read(0, 0, 0));
+    ASSERT_EQ(0x12, _lessdb.read(0, 5, 0));
+
+    // layout change cancels initialization
+    ASSERT_TRUE(_lessdb.startInitData());
+    ASSERT_EQ(initStatus_t::IN_PROGRESS, _lessdb.continueInitData(STEP_SIZE));
+    ASSERT_TRUE(_lessdb.setLayout(DB_LAYOUT));
+    ASSERT_EQ(initStatus_t::FAILED, _lessdb.continueInitData(STEP_SIZE));
+}
+
+TEST_F(DatabaseTest, Coroutines)
+{
+    Executor executor;
+    CoLessDb db(_lessdb, executor, 16);
+    bool     initDone = false;
+    uint32_t turns    = 0;
+
+    executor.spawn([](CoLessDb& db, const std::vector<uint16_t>& defaults, bool& initDone) -> Task<void>
+                   {
+                       EXPECT_TRUE(co_await db.update(0, 5, 0, 0x12));
+
+                       auto value = co_await db.read(0, 5, 0);
+
+                       EXPECT_TRUE(value.has_value());
+                       EXPECT_EQ(0x12, value.value_or(0));
+
+                       // invalid parameter
+                       EXPECT_FALSE((co_await db.read(0, 5, 1000)).has_value());
+
+                       EXPECT_TRUE(co_await db.initData());
+
+                       uint32_t values[10] = {};
+
+                       EXPECT_TRUE(co_await db.readSection(0, 5, values, 10));
+
+                       for (auto value : values)
+                       {
+                           EXPECT_EQ(defaults[5], value);
+                       }
+
+                       initDone = true;
+                   }(db, DEFAULT_VALUES, initDone));
+
+    // counts the turns it gets while the database is being initialized
+    executor.spawn([](Executor& executor, bool& initDone, uint32_t& turns) -> Task<void>
+                   {
+                       while (!initDone)
+                       {
+                           turns++;
+                           co_await executor.yield();
+                       }
+                   }(executor, initDone, turns));
+
+    ASSERT_EQ(2, executor.active());
+    executor.run();
+
+    ASSERT_TRUE(initDone);
+    ASSERT_EQ(0, executor.active());
+
+    // initialization doesn't run in one go
+    ASSERT_GT(turns, _lessdb.currentDatabaseSize() / 16);
+    ASSERT_EQ(DEFAULT_VALUES[5], _lessdb.read(0, 5, 0));
+
+    // operations started during initialization wait until it's done
+    executor.spawn([](CoLessDb& db) -> Task<void>
+                   {
+                       EXPECT_TRUE(co_await db.initData());
+                   }(db));
+
+    executor.spawn([](CoLessDb& db, LessDb& lessdb) -> Task<void>
+                   {
+                       EXPECT_TRUE(co_await db.update(0, 5, 9, 0x33));
+                       EXPECT_FALSE(lessdb.initInProgress());
+                       EXPECT_EQ(0x33, (co_await db.read(0, 5, 9)).value_or(0));
+
+                       uint32_t values[10] = {};
+
+                       EXPECT_TRUE(co_await db.readSection(0, 5, values, 10));
+                       EXPECT_EQ(0x33, values[9]);
+                   }(db, _lessdb));
+
+    executor.run();
+
+    ASSERT_EQ(0, executor.active());
+    ASSERT_EQ(0x33, _lessdb.read(0, 5, 9));
+}
+
+TEST_F(DatabaseTest, WriteCombining)
+{
+    _hwa._rangeAccess = true;
+
+    ASSERT_TRUE(_lessdb.setWriteCombining(64));
+    _hwa.resetCounters();
+
+    // repeated and out of order updates, bits merged into the same byte
+    ASSERT_TRUE(_lessdb.update(0, 5, 3, 3));
+    ASSERT_TRUE(_lessdb.update(0, 5, 1, 1));
+    ASSERT_TRUE(_lessdb.update(0, 5, 2, 0x22));
+    ASSERT_TRUE(_lessdb.update(0, 5, 0, 0));
+    ASSERT_TRUE(_lessdb.update(0, 5, 2, 2));
+
+    for (size_t i = 0; i < SECTION_PARAMS[0]; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(0, 0, i, i % 2));
+    }
+
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_EQ(0, _hwa._writeRangeCount);
+    ASSERT_EQ(5, _lessdb.combinedBytes());
+
+    // held values are visible before they're written
+    for (size_t i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(i, _lessdb.read(0, 5, i));
+    }
+
+    for (size_t i = 0; i < SECTION_PARAMS[0]; i++)
+    {
+        ASSERT_EQ(i % 2, _lessdb.read(0, 0, i));
+    }
+
+    uint32_t values[10] = {};
+
+    ASSERT_TRUE(_lessdb.readSection(0, 5, values, 10));
+    ASSERT_EQ(2, values[2]);
+    ASSERT_EQ(DEFAULT_VALUES[5], values[4]);
+
+    // single byte of bit section and one range of four bytes
+    ASSERT_TRUE(_lessdb.flush());
+    ASSERT_EQ(0, _lessdb.combinedBytes());
+    ASSERT_EQ(1, _hwa._writeCount);
+    ASSERT_EQ(1, _hwa._writeRangeCount);
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(i, _lessdb.read(0, 5, i));
+    }
+
+    // size limit
+    ASSERT_TRUE(_lessdb.setWriteCombining(4));
+    _hwa.resetCounters();
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(0, 5, i + 5, 0x50 + i));
+    }
+
+    ASSERT_EQ(3, _lessdb.combinedBytes());
+    ASSERT_TRUE(_lessdb.update(0, 5, 9, 0x59));
+    ASSERT_EQ(0, _lessdb.combinedBytes());
+    ASSERT_EQ(2, _hwa._writeCount + _hwa._writeRangeCount);
+
+    // deadline, with time wrapping around while bytes are held
+    _hwa._milliseconds = 0xFFFFFFF0;
+
+    ASSERT_TRUE(_lessdb.setWriteCombining(64, 200));
+    ASSERT_TRUE(_lessdb.update(0, 3, 0, 0x1234));
+    ASSERT_EQ(2, _lessdb.combinedBytes());
+    ASSERT_TRUE(_lessdb.flushIfExpired());
+    ASSERT_EQ(2, _lessdb.combinedBytes());
+
+    _hwa._milliseconds += 199;
+
+    ASSERT_TRUE(_lessdb.flushIfExpired());
+    ASSERT_EQ(2, _lessdb.combinedBytes());
+
+    _hwa._milliseconds += 1;
+
+    ASSERT_TRUE(_lessdb.flushIfExpired());
+    ASSERT_EQ(0, _lessdb.combinedBytes());
+
+    // deadline is checked on write as well
+    ASSERT_TRUE(_lessdb.update(0, 3, 1, 0x5678));
+    ASSERT_EQ(2, _lessdb.combinedBytes());
+
+    _hwa._milliseconds += 200;
+
+    ASSERT_TRUE(_lessdb.update(0, 3, 2, 0x9ABC));
+    ASSERT_EQ(0, _lessdb.combinedBytes());
+    ASSERT_EQ(0x5678, _lessdb.read(0, 3, 1));
+    ASSERT_EQ(0x9ABC, _lessdb.read(0, 3, 2));
+
+    // deferred verification, disabling flushes held bytes
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::DEFERRED));
+    ASSERT_TRUE(_lessdb.update(0, 4, 1, 0x12345678));
+    ASSERT_EQ(4, _lessdb.combinedBytes());
+    ASSERT_TRUE(_lessdb.setWriteCombining(0));
+    ASSERT_EQ(0, _lessdb.combinedBytes());
+    ASSERT_EQ(0x12345678, _lessdb.read(0, 4, 1));
+
+    // initialization with deferred verification writes held bytes before verifying
+    ASSERT_TRUE(_lessdb.setWriteCombining(16));
+    ASSERT_TRUE(_lessdb.initData());
+    ASSERT_EQ(0, _lessdb.combinedBytes());
+    ASSERT_EQ(DEFAULT_VALUES[4], _lessdb.read(0, 4, 1));
+
+    // held section isn't read back before it's written
+    std::vector<uint32_t> section(SECTION_PARAMS[5], 0x5A);
+    ASSERT_TRUE(_lessdb.updateSection(0, 5, section.data(), section.size()));
+    ASSERT_EQ(SECTION_PARAMS[5], _lessdb.combinedBytes());
+    ASSERT_TRUE(_lessdb.flush());
+    ASSERT_TRUE(_lessdb.verify());
+    ASSERT_EQ(0x5A, _lessdb.read(0, 5, SECTION_PARAMS[5] - 1));
+
+    // failed write keeps held bytes
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::ALWAYS));
+    ASSERT_TRUE(_lessdb.update(0, 5, 0, 0x77));
+    _hwa._rangeAccess   = false;
+    _hwa._writeCallback = [](uint32_t, uint32_t, sectionParameterType_t)
+    {
+        return false;
+    };
+
+    ASSERT_FALSE(_lessdb.flush());
+    ASSERT_EQ(1, _lessdb.combinedBytes());
+}
+
+TEST_F(DatabaseTest, Checkpoint)
+{
+    static constexpr uint32_t PAGE_SIZE = 16;
+
+    class Sink : public DataSink
+    {
+        public:
+        bool write(const uint8_t* data, size_t size) override
+        {
+            _data.insert(_data.end(), data, data + size);
+            return true;
+        }
+
+        std::vector<uint8_t> _data = {};
+    };
+
+    Sink base;
+    Sink first;
+    Sink second;
+    Sink empty;
+
+    // tracking not enabled
+    ASSERT_FALSE(_lessdb.checkpoint(base, checkpointType_t::FULL));
+    ASSERT_TRUE(_lessdb.setCheckpointPageSize(PAGE_SIZE));
+
+    // nothing to base incremental checkpoint on
+    ASSERT_FALSE(_lessdb.checkpoint(first));
+    ASSERT_EQ(0, _lessdb.checkpointSequence());
+
+    ASSERT_TRUE(_lessdb.update(0, 5, 0, 0x50));
+    ASSERT_TRUE(_lessdb.checkpoint(base, checkpointType_t::FULL));
+    ASSERT_EQ(1, _lessdb.checkpointSequence());
+    ASSERT_EQ(30 + 8 + _lessdb.currentDatabaseSize() + 4, base._data.size());
+
+    // two changes in the same page and one elsewhere
+    ASSERT_TRUE(_lessdb.update(0, 5, 1, 0x51));
+    ASSERT_TRUE(_lessdb.update(0, 5, 2, 0x52));
+    ASSERT_TRUE(_lessdb.update(1, 0, 3, 0x13));
+    ASSERT_TRUE(_lessdb.checkpoint(first));
+    ASSERT_EQ(2, _lessdb.checkpointSequence());
+    ASSERT_LE(first._data.size(), 30 + (2 * (8 + (2 * PAGE_SIZE))) + 4);
+
+    // changes made with RAM shadow are included once flushed by the checkpoint
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::ENABLE));
+    ASSERT_TRUE(_lessdb.update(0, 3, 0, 0x1234));
+    ASSERT_TRUE(_lessdb.checkpoint(second));
+    ASSERT_TRUE(_lessdb.setShadow(shadowSetting_t::DISABLE));
+    ASSERT_LE(second._data.size(), 30 + (8 + (2 * PAGE_SIZE)) + 4);
+
+    // nothing changed
+    ASSERT_TRUE(_lessdb.checkpoint(empty));
+    ASSERT_EQ(30 + 4, empty._data.size());
+
+    // factory reset, then restore the chain
+    ASSERT_TRUE(_lessdb.initData());
+    ASSERT_EQ(DEFAULT_VALUES[5], _lessdb.read(0, 5, 0));
+
+    // incremental checkpoints need their base
+    ASSERT_TRUE(_lessdb.setCheckpointPageSize(PAGE_SIZE));
+    ASSERT_FALSE(_lessdb.restore(first._data.data(), first._data.size()));
+
+    ASSERT_TRUE(_lessdb.restore(base._data.data(), base._data.size()));
+    ASSERT_EQ(1, _lessdb.checkpointSequence());
+    ASSERT_EQ(0x50, _lessdb.read(0, 5, 0));
+    ASSERT_EQ(DEFAULT_VALUES[5], _lessdb.read(0, 5, 1));
+
+    // out of order
+    ASSERT_FALSE(_lessdb.restore(second._data.data(), second._data.size()));
+
+    // corrupted
+    first._data[40] ^= 0xFF;
+    ASSERT_FALSE(_lessdb.restore(first._data.data(), first._data.size()));
+    first._data[40] ^= 0xFF;
+
+    ASSERT_TRUE(_lessdb.restore(first._data.data(), first._data.size()));
+    ASSERT_TRUE(_lessdb.restore(second._data.data(), second._data.size()));
+    ASSERT_TRUE(_lessdb.restore(empty._data.data(), empty._data.size()));
+    ASSERT_EQ(4, _lessdb.checkpointSequence());
+
+    ASSERT_EQ(0x50, _lessdb.read(0, 5, 0));
+    ASSERT_EQ(0x51, _lessdb.read(0, 5, 1));
+    ASSERT_EQ(0x52, _lessdb.read(0, 5, 2));
+    ASSERT_EQ(DEFAULT_VALUES[5], _lessdb.read(0, 5, 3));
+    ASSERT_EQ(0x13, _lessdb.read(1, 0, 3));
+    ASSERT_EQ(0x1234, _lessdb.read(0, 3, 0));
+
+    // restoring doesn't count as a change
+    Sink next;
+
+    ASSERT_TRUE(_lessdb.checkpoint(next));
+    ASSERT_EQ(30 + 4, next._data.size());
+
+    // checkpoint of different layout
+    ASSERT_TRUE(_lessdb.setLayout(DB_LAYOUT, 100));
+    ASSERT_FALSE(_lessdb.restore(base._data.data(), base._data.size()));
+}
+
+TEST_F(DatabaseTest, ImageExport)
+{
+    class Sink : public DataSink
+    {
+        public:
+        bool write(const uint8_t* data, size_t size) override
+        {
+            _data.insert(_data.end(), data, data + size);
+            return true;
+        }
+
+        std::vector<uint8_t> _data = {};
+    };
+
+    // database at defaults is stored as a single run
+    Sink defaults;
+
+    ASSERT_TRUE(_lessdb.exportImage(defaults));
+    ASSERT_LE(defaults._data.size(), 13 + 3 + 4);
+
+    for (size_t i = 0; i < SECTION_PARAMS[5]; i++)
+    {
+        ASSERT_TRUE(_lessdb.update(0, 5, i, 0x77));
+    }
+
+    ASSERT_TRUE(_lessdb.update(0, 0, 2, 0));
+    ASSERT_TRUE(_lessdb.update(0, 3, 4, 0x1234));
+    ASSERT_TRUE(_lessdb.update(1, 0, 9, 0x99));
+    ASSERT_TRUE(_lessdb.update(0, 1, 3, 0x42));
+
+    Sink image;
+
+    ASSERT_TRUE(_lessdb.exportImage(image));
+    ASSERT_LT(image._data.size() * 10, _lessdb.currentDatabaseSize());
+
+    // reset and import with range writes
+    ASSERT_TRUE(_lessdb.initData());
+    ASSERT_EQ(DEFAULT_VALUES[5], _lessdb.read(0, 5, 0));
+
+    _hwa._rangeAccess = true;
+    _hwa.resetCounters();
+
+    ASSERT_TRUE(_lessdb.importImage(image._data.data(), image._data.size()));
+    ASSERT_EQ(0, _hwa._writeCount);
+    ASSERT_NE(0, _hwa._writeRangeCount);
+
+    for (size_t i = 0; i < SECTION_PARAMS[5]; i++)
+    {
+        ASSERT_EQ(0x77, _lessdb.read(0, 5, i));
+    }
+
+    ASSERT_EQ(0, _lessdb.read(0, 0, 2));
+    ASSERT_EQ(DEFAULT_VALUES[0], _lessdb.read(0, 0, 1));
+    ASSERT_EQ(0x1234, _lessdb.read(0, 3, 4));
+    ASSERT_EQ(DEFAULT_VALUES[3], _lessdb.read(0, 3, 3));
+    ASSERT_EQ(0x99, _lessdb.read(1, 0, 9));
+    ASSERT_EQ(0x42, _lessdb.read(0, 1, 3));
+    ASSERT_EQ(DEFAULT_VALUES[1] + 4, _lessdb.read(0, 1, 4));
+
+    // imported database exports to the same image
+    Sink reexported;
+
+    ASSERT_TRUE(_lessdb.exportImage(reexported));
+    ASSERT_EQ(image._data, reexported._data);
+
+    // corrupted or truncated image isn't applied
+    ASSERT_TRUE(_lessdb.initData());
+
+    image._data[15] ^= 0xFF;
+    ASSERT_FALSE(_lessdb.importImage(image._data.data(), image._data.size()));
+    image._data[15] ^= 0xFF;
+
+    ASSERT_FALSE(_lessdb.importImage(image._data.data(), image._data.size() - 1));
+    ASSERT_EQ(DEFAULT_VALUES[5], _lessdb.read(0, 5, 0));
+
+    // imported bytes are read back with deferred verification
+    ASSERT_TRUE(_lessdb.setVerifyPolicy(verifyPolicy_t::DEFERRED));
+    _hwa._rangeAccess   = false;
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value ^ 0x01, type);
+    };
+
+    ASSERT_FALSE(_lessdb.importImage(image._data.data(), image._data.size()));
+
+    _hwa._writeCallback = [this](uint32_t address, uint32_t value, sectionParameterType_t type)
+    {
+        return _hwa.memoryWrite(address, value, type);
+    };
+
+    ASSERT_TRUE(_lessdb.importImage(image._data.data(), image._data.size()));
+    ASSERT_TRUE(_lessdb.verify());
+    ASSERT_EQ(0x77, _lessdb.read(0, 5, 0));
+
+    // image of different layout
+    ASSERT_TRUE(_lessdb.setLayout(DB_LAYOUT, 100));
+    ASSERT_FALSE(_lessdb.importImage(image._data.data(), image._data.size()));
+}
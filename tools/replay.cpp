@@ -0,0 +1,342 @@
+/*
+    Copyright 2017-2020 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+    IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string.h>
+#include <unistd.h>
+#include "lib/lessdb/hwa_flash.h"
+#include "lib/lessdb/hwa_mmap.h"
+#include "lib/lessdb/hwa_trace.h"
+
+using namespace lib::lessdb;
+
+namespace
+{
+    /// Flash page size used by flash backend.
+    constexpr size_t FLASH_PAGE_SIZE = 4096;
+
+    size_t width(sectionParameterType_t type)
+    {
+        switch (type)
+        {
+        case sectionParameterType_t::WORD:
+            return 2;
+
+        case sectionParameterType_t::DWORD:
+            return 4;
+
+        default:
+            return 1;
+        }
+    }
+
+    /// Storage kept entirely in RAM.
+    class HwaRam : public Hwa
+    {
+        public:
+        HwaRam(uint32_t size)
+            : _memory(size, 0)
+        {}
+
+        bool init() override
+        {
+            return true;
+        }
+
+        uint32_t size() override
+        {
+            return _memory.size();
+        }
+
+        bool clear() override
+        {
+            std::fill(_memory.begin(), _memory.end(), 0);
+            return true;
+        }
+
+        bool read(uint32_t address, uint32_t& value, sectionParameterType_t type) override
+        {
+            if ((address + width(type)) > _memory.size())
+            {
+                return false;
+            }
+
+            value = 0;
+
+            for (size_t i = 0; i < width(type); i++)
+            {
+                value |= static_cast<uint32_t>(_memory[address + i]) << (8 * i);
+            }
+
+            return true;
+        }
+
+        bool write(uint32_t address, uint32_t value, sectionParameterType_t type) override
+        {
+            if ((address + width(type)) > _memory.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < width(type); i++)
+            {
+                _memory[address + i] = value >> (8 * i);
+            }
+
+            return true;
+        }
+
+        bool rangeAccessSupported() override
+        {
+            return true;
+        }
+
+        bool readRange(uint32_t address, uint8_t* buffer, size_t size) override
+        {
+            if ((address + size) > _memory.size())
+            {
+                return false;
+            }
+
+            memcpy(buffer, &_memory[address], size);
+            return true;
+        }
+
+        bool writeRange(uint32_t address, const uint8_t* buffer, size_t size) override
+        {
+            if ((address + size) > _memory.size())
+            {
+                return false;
+            }
+
+            memcpy(&_memory[address], buffer, size);
+            return true;
+        }
+
+        private:
+        std::vector<uint8_t> _memory;
+    };
+
+    /// Storage kept in a file which is accessed with a system call for every transaction.
+    class HwaFile : public Hwa
+    {
+        public:
+        HwaFile(const std::string& path, uint32_t size)
+            : PATH(path)
+            , SIZE(size)
+        {}
+
+        ~HwaFile()
+        {
+            if (_fd >= 0)
+            {
+                close(_fd);
+            }
+        }
+
+        bool init() override
+        {
+            if (_fd < 0)
+            {
+                _fd = open(PATH.c_str(), O_RDWR | O_CREAT, 0644);
+            }
+
+            return (_fd >= 0) && (ftruncate(_fd, SIZE) == 0);
+        }
+
+        uint32_t size() override
+        {
+            return SIZE;
+        }
+
+        bool clear() override
+        {
+            return (ftruncate(_fd, 0) == 0) && (ftruncate(_fd, SIZE) == 0);
+        }
+
+        bool read(uint32_t address, uint32_t& value, sectionParameterType_t type) override
+        {
+            uint8_t buffer[4] = {};
+
+            if (!readRange(address, buffer, width(type)))
+            {
+                return false;
+            }
+
+            value = 0;
+
+            for (size_t i = 0; i < width(type); i++)
+            {
+                value |= static_cast<uint32_t>(buffer[i]) << (8 * i);
+            }
+
+            return true;
+        }
+
+        bool write(uint32_t address, uint32_t value, sectionParameterType_t type) override
+        {
+            uint8_t buffer[4];
+
+            for (size_t i = 0; i < width(type); i++)
+            {
+                buffer[i] = value >> (8 * i);
+            }
+
+            return writeRange(address, buffer, width(type));
+        }
+
+        bool rangeAccessSupported() override
+        {
+            return true;
+        }
+
+        bool readRange(uint32_t address, uint8_t* buffer, size_t size) override
+        {
+            return ((address + size) <= SIZE) && (pread(_fd, buffer, size, address) == static_cast<ssize_t>(size));
+        }
+
+        bool writeRange(uint32_t address, const uint8_t* buffer, size_t size) override
+        {
+            return ((address + size) <= SIZE) && (pwrite(_fd, buffer, size, address) == static_cast<ssize_t>(size));
+        }
+
+        private:
+        const std::string PATH;
+        const uint32_t    SIZE;
+        int               _fd = -1;
+    };
+
+    void usage()
+    {
+        std::cerr << "Usage: liblessdb-replay <trace> <ram|file|mmap|flash> [storage path]" << std::endl;
+    }
+}    // namespace
+
+/// Replays recorded trace on selected backend and reports throughput and transaction counts.
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        usage();
+        return 1;
+    }
+
+    std::ifstream        file(argv[1], std::ios::binary);
+    std::vector<uint8_t> trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    uint32_t             storageSize;
+
+    if (!file || !TraceReplay::storageSize(trace.data(), trace.size(), storageSize))
+    {
+        std::cerr << "Invalid trace: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const std::string BACKEND = argv[2];
+    const std::string PATH    = argc > 3 ? argv[3] : "liblessdb-replay.bin";
+
+    std::unique_ptr<RamFlashPages> pages;
+    std::unique_ptr<Hwa>           hwa;
+
+    if (BACKEND == "ram")
+    {
+        hwa = std::make_unique<HwaRam>(storageSize);
+    }
+    else if (BACKEND == "file")
+    {
+        hwa = std::make_unique<HwaFile>(PATH, storageSize);
+    }
+    else if (BACKEND == "mmap")
+    {
+        hwa = std::make_unique<HwaMmap>(PATH, storageSize, msyncPolicy_t::OS);
+    }
+    else if (BACKEND == "flash")
+    {
+        // records take twice the size of data, with spare pages for compaction
+        const size_t PAGES = ((storageSize * 2) / FLASH_PAGE_SIZE) + 4;
+
+        pages = std::make_unique<RamFlashPages>(FLASH_PAGE_SIZE, PAGES);
+        hwa   = std::make_unique<HwaFlash>(*pages, storageSize);
+    }
+    else
+    {
+        usage();
+        return 1;
+    }
+
+    // traced storage might not have been initialized in the trace
+    if (!hwa->init())
+    {
+        std::cerr << "Failed to initialize " << BACKEND << " backend" << std::endl;
+        return 1;
+    }
+
+    ReplayResult result;
+
+    const auto START    = std::chrono::steady_clock::now();
+    const bool COMPLETE = TraceReplay::replay(trace.data(), trace.size(), *hwa, result);
+    const auto ELAPSED  = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
+
+    static const char* const NAMES[] = { "init", "clear", "read", "write", "readRange", "writeRange" };
+
+    uint64_t operations = 0;
+
+    for (size_t i = 0; i < static_cast<size_t>(traceOperation_t::AMOUNT); i++)
+    {
+        std::cout << NAMES[i] << ": " << result.operations[i] << std::endl;
+        operations += result.operations[i];
+    }
+
+    std::cout << "operations: " << operations << std::endl;
+    std::cout << "bytes read: " << result.bytesRead << std::endl;
+    std::cout << "bytes written: " << result.bytesWritten << std::endl;
+    std::cout << "failures: " << result.failures << std::endl;
+    std::cout << "mismatches: " << result.mismatches << std::endl;
+    std::cout << "elapsed ns: " << ELAPSED << std::endl;
+    std::cout << "ns/op: " << (operations ? (ELAPSED / operations) : 0) << std::endl;
+    std::cout << "traced us: " << result.tracedUs << std::endl;
+
+    if (pages != nullptr)
+    {
+        uint64_t erases = 0;
+
+        for (size_t page = 0; page < pages->numberOfPages(); page++)
+        {
+            erases += pages->eraseCount(page);
+        }
+
+        std::cout << "flash erases: " << erases << std::endl;
+        std::cout << "flash compactions: " << static_cast<HwaFlash*>(hwa.get())->compactions() << std::endl;
+    }
+
+    if (!COMPLETE)
+    {
+        std::cerr << "Trace is truncated or malformed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}